@@ -0,0 +1,42 @@
+#ifndef V_CAMERA_H
+#define V_CAMERA_H
+
+#include "v_transform.h"
+#include "v_vector.h"
+
+// Viewpoint in world space. right, down and forward are the view-space x, y
+// and z axes in world coordinates: x to the right of the screen, y down it
+// and z into it, as render_mesh expects view space. They stay unit length
+// and at right angles to each other.
+typedef struct {
+  vec3_t pos;
+  vec3_t right, down, forward;
+  fix16_t fov;  // vertical field of view, 256 per turn, see v_tan
+  fix16_t near; // > 0, faces are cut at this view-space depth
+} camera_t;
+
+// At pos looking down +z with world y down the screen
+void camera_init(camera_t *cam, vec3_t pos, fix16_t fov, fix16_t near);
+
+// Turns by yaw about y, then pitch about x, in the same order and units as
+// entity rotations
+void camera_set_angles(camera_t *cam, fix16_t yaw, fix16_t pitch);
+
+// Turns to face target, rolled so that up (world space, any length) points
+// to the top of the screen. Leaves the orientation as it was when target is
+// at pos or straight along up.
+void camera_look_at(camera_t *cam, vec3_t target, vec3_t up);
+
+// Moves along the camera's own axes
+void camera_move(camera_t *cam, fix16_t right, fix16_t down, fix16_t forward);
+
+// Rigid transform from world space to view space. Multiply each entity's
+// model matrix onto it once (mat34_mul) and its vertices go straight to
+// view space with a single product each.
+void camera_view(const camera_t *cam, mat34_t *world_to_view);
+
+// Pinhole projection of fov over a width x height pixel viewport, centred:
+// focal = height / 2 / tan(fov / 2)
+void camera_projection(const camera_t *cam, int width, int height, projection_t *proj);
+
+#endif
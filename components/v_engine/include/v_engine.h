@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "v_config.h"
+#include "v_fixed.h"
 
 typedef enum {
   RENDER_WIRE = 0,
@@ -10,13 +12,36 @@ typedef enum {
   RENDER_BOTH
 } render_mode_t;
 
+// on_update runs at a fixed V_TICK_HZ, zero or more times per frame, and
+// always gets ENGINE_TICK_DT. on_draw runs once per frame and should draw
+// the state engine_get_alpha() of the way between the last two ticks, see
+// entity_lerp_pos.
 typedef struct {
   void (*on_load)(void);
-  void (*on_update)(float dt);
+  void (*on_update)(fix16_t dt);
   void (*on_draw)(render_mode_t mode);
 } game_config_t;
 
-void engine_start(game_config_t *config);
+#define ENGINE_TICK_DT (F16_ONE / V_TICK_HZ) // Seconds per tick, Q16.16 rounded down
+
+typedef struct {
+  uint32_t frames;
+  uint32_t ticks;
+  uint32_t ticks_dropped; // backlog beyond V_MAX_TICKS_PER_FRAME that was never simulated
+  int64_t present_us;     // timer_get_us() when the last frame was handed to the display
+} engine_stats_t;
+
+void engine_start(game_config_t *config); // init + run frames forever
+
+void engine_init(game_config_t *config); // Brings up display, input and timer, then calls on_load
+
+// Runs the ticks that are due, draws and presents one frame, then with
+// V_TARGET_FPS sleeps whatever is left of the frame's budget
+void engine_step(void);
+
+fix16_t engine_get_alpha(void); // Q16.16 in [0, 1), how far the current frame is past the last tick
+const engine_stats_t *engine_get_stats(void);
+
 void engine_set_mode(render_mode_t mode);
 
 #endif
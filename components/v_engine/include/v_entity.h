@@ -1,16 +1,95 @@
 #ifndef V_ENTITY_H
 #define V_ENTITY_H
 
+#include "v_config.h"
 #include "v_mesh.h"
+#include "v_transform.h"
 #include "v_vector.h"
 #include <stdbool.h>
+#include <stdint.h>
 
-typedef struct{
-  vec3_t pos;
-  vec3_t rot;
-  const mesh_t *mesh;
-  uint16_t color;
-  bool active;
-} entity_t;
+// Handle to an entity: slot in the low 16 bits, the slot's generation in the
+// high 16. A destroyed entity's handle goes stale instead of aliasing
+// whatever reuses the slot. 0 is never a live handle.
+typedef uint32_t entity_id_t;
+
+#define ENTITY_NONE 0
+
+// Live entities packed at [0, count) as parallel arrays, in no particular
+// order. Destroying one moves the last entity into its place, so dense
+// indices are only stable until the next create or destroy; hold on to
+// entity_id_t and look it up with entity_index() instead.
+typedef struct {
+  int count;                            // read-only, use entity_create/destroy
+  vec3_t pos[V_MAX_ENTITIES];
+  vec3_t rot[V_MAX_ENTITIES];           // 256 per turn, see v_sin
+  quat_t orient[V_MAX_ENTITIES];        // turns it instead of rot unless all zero, see entity_set_orient
+  const mesh_t *mesh[V_MAX_ENTITIES];
+  const mesh_lod_t *lod[V_MAX_ENTITIES]; // NULL draws mesh at every distance, see entity_set_lod
+  uint8_t lod_level[V_MAX_ENTITIES];     // level drawn last, render_mesh_lod keeps it
+  uint16_t color[V_MAX_ENTITIES];
+  entity_id_t id[V_MAX_ENTITIES];       // read-only, handle of each dense entry
+  vec3_t prev_pos[V_MAX_ENTITIES];      // pos and rot before the last tick, see entity_snapshot
+  vec3_t prev_rot[V_MAX_ENTITIES];
+  quat_t prev_orient[V_MAX_ENTITIES];
+} entity_store_t;
+
+extern entity_store_t entities;
+
+void entity_clear(void); // Destroys every entity, all outstanding handles go stale
+
+// Zero rotation. ENTITY_NONE when all V_MAX_ENTITIES are live.
+entity_id_t entity_create(const mesh_t *mesh, vec3_t pos, uint16_t color);
+
+bool entity_destroy(entity_id_t id); // false if the handle was already stale
+
+// Draws the entity through a level-of-detail chain, NULL goes back to its
+// mesh alone. mesh becomes lod->levels[0], which the grid takes its extent
+// from. false if the handle is stale.
+bool entity_set_lod(entity_id_t id, const mesh_lod_t *lod);
+
+// Turns the entity by the quaternion q from now on instead of its Euler rot,
+// so it can be stepped with quat_rotate without whole-unit angles. prev_orient
+// is set too, nothing is interpolated from the old rotation. A zero q goes
+// back to rot. false if the handle is stale.
+bool entity_set_orient(entity_id_t id, quat_t q);
+
+int entity_index(entity_id_t id); // Dense index into entities, -1 if stale
+
+// Copies pos and rot into prev_pos and prev_rot. The engine calls it before
+// every fixed update; a moved entity that should not be smeared across the
+// jump (a teleport) gets its prev_pos set as well.
+void entity_snapshot(void);
+
+// pos and rot drawn alpha (Q16.16, [0, 1)) of the way from the previous
+// tick to the current one. Rotation takes the short way round the turn.
+vec3_t entity_lerp_pos(int n, fix16_t alpha);
+vec3_t entity_lerp_rot(int n, fix16_t alpha);
+quat_t entity_lerp_orient(int n, fix16_t alpha); // quat_slerp of prev_orient and orient, exact if equal
+
+// Re-buckets entities in the spatial grid after their positions or meshes
+// changed. Only those that crossed into another cell get relinked; created
+// entities are in the grid straight away.
+void entity_sync_grid(void);
+
+// Spatial queries over the positions as of the last entity_sync_grid().
+// Each writes at most max_out dense indices to out and returns how many.
+// Box and radius select exactly on pos; the frustum query returns every
+// entity whose mesh bounds may be visible, with world space placed in view
+// space by view.
+int entity_query_box(vec3_t min, vec3_t max, uint16_t *out, int max_out);
+int entity_query_radius(vec3_t center, fix16_t radius, uint16_t *out, int max_out);
+int entity_query_frustum(const frustum_t *f, const mat34_t *view, uint16_t *out, int max_out);
+
+static inline bool entity_alive(entity_id_t id)
+{
+  return entity_index(id) >= 0;
+}
+
+static inline bool entity_has_orient(int n)
+{
+  quat_t q = entities.orient[n];
+  return (q.w | q.x | q.y | q.z) != 0;
+}
 
 #endif
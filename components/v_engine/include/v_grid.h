@@ -0,0 +1,55 @@
+#ifndef V_GRID_H
+#define V_GRID_H
+
+#include <stdint.h>
+#include "v_transform.h"
+#include "v_vector.h"
+
+// Loose uniform grid over item positions. Each item is linked into the cell
+// holding its position; cells are 1 << cell_shift Q16.16 units on a side so
+// bucketing is a shift. Items outside the grid, or reaching further than
+// margin from their position, go on an overflow list that every query
+// visits. The caller owns the storage, so one grid can index the entity
+// store and another thousands of bench items.
+
+#define GRID_NONE 0xFFFF
+
+typedef struct {
+  vec3_t pos;
+  uint16_t next, prev;
+  uint16_t cell; // GRID_NONE when not inserted
+  uint16_t wide; // extent over margin, kept on the overflow list
+} grid_item_t;
+
+typedef struct {
+  vec3_t origin;   // min corner of cell (0, 0, 0)
+  int cell_shift;
+  int dim[3];
+  fix16_t margin;  // how far an item may reach past its position
+  uint16_t *heads; // [dim[0] * dim[1] * dim[2]]
+  uint16_t overflow;
+  grid_item_t *items;
+  int capacity;    // below GRID_NONE, as is the cell count
+  int top;         // one past the highest item index inserted since the clear
+  int linked;      // items in cells, not on the overflow list
+} grid_t;
+
+void grid_init(grid_t *g, vec3_t origin, int cell_shift, int nx, int ny, int nz, fix16_t margin,
+               uint16_t *heads, grid_item_t *items, int capacity);
+void grid_clear(grid_t *g);
+
+// extent is how far the item reaches from pos, the bounding radius
+void grid_insert(grid_t *g, int item, vec3_t pos, fix16_t extent);
+void grid_remove(grid_t *g, int item);
+void grid_move(grid_t *g, int item, vec3_t pos); // Relinks only when the cell changes
+
+// Queries write at most max_out item indices to out and return how many.
+// Box and radius are exact on the item positions. The frustum query is
+// conservative: every item whose extent may be visible through f, with the
+// grid placed in view space by the rigid transform view. While few items
+// sit in cells it tests them one by one instead of walking the cells.
+int grid_query_box(const grid_t *g, vec3_t min, vec3_t max, uint16_t *out, int max_out);
+int grid_query_radius(const grid_t *g, vec3_t center, fix16_t radius, uint16_t *out, int max_out);
+int grid_query_frustum(const grid_t *g, const frustum_t *f, const mat34_t *view, uint16_t *out, int max_out);
+
+#endif
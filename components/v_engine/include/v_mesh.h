@@ -1,17 +1,112 @@
 #ifndef V_MESH_H
 #define V_MESH_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "v_config.h"
+#include "v_graphics.h"
 #include "v_vector.h"
 
+#define MESH_NO_EDGE 0xFFFF
+
 typedef struct {
+  // Exactly one of these is set. Binary meshes keep int16 positions with
+  // position = offset + q * scale, read them through mesh_vertex().
   const vec3_t *vertices;
+  const int16_t (*qvertices)[3];
+  vec3_t scale;
+  vec3_t offset;
   int num_vertices;
 
-  const int (*faces)[3];
+  // uint8_t indices, or uint16_t when wide_indices is set, see mesh_face()
+  const void *faces; // [num_faces][3]
   int num_faces;
 
-  const int (*edges)[2];
+  const void *edges; // [num_edges][2]
   int num_edges;
+
+  // Optional, the edges of each face as indices into edges, in the order
+  // v0-v1, v1-v2, v2-v0. MESH_NO_EDGE marks sides that are not in the list,
+  // like the diagonal of a quad. Lets the wireframe skip hidden edges; NULL
+  // draws every edge.
+  const uint16_t (*face_edges)[3];
+
+  bool wide_indices;
+
+  // Optional, one per face with the normal pointing out of the visible side.
+  // NULL makes the renderer derive them from the vertices every frame.
+  const plane_t *planes;
+
+  // Optional, one unit normal per vertex. With a render_view_t light the
+  // renderer lights each vertex once and Gouraud shades the faces between
+  // them; NULL keeps the flat, per-face shading.
+  const vec3_t *normals;
+
+  // Optional texture mapping: one (u, v) per vertex as Q16.16 fractions of
+  // the texture size, wrapping outside [0, 1). Faces that meet at a seam need
+  // their own vertices. With both set the faces are textured and take no
+  // lighting.
+  const fix16_t (*uvs)[2];
+  const gfx_texture_t *texture;
+
+  // Object space bounds for frustum culling. radius 0 means unknown and the
+  // mesh is never culled; an empty box (min == max) skips the box refinement.
+  vec3_t center;
+  fix16_t radius;
+  vec3_t box_min, box_max;
 } mesh_t;
 
+// Level-of-detail chain, finest first. Level k takes over once the
+// camera-space depth passes switch_z[k] (switch_z[0] is unused) and hands
+// back only when the depth is hysteresis nearer than that, so an object
+// sitting on a threshold does not flicker between levels. Coarser levels
+// should fit within the bounds of levels[0].
+typedef struct {
+  const mesh_t *levels[V_MAX_LODS];
+  fix16_t switch_z[V_MAX_LODS]; // ascending
+  int num_levels;
+  fix16_t hysteresis;
+} mesh_lod_t;
+
+// Level to draw at depth z given the one drawn last time
+static inline int mesh_lod_select(const mesh_lod_t *lod, int current, fix16_t z)
+{
+  int level = current < lod->num_levels ? current : 0;
+  while(level + 1 < lod->num_levels && z > lod->switch_z[level + 1])
+    level++;
+  while(level > 0 && z < lod->switch_z[level] - lod->hysteresis)
+    level--;
+  return level;
+}
+
+static inline vec3_t mesh_vertex(const mesh_t *mesh, int i)
+{
+  if(mesh->qvertices)
+  {
+    const int16_t *q = mesh->qvertices[i];
+    return (vec3_t){ mesh->offset.x + q[0] * mesh->scale.x,
+                     mesh->offset.y + q[1] * mesh->scale.y,
+                     mesh->offset.z + q[2] * mesh->scale.z };
+  }
+  return mesh->vertices[i];
+}
+
+static inline int mesh_index(const mesh_t *mesh, const void *list, int i)
+{
+  return mesh->wide_indices ? ((const uint16_t *)list)[i] : ((const uint8_t *)list)[i];
+}
+
+static inline void mesh_face(const mesh_t *mesh, int face, int idx[3])
+{
+  idx[0] = mesh_index(mesh, mesh->faces, face * 3);
+  idx[1] = mesh_index(mesh, mesh->faces, face * 3 + 1);
+  idx[2] = mesh_index(mesh, mesh->faces, face * 3 + 2);
+}
+
+static inline void mesh_edge(const mesh_t *mesh, int edge, int idx[2])
+{
+  idx[0] = mesh_index(mesh, mesh->edges, edge * 2);
+  idx[1] = mesh_index(mesh, mesh->edges, edge * 2 + 1);
+}
+
 #endif
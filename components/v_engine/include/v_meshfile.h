@@ -0,0 +1,64 @@
+#ifndef V_MESHFILE_H
+#define V_MESHFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "v_mesh.h"
+
+// Binary mesh pack, little-endian, built by host/tools/obj2mesh.
+// A pack is a header, a directory of named entries and the mesh blobs.
+// Every offset is 4-byte aligned so the blobs are used in place, straight
+// from memory-mapped flash.
+
+#define MESH_PACK_MAGIC   0x4B415056u // "VPAK"
+#define MESH_FILE_MAGIC   0x48534D56u // "VMSH"
+#define MESH_FILE_VERSION 4
+#define MESH_NAME_LEN     16
+
+#define MESH_FILE_WIDE_INDICES (1 << 0) // uint16_t indices instead of uint8_t
+#define MESH_FILE_PLANES       (1 << 1) // plane_t per face
+#define MESH_FILE_EDGES        (1 << 2) // unique edge list and per-face edge indices for wireframe
+#define MESH_FILE_NORMALS      (1 << 3) // unit vec3_t per vertex for Gouraud shading
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+} mesh_pack_header_t;
+
+typedef struct {
+  char name[MESH_NAME_LEN]; // NUL padded
+  uint32_t offset;          // from the start of the pack
+  uint32_t size;
+} mesh_pack_entry_t;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t flags;
+  uint16_t num_vertices;
+  uint16_t num_faces;
+  uint16_t num_edges;
+  uint16_t reserved;
+  fix16_t scale[3];   // position = offset + q * scale
+  fix16_t offset[3];
+  fix16_t center[3];  // bounding sphere
+  fix16_t radius;
+  fix16_t box_min[3]; // bounding box of the dequantized positions
+  fix16_t box_max[3];
+  uint32_t vertices;  // int16_t[num_vertices][3], byte offset from this header
+  uint32_t faces;     // [num_faces][3] indices
+  uint32_t edges;     // [num_edges][2] indices, 0 without MESH_FILE_EDGES
+  uint32_t planes;    // plane_t[num_faces], 0 without MESH_FILE_PLANES
+  uint32_t face_edges; // uint16_t[num_faces][3], 0 without MESH_FILE_EDGES
+  uint32_t normals;    // vec3_t[num_vertices], 0 without MESH_FILE_NORMALS
+} mesh_file_header_t;
+
+// Points mesh at a single mesh blob without copying anything. Checks the
+// magic, version, bounds and every index, false leaves mesh untouched.
+bool mesh_file_bind(mesh_t *mesh, const void *data, size_t size);
+
+// Looks name up in a pack and binds it
+bool mesh_pack_find(const void *pack, size_t size, const char *name, mesh_t *mesh);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef V_PROFILE_H
+#define V_PROFILE_H
+
+#include <stdint.h>
+#include "v_config.h"
+
+// Per-frame stage profiler. Stages are timed with the cycle counter and
+// summed over the frame, so one can be entered many times (once per mesh).
+// Every finished frame lands in a ring of V_PROFILE_FRAMES records together
+// with its triangle, pixel and SPI byte counts. With V_PROFILE 0 the macros
+// expand to nothing and none of this is compiled in.
+
+typedef enum {
+  PROF_UPDATE,    // on_update
+  PROF_CLEAR,     // colour and depth clears
+  PROF_TRANSFORM, // culling, back faces and vertex transform in render_mesh
+  PROF_RASTER,    // face and edge drawing, plus band replay in strip mode
+  PROF_PRESENT,   // display_present without its waits and band rendering
+  PROF_SPI_WAIT,  // blocked on the display transport
+  PROF_STAGES
+} profile_stage_t;
+
+typedef struct {
+  uint32_t frame;
+  uint32_t total_cycles;               // frame begin to end, see timer_get_cycles
+  uint32_t stage_cycles[PROF_STAGES];
+  uint32_t triangles;                  // faces drawn by render_mesh
+  uint32_t lod_saved;                  // faces coarser levels of detail stood in for
+  uint32_t pixels;                     // see gfx_pixels_rasterized
+  uint32_t bytes;                      // sent to the panel
+} profile_frame_t;
+
+#if V_PROFILE
+
+void profile_frame_begin(void);
+void profile_frame_end(void);
+void profile_stage_begin(profile_stage_t stage);
+void profile_stage_end(profile_stage_t stage);
+
+int profile_get_frames(profile_frame_t *out, int max); // Oldest first, returns how many
+void profile_dump_csv(void); // Header plus one line per recorded frame on stdout, times in us
+
+#define PROFILE_FRAME_BEGIN()  profile_frame_begin()
+#define PROFILE_FRAME_END()    profile_frame_end()
+#define PROFILE_BEGIN(stage)   profile_stage_begin(stage)
+#define PROFILE_END(stage)     profile_stage_end(stage)
+#define PROFILE_DUMP_CSV()     profile_dump_csv()
+
+#else
+
+#define PROFILE_FRAME_BEGIN()  ((void)0)
+#define PROFILE_FRAME_END()    ((void)0)
+#define PROFILE_BEGIN(stage)   ((void)0)
+#define PROFILE_END(stage)     ((void)0)
+#define PROFILE_DUMP_CSV()     ((void)0)
+
+#endif
+
+#endif
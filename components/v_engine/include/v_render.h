@@ -0,0 +1,85 @@
+#ifndef V_RENDER_H
+#define V_RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "v_config.h"
+#include "v_engine.h"
+#include "v_mesh.h"
+#include "v_quat.h"
+#include "v_transform.h"
+
+// Picks the colour of a visible face from its unit normal in view space
+typedef uint16_t (*render_shade_t)(uint16_t color, vec3_t normal);
+
+// Intensity (Q16.16, [0, 1]) of a vertex from its unit normal in view space
+typedef fix16_t (*render_light_t)(vec3_t normal);
+
+typedef struct {
+  projection_t proj;
+  render_shade_t shade; // NULL fills faces with the flat entity colour
+  render_light_t light; // Gouraud shades meshes with vertex normals, NULL after render_view_init
+  frustum_t frustum;    // derived from proj by render_view_init
+  render_mode_t mode;   // RENDER_SOLID after render_view_init
+  uint16_t edge_color;  // edges over faces in RENDER_BOTH, V_BLACK after render_view_init
+} render_view_t;
+
+typedef struct {
+  uint32_t entities_drawn;
+  uint32_t entities_culled;   // bounds entirely outside the frustum, no vertex touched
+  uint32_t faces_drawn;
+  uint32_t faces_clipped;     // drawn after cutting them in view space, see render_mesh
+  uint32_t edges_drawn;
+  uint32_t faces_culled;      // back faces rejected in object space, before projection
+  uint32_t verts_transformed;
+  uint32_t verts_skipped;     // only referenced by culled faces, never projected
+  uint32_t lod_coarse;        // entities render_mesh_lod drew below their finest level
+  uint32_t lod_faces_saved;   // faces of the finest levels those stood in for
+  uint32_t cache_hits;        // objects render_cache_replay drew without transforming them
+  uint32_t cache_misses;
+  uint32_t cache_evictions;   // entries dropped for space, least recently used first, never one drawn this frame
+} render_stats_t;
+
+void render_begin_frame(void); // Clears the per-frame stats, engine_step calls it before on_draw
+
+// Sets up a view over the whole screen
+void render_view_init(render_view_t *view, const projection_t *proj, render_shade_t shade);
+
+// Culls, projects and fills mesh placed in view space by model (rotation +
+// translation, camera at the origin looking down +z). Meshes whose bounds miss
+// the frustum are dropped up front, ones fully inside skip all clipping.
+// Faces crossing the near plane are cut there instead of being dropped, as
+// are faces with a corner projecting past PROJECT_LIMIT.
+// With view->light and mesh->normals the used vertices are lit once and the
+// faces filled with gfx_fill_triangle_shaded, view->shade is not called.
+// A mesh with uvs and a texture is texture mapped instead, unlit.
+// RENDER_WIRE and RENDER_BOTH draw each edge of the front faces once, in the
+// entity colour or view->edge_color. Meshes without an edge list draw solid.
+void render_mesh(const render_view_t *view, const mesh_t *mesh, const mat34_t *model, uint16_t color);
+
+// render_mesh with the level of lod for the depth of model's origin. level
+// keeps the caller's per-object state for the hysteresis, start it at 0.
+void render_mesh_lod(const render_view_t *view, const mesh_lod_t *lod, uint8_t *level, const mat34_t *model,
+                     uint16_t color);
+
+#if V_RENDER_CACHE_BYTES
+// Transform cache. An object (key, e.g. an entity id) drawn at the same
+// placement frame after frame keeps its projected vertices, visible faces
+// and their colours in an arena of V_RENDER_CACHE_BYTES, and is redrawn
+// from there without building its model matrix or touching a vertex.
+// render_cache_begin starts a frame; a changed view or camera invalidates
+// everything. render_cache_replay then draws key if mesh, color and
+// placement (pos and rot or orient, as the caller builds model from them;
+// orient is all zero when rot is used) match what was cached, or returns
+// false for the caller to render_mesh it as usual.
+// Only placements seen twice in a row are stored, so moving objects cost a
+// lookup and no arena space.
+void render_cache_begin(const render_view_t *view, const mat34_t *world_to_view);
+bool render_cache_replay(const render_view_t *view, uint32_t key, const mesh_t *mesh, vec3_t pos, vec3_t rot,
+                         quat_t orient, uint16_t color);
+void render_cache_clear(void); // Drops every entry, e.g. after meshes were unloaded
+#endif
+
+render_stats_t render_get_stats(void); // Totals since render_begin_frame
+
+#endif
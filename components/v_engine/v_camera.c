@@ -0,0 +1,67 @@
+#include "v_camera.h"
+
+void camera_init(camera_t *cam, vec3_t pos, fix16_t fov, fix16_t near)
+{
+  cam->pos = pos;
+  cam->right = (vec3_t){ F16_ONE, 0, 0 };
+  cam->down = (vec3_t){ 0, F16_ONE, 0 };
+  cam->forward = (vec3_t){ 0, 0, F16_ONE };
+  cam->fov = fov;
+  cam->near = near;
+}
+
+void camera_set_angles(camera_t *cam, fix16_t yaw, fix16_t pitch)
+{
+  // Columns of rotate_y(yaw) * rotate_x(pitch)
+  fix16_t cy = v_cos(yaw), sy = v_sin(yaw);
+  fix16_t cp = v_cos(pitch), sp = v_sin(pitch);
+  cam->right = (vec3_t){ cy, 0, -sy };
+  cam->down = (vec3_t){ f16_mul(sy, sp), cp, f16_mul(cy, sp) };
+  cam->forward = (vec3_t){ f16_mul(sy, cp), -sp, f16_mul(cy, cp) };
+}
+
+void camera_look_at(camera_t *cam, vec3_t target, vec3_t up)
+{
+  vec3_t dir = vec3_sub(target, cam->pos);
+  if(!dir.x && !dir.y && !dir.z)
+    return;
+  vec3_t forward = vec3_normalize(dir);
+
+  // right = down x forward, with down the opposite of up
+  vec3_t right = vec3_cross(vec3_normalize((vec3_t){ -up.x, -up.y, -up.z }), forward);
+  if(!right.x && !right.y && !right.z)
+    return;
+  right = vec3_normalize(right);
+
+  cam->forward = forward;
+  cam->right = right;
+  cam->down = vec3_cross(forward, right);
+}
+
+void camera_move(camera_t *cam, fix16_t right, fix16_t down, fix16_t forward)
+{
+  cam->pos = vec3_add(cam->pos, vec3_mul(cam->right, right));
+  cam->pos = vec3_add(cam->pos, vec3_mul(cam->down, down));
+  cam->pos = vec3_add(cam->pos, vec3_mul(cam->forward, forward));
+}
+
+void camera_view(const camera_t *cam, mat34_t *world_to_view)
+{
+  // The axes are the rows of the inverse rotation, the translation takes pos to the origin
+  const vec3_t *axis[3] = { &cam->right, &cam->down, &cam->forward };
+  for(int r = 0; r < 3; r++)
+  {
+    world_to_view->m[r][0] = axis[r]->x;
+    world_to_view->m[r][1] = axis[r]->y;
+    world_to_view->m[r][2] = axis[r]->z;
+    world_to_view->m[r][3] = -vec3_dot(*axis[r], cam->pos);
+  }
+}
+
+void camera_projection(const camera_t *cam, int width, int height, projection_t *proj)
+{
+  proj->focal = f16_div(INT_TO_F16(height) / 2, v_tan(cam->fov / 2));
+  proj->cx = INT_TO_F16(width) / 2;
+  proj->cy = INT_TO_F16(height) / 2;
+  proj->near = cam->near;
+}
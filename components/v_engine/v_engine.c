@@ -1,46 +1,154 @@
 #include "v_engine.h"
 #include "v_display.h"
+#include "v_entity.h"
+#include "v_render.h"
 #include "v_input.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "esp_timer.h"
+#include "v_profile.h"
+#include "v_timer.h"
 
-static render_mode_t current_mode = RENDER_WIRE;
+// The accumulator counts microseconds times V_TICK_HZ, so a tick is exactly
+// one second's worth and no rounding builds up between the clock and ticks
+#define TICK_UNITS 1000000
+
+static render_mode_t current_mode = RENDER_SOLID;
+
+static game_config_t *active_config;
+static int64_t last_time = 0;
+static int64_t accumulator = 0;
+static fix16_t alpha = 0;
+static engine_stats_t stats;
+
+#if V_TARGET_FPS
+// Deadlines count from pace_origin so they stay exact at any frame rate
+static int64_t pace_origin;
+static uint32_t pace_frames;
+#endif
 
 void engine_set_mode(render_mode_t mode)
 {
   current_mode = mode;
 }
 
-void engine_start(game_config_t *config)
+fix16_t engine_get_alpha(void)
+{
+  return alpha;
+}
+
+const engine_stats_t *engine_get_stats(void)
+{
+  return &stats;
+}
+
+void engine_init(game_config_t *config)
 {
+  active_config = config;
+
+  timer_init();
   display_init();
   input_init();
 
   if(config->on_load) config->on_load();
 
-  int64_t last_time = esp_timer_get_time();
+  last_time = timer_get_us();
+  accumulator = TICK_UNITS; // the first frame draws the first tick
+  stats = (engine_stats_t){0};
+#if V_TARGET_FPS
+  pace_origin = last_time;
+  pace_frames = 0;
+#endif
+}
 
-  while(1)
+#if V_TARGET_FPS
+static void pace_frame(void)
+{
+  pace_frames++;
+  int64_t deadline = pace_origin + ((int64_t)pace_frames * 1000000 + V_TARGET_FPS - 1) / V_TARGET_FPS;
+  int64_t now = timer_get_us();
+
+  if(now < deadline)
+    timer_sleep_us(deadline - now);
+  else if(now - deadline > 1000000 / V_TARGET_FPS)
   {
-    int64_t current_time = esp_timer_get_time();
-    float dt = (float)(current_time - last_time) / 1000000.0f;
-    last_time = current_time;
+    // More than a frame late: start a new schedule rather than rushing the
+    // next frames out back to back
+    pace_origin = now;
+    pace_frames = 0;
+  }
+}
+#endif
+
+void engine_step(void)
+{
+  game_config_t *config = active_config;
+
+  int64_t current_time = timer_get_us();
+  accumulator += (current_time - last_time) * V_TICK_HZ;
+  last_time = current_time;
 
-    if(dt > 0.1f)
-      dt = 0.1f;
+  PROFILE_FRAME_BEGIN();
 
+  PROFILE_BEGIN(PROF_UPDATE);
+  int ticks = 0;
+  while(accumulator >= TICK_UNITS && ticks < V_MAX_TICKS_PER_FRAME)
+  {
+    entity_snapshot();
     if(config->on_update)
-    {
-      config->on_update(dt); // 60FPS
-    }
+      config->on_update(ENGINE_TICK_DT);
+    accumulator -= TICK_UNITS;
+    ticks++;
+  }
+  PROFILE_END(PROF_UPDATE);
+
+  // Frame skip: an overloaded frame runs at most V_MAX_TICKS_PER_FRAME and
+  // the rest of the backlog is dropped, so slow frames cannot snowball into
+  // ever more ticks per frame. The game runs slow instead.
+  if(accumulator >= TICK_UNITS)
+  {
+    stats.ticks_dropped += (uint32_t)(accumulator / TICK_UNITS);
+    accumulator %= TICK_UNITS;
+  }
+  stats.ticks += ticks;
+  alpha = (fix16_t)((accumulator << F16_SHIFT) / TICK_UNITS);
+
+  if(config->on_draw)
+  {
+    render_begin_frame();
+    config->on_draw(current_mode);
+  }
+
+  PROFILE_BEGIN(PROF_PRESENT);
+  display_present();
+  PROFILE_END(PROF_PRESENT);
+
+  PROFILE_FRAME_END();
+  stats.frames++;
+  stats.present_us = timer_get_us();
+
+#if V_TARGET_FPS
+  pace_frame();
+#endif
+}
+
+void engine_start(game_config_t *config)
+{
+  engine_init(config);
+
+  int64_t last_yield = timer_get_us();
+  for(uint32_t frame = 1;; frame++)
+  {
+    engine_step();
 
-    if(config->on_draw)
+    // Pacing sleeps shorter than a scheduler tick only spin, so the idle
+    // task still needs a tick now and then for the task watchdog
+    if(timer_get_us() - last_yield >= V_YIELD_MS * 1000)
     {
-      config->on_draw(current_mode);
+      timer_yield();
+      last_yield = timer_get_us();
     }
 
-    display_draw();
-    vTaskDelay(1);
+    // No host to ask for it on the device, so the ring goes out whenever it
+    // has filled up again
+    if(V_PROFILE && frame % V_PROFILE_FRAMES == 0)
+      PROFILE_DUMP_CSV();
   }
 }
@@ -0,0 +1,226 @@
+#include "v_entity.h"
+#include "v_grid.h"
+#include <string.h>
+
+#define SLOT_NONE 0xFFFF
+
+entity_store_t entities;
+
+// Per slot: the dense index while live, the next free slot while free
+static uint16_t slot_link[V_MAX_ENTITIES];
+static uint16_t slot_gen[V_MAX_ENTITIES];
+static uint16_t free_head = SLOT_NONE;
+static bool initialised;
+
+// Grid items are slots, which stay put while dense indices move
+static grid_t grid;
+static uint16_t grid_heads[V_GRID_DIM_X * V_GRID_DIM_Y * V_GRID_DIM_Z];
+static grid_item_t grid_items[V_MAX_ENTITIES];
+static const mesh_t *grid_mesh[V_MAX_ENTITIES]; // mesh the extent was taken from
+
+// How far the mesh reaches from the entity position in any rotation
+static fix16_t mesh_extent(const mesh_t *mesh)
+{
+  if(!mesh || !mesh->radius)
+    return INT32_MAX;
+  return f16_add(mesh->radius, vec3_length(mesh->center));
+}
+
+void entity_clear(void)
+{
+  // Bump the generation of every slot that was handed out so old handles
+  // stay stale across a clear
+  for(int i = 0; i < V_MAX_ENTITIES; i++)
+  {
+    if(!initialised || ++slot_gen[i] == 0)
+      slot_gen[i] = 1;
+    slot_link[i] = (uint16_t)(i + 1 < V_MAX_ENTITIES ? i + 1 : SLOT_NONE);
+  }
+  free_head = 0;
+  entities.count = 0;
+  initialised = true;
+
+  vec3_t origin = { -(V_GRID_DIM_X << V_GRID_CELL_SHIFT) / 2, -(V_GRID_DIM_Y << V_GRID_CELL_SHIFT) / 2,
+                    -(V_GRID_DIM_Z << V_GRID_CELL_SHIFT) / 2 };
+  grid_init(&grid, origin, V_GRID_CELL_SHIFT, V_GRID_DIM_X, V_GRID_DIM_Y, V_GRID_DIM_Z, V_GRID_MARGIN,
+            grid_heads, grid_items, V_MAX_ENTITIES);
+}
+
+entity_id_t entity_create(const mesh_t *mesh, vec3_t pos, uint16_t color)
+{
+  if(!initialised)
+    entity_clear();
+  if(free_head == SLOT_NONE)
+    return ENTITY_NONE;
+
+  uint16_t slot = free_head;
+  free_head = slot_link[slot];
+
+  int n = entities.count++;
+  entity_id_t id = ((entity_id_t)slot_gen[slot] << 16) | slot;
+  slot_link[slot] = (uint16_t)n;
+
+  entities.pos[n] = pos;
+  entities.rot[n] = (vec3_t){0, 0, 0};
+  entities.prev_pos[n] = pos;
+  entities.prev_rot[n] = (vec3_t){0, 0, 0};
+  entities.orient[n] = (quat_t){0, 0, 0, 0};
+  entities.prev_orient[n] = (quat_t){0, 0, 0, 0};
+  entities.mesh[n] = mesh;
+  entities.lod[n] = NULL;
+  entities.lod_level[n] = 0;
+  entities.color[n] = color;
+  entities.id[n] = id;
+
+  grid_insert(&grid, slot, pos, mesh_extent(mesh));
+  grid_mesh[slot] = mesh;
+  return id;
+}
+
+int entity_index(entity_id_t id)
+{
+  uint32_t slot = id & 0xFFFF;
+  if(slot >= V_MAX_ENTITIES || id >> 16 == 0 || slot_gen[slot] != id >> 16)
+    return -1;
+  return slot_link[slot];
+}
+
+bool entity_destroy(entity_id_t id)
+{
+  int n = entity_index(id);
+  if(n < 0)
+    return false;
+
+  uint16_t slot = id & 0xFFFF;
+  grid_remove(&grid, slot);
+  if(++slot_gen[slot] == 0)
+    slot_gen[slot] = 1;
+  slot_link[slot] = free_head;
+  free_head = slot;
+
+  // Keep the live range packed by moving the last entity into the hole
+  int last = --entities.count;
+  if(n != last)
+  {
+    entities.pos[n] = entities.pos[last];
+    entities.rot[n] = entities.rot[last];
+    entities.mesh[n] = entities.mesh[last];
+    entities.lod[n] = entities.lod[last];
+    entities.lod_level[n] = entities.lod_level[last];
+    entities.color[n] = entities.color[last];
+    entities.id[n] = entities.id[last];
+    entities.prev_pos[n] = entities.prev_pos[last];
+    entities.prev_rot[n] = entities.prev_rot[last];
+    entities.orient[n] = entities.orient[last];
+    entities.prev_orient[n] = entities.prev_orient[last];
+    slot_link[entities.id[n] & 0xFFFF] = (uint16_t)n;
+  }
+  return true;
+}
+
+bool entity_set_lod(entity_id_t id, const mesh_lod_t *lod)
+{
+  int n = entity_index(id);
+  if(n < 0)
+    return false;
+  entities.lod[n] = lod;
+  entities.lod_level[n] = 0;
+  if(lod)
+    entities.mesh[n] = lod->levels[0]; // entity_sync_grid picks up the new extent
+  return true;
+}
+
+bool entity_set_orient(entity_id_t id, quat_t q)
+{
+  int n = entity_index(id);
+  if(n < 0)
+    return false;
+  entities.orient[n] = q;
+  entities.prev_orient[n] = q;
+  return true;
+}
+
+void entity_snapshot(void)
+{
+  memcpy(entities.prev_pos, entities.pos, entities.count * sizeof(vec3_t));
+  memcpy(entities.prev_rot, entities.rot, entities.count * sizeof(vec3_t));
+  memcpy(entities.prev_orient, entities.orient, entities.count * sizeof(quat_t));
+}
+
+static fix16_t lerp(fix16_t a, fix16_t b, fix16_t alpha)
+{
+  return f16_add(a, f16_mul(f16_sub(b, a), alpha));
+}
+
+// Angles are 256 per turn, wrap the difference into [-128, 128)
+static fix16_t lerp_angle(fix16_t a, fix16_t b, fix16_t alpha)
+{
+  fix16_t d = ((f16_sub(b, a) + 128) & 255) - 128;
+  return f16_add(a, f16_mul(d, alpha));
+}
+
+vec3_t entity_lerp_pos(int n, fix16_t alpha)
+{
+  vec3_t a = entities.prev_pos[n], b = entities.pos[n];
+  return (vec3_t){ lerp(a.x, b.x, alpha), lerp(a.y, b.y, alpha), lerp(a.z, b.z, alpha) };
+}
+
+vec3_t entity_lerp_rot(int n, fix16_t alpha)
+{
+  vec3_t a = entities.prev_rot[n], b = entities.rot[n];
+  return (vec3_t){ lerp_angle(a.x, b.x, alpha), lerp_angle(a.y, b.y, alpha), lerp_angle(a.z, b.z, alpha) };
+}
+
+quat_t entity_lerp_orient(int n, fix16_t alpha)
+{
+  // An orientation that did not change comes back bit for bit, whatever
+  // alpha is, so the transform cache can recognise it
+  quat_t a = entities.prev_orient[n], b = entities.orient[n];
+  if(a.w == b.w && a.x == b.x && a.y == b.y && a.z == b.z)
+    return b;
+  return quat_slerp(a, b, alpha);
+}
+
+void entity_sync_grid(void)
+{
+  for(int n = 0; n < entities.count; n++)
+  {
+    uint16_t slot = entities.id[n] & 0xFFFF;
+    if(entities.mesh[n] != grid_mesh[slot])
+    {
+      grid_insert(&grid, slot, entities.pos[n], mesh_extent(entities.mesh[n]));
+      grid_mesh[slot] = entities.mesh[n];
+    }
+    else
+      grid_move(&grid, slot, entities.pos[n]);
+  }
+}
+
+// The grid answers in slots, callers index the dense arrays
+static int slots_to_dense(uint16_t *out, int n)
+{
+  for(int k = 0; k < n; k++)
+    out[k] = slot_link[out[k]];
+  return n;
+}
+
+int entity_query_box(vec3_t min, vec3_t max, uint16_t *out, int max_out)
+{
+  if(!initialised)
+    return 0;
+  return slots_to_dense(out, grid_query_box(&grid, min, max, out, max_out));
+}
+
+int entity_query_radius(vec3_t center, fix16_t radius, uint16_t *out, int max_out)
+{
+  if(!initialised)
+    return 0;
+  return slots_to_dense(out, grid_query_radius(&grid, center, radius, out, max_out));
+}
+
+int entity_query_frustum(const frustum_t *f, const mat34_t *view, uint16_t *out, int max_out)
+{
+  if(!initialised)
+    return 0;
+  return slots_to_dense(out, grid_query_frustum(&grid, f, view, out, max_out));
+}
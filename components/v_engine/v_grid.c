@@ -0,0 +1,274 @@
+#include "v_grid.h"
+#include <stdbool.h>
+
+#define CELL_OVERFLOW 0xFFFE
+
+// Below one linked item per this many cells the frustum query tests items
+// directly, walking the blocks costs more than the sphere tests it saves
+#define FRUSTUM_CELLS_PER_ITEM 4
+
+void grid_init(grid_t *g, vec3_t origin, int cell_shift, int nx, int ny, int nz, fix16_t margin,
+               uint16_t *heads, grid_item_t *items, int capacity)
+{
+  g->origin = origin;
+  g->cell_shift = cell_shift;
+  g->dim[0] = nx;
+  g->dim[1] = ny;
+  g->dim[2] = nz;
+  g->margin = margin;
+  g->heads = heads;
+  g->items = items;
+  g->capacity = capacity;
+  grid_clear(g);
+}
+
+void grid_clear(grid_t *g)
+{
+  int cells = g->dim[0] * g->dim[1] * g->dim[2];
+  for(int c = 0; c < cells; c++)
+    g->heads[c] = GRID_NONE;
+  g->overflow = GRID_NONE;
+  g->top = 0;
+  g->linked = 0;
+  for(int i = 0; i < g->capacity; i++)
+    g->items[i].cell = GRID_NONE;
+}
+
+// Cell coordinate along one axis, negative or >= dim when outside
+static int cell_coord(const grid_t *g, fix16_t p, fix16_t origin)
+{
+  return (int)(((int64_t)p - origin) >> g->cell_shift);
+}
+
+static uint16_t cell_of(const grid_t *g, vec3_t pos)
+{
+  int cx = cell_coord(g, pos.x, g->origin.x);
+  int cy = cell_coord(g, pos.y, g->origin.y);
+  int cz = cell_coord(g, pos.z, g->origin.z);
+  if((unsigned)cx >= (unsigned)g->dim[0] || (unsigned)cy >= (unsigned)g->dim[1] ||
+     (unsigned)cz >= (unsigned)g->dim[2])
+    return CELL_OVERFLOW;
+  return (uint16_t)((cz * g->dim[1] + cy) * g->dim[0] + cx);
+}
+
+static uint16_t *list_head(grid_t *g, uint16_t cell)
+{
+  return cell == CELL_OVERFLOW ? &g->overflow : &g->heads[cell];
+}
+
+static void link_item(grid_t *g, int item, uint16_t cell)
+{
+  grid_item_t *it = &g->items[item];
+  uint16_t *head = list_head(g, cell);
+  it->cell = cell;
+  it->prev = GRID_NONE;
+  it->next = *head;
+  if(*head != GRID_NONE)
+    g->items[*head].prev = (uint16_t)item;
+  *head = (uint16_t)item;
+  if(cell != CELL_OVERFLOW)
+    g->linked++;
+}
+
+static void unlink_item(grid_t *g, int item)
+{
+  grid_item_t *it = &g->items[item];
+  if(it->prev != GRID_NONE)
+    g->items[it->prev].next = it->next;
+  else
+    *list_head(g, it->cell) = it->next;
+  if(it->next != GRID_NONE)
+    g->items[it->next].prev = it->prev;
+  if(it->cell != CELL_OVERFLOW)
+    g->linked--;
+  it->cell = GRID_NONE;
+}
+
+void grid_insert(grid_t *g, int item, vec3_t pos, fix16_t extent)
+{
+  grid_item_t *it = &g->items[item];
+  if(it->cell != GRID_NONE)
+    unlink_item(g, item);
+  it->pos = pos;
+  it->wide = extent > g->margin;
+  if(item >= g->top)
+    g->top = item + 1;
+  link_item(g, item, it->wide ? CELL_OVERFLOW : cell_of(g, pos));
+}
+
+void grid_remove(grid_t *g, int item)
+{
+  if(g->items[item].cell != GRID_NONE)
+    unlink_item(g, item);
+}
+
+void grid_move(grid_t *g, int item, vec3_t pos)
+{
+  grid_item_t *it = &g->items[item];
+  it->pos = pos;
+  if(it->wide || it->cell == GRID_NONE)
+    return;
+
+  uint16_t cell = cell_of(g, pos);
+  if(cell != it->cell)
+  {
+    unlink_item(g, item);
+    link_item(g, item, cell);
+  }
+}
+
+static bool in_box(vec3_t p, vec3_t min, vec3_t max)
+{
+  return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y &&
+         p.z >= min.z && p.z <= max.z;
+}
+
+// Walks one cell list, or the overflow list, keeping the items in the box
+static int collect_box(const grid_t *g, uint16_t head, vec3_t min, vec3_t max, uint16_t *out, int n, int max_out)
+{
+  for(uint16_t i = head; i != GRID_NONE && n < max_out; i = g->items[i].next)
+  {
+    if(in_box(g->items[i].pos, min, max))
+      out[n++] = i;
+  }
+  return n;
+}
+
+// Cells overlapping [min, max] as inclusive ranges, false when none do
+static bool cell_range(const grid_t *g, vec3_t min, vec3_t max, int lo[3], int hi[3])
+{
+  fix16_t mn[3] = { min.x, min.y, min.z }, mx[3] = { max.x, max.y, max.z };
+  fix16_t o[3] = { g->origin.x, g->origin.y, g->origin.z };
+  for(int a = 0; a < 3; a++)
+  {
+    lo[a] = cell_coord(g, mn[a], o[a]);
+    hi[a] = cell_coord(g, mx[a], o[a]);
+    if(lo[a] < 0) lo[a] = 0;
+    if(hi[a] >= g->dim[a]) hi[a] = g->dim[a] - 1;
+    if(lo[a] > hi[a])
+      return false;
+  }
+  return true;
+}
+
+int grid_query_box(const grid_t *g, vec3_t min, vec3_t max, uint16_t *out, int max_out)
+{
+  int n = collect_box(g, g->overflow, min, max, out, 0, max_out);
+
+  int lo[3], hi[3];
+  if(!cell_range(g, min, max, lo, hi))
+    return n;
+
+  for(int z = lo[2]; z <= hi[2]; z++)
+  {
+    for(int y = lo[1]; y <= hi[1]; y++)
+    {
+      const uint16_t *row = &g->heads[(z * g->dim[1] + y) * g->dim[0]];
+      for(int x = lo[0]; x <= hi[0]; x++)
+        n = collect_box(g, row[x], min, max, out, n, max_out);
+    }
+  }
+  return n;
+}
+
+int grid_query_radius(const grid_t *g, vec3_t center, fix16_t radius, uint16_t *out, int max_out)
+{
+  vec3_t r = { radius, radius, radius };
+  int n = grid_query_box(g, vec3_sub(center, r), vec3_add(center, r), out, max_out);
+
+  // The box already bounds every offset by radius, so the squares fit
+  int64_t r2 = (int64_t)radius * radius;
+  int kept = 0;
+  for(int k = 0; k < n; k++)
+  {
+    vec3_t p = g->items[out[k]].pos;
+    int64_t dx = p.x - center.x, dy = p.y - center.y, dz = p.z - center.z;
+    if(dx * dx + dy * dy + dz * dz <= r2)
+      out[kept++] = out[k];
+  }
+  return kept;
+}
+
+static int collect_all(const grid_t *g, const int lo[3], const int hi[3], uint16_t *out, int n, int max_out)
+{
+  for(int z = lo[2]; z <= hi[2]; z++)
+  {
+    for(int y = lo[1]; y <= hi[1]; y++)
+    {
+      const uint16_t *row = &g->heads[(z * g->dim[1] + y) * g->dim[0]];
+      for(int x = lo[0]; x <= hi[0]; x++)
+      {
+        for(uint16_t i = row[x]; i != GRID_NONE && n < max_out; i = g->items[i].next)
+          out[n++] = i;
+      }
+    }
+  }
+  return n;
+}
+
+// Tests the block of cells [lo, hi] grown by the margin, halving it along
+// its longest side while it straddles the frustum. f is in grid space.
+static int visit_frustum(const grid_t *g, const frustum_t *f, int lo[3], int hi[3], uint16_t *out, int n,
+                         int max_out)
+{
+  if(n >= max_out)
+    return n;
+
+  // Most single cells on the frustum boundary are empty, skip their test
+  bool single = lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2];
+  if(single && g->heads[(lo[2] * g->dim[1] + lo[1]) * g->dim[0] + lo[0]] == GRID_NONE)
+    return n;
+
+  fix16_t m = g->margin;
+  vec3_t min = { g->origin.x + (lo[0] << g->cell_shift) - m, g->origin.y + (lo[1] << g->cell_shift) - m,
+                 g->origin.z + (lo[2] << g->cell_shift) - m };
+  vec3_t max = { g->origin.x + ((hi[0] + 1) << g->cell_shift) + m,
+                 g->origin.y + ((hi[1] + 1) << g->cell_shift) + m,
+                 g->origin.z + ((hi[2] + 1) << g->cell_shift) + m };
+
+  cull_t cull = frustum_test_aabb(f, min, max);
+  if(cull == CULL_OUTSIDE)
+    return n;
+
+  int axis = 0;
+  for(int a = 1; a < 3; a++)
+  {
+    if(hi[a] - lo[a] > hi[axis] - lo[axis])
+      axis = a;
+  }
+  if(cull == CULL_INSIDE || single)
+    return collect_all(g, lo, hi, out, n, max_out);
+
+  int mid = (lo[axis] + hi[axis]) / 2;
+  int split_hi[3] = { hi[0], hi[1], hi[2] }, split_lo[3] = { lo[0], lo[1], lo[2] };
+  split_hi[axis] = mid;
+  split_lo[axis] = mid + 1;
+  n = visit_frustum(g, f, lo, split_hi, out, n, max_out);
+  return visit_frustum(g, f, split_lo, hi, out, n, max_out);
+}
+
+int grid_query_frustum(const grid_t *g, const frustum_t *f, const mat34_t *view, uint16_t *out, int max_out)
+{
+  int n = 0;
+  for(uint16_t i = g->overflow; i != GRID_NONE && n < max_out; i = g->items[i].next)
+    out[n++] = i;
+
+  // Items in cells reach at most margin from their position
+  int cells = g->dim[0] * g->dim[1] * g->dim[2];
+  if(g->linked * FRUSTUM_CELLS_PER_ITEM < cells)
+  {
+    for(int i = 0; i < g->top && n < max_out; i++)
+    {
+      const grid_item_t *it = &g->items[i];
+      if(it->cell != GRID_NONE && it->cell != CELL_OVERFLOW &&
+         frustum_test_sphere(f, mat34_transform(view, it->pos), g->margin) != CULL_OUTSIDE)
+        out[n++] = (uint16_t)i;
+    }
+    return n;
+  }
+
+  frustum_t local;
+  frustum_to_object(&local, f, view);
+  int lo[3] = { 0, 0, 0 }, hi[3] = { g->dim[0] - 1, g->dim[1] - 1, g->dim[2] - 1 };
+  return visit_frustum(g, &local, lo, hi, out, n, max_out);
+}
@@ -0,0 +1,103 @@
+#include "v_meshfile.h"
+#include <string.h>
+
+// Offset and length of one section fit inside the blob and are aligned
+static bool section_ok(size_t size, uint32_t offset, size_t bytes)
+{
+  return offset % 4 == 0 && offset <= size && bytes <= size - offset;
+}
+
+static bool indices_ok(const mesh_t *mesh, const void *list, int count)
+{
+  for(int i = 0; i < count; i++)
+  {
+    if(mesh_index(mesh, list, i) >= mesh->num_vertices)
+      return false;
+  }
+  return true;
+}
+
+bool mesh_file_bind(mesh_t *mesh, const void *data, size_t size)
+{
+  const mesh_file_header_t *h = data;
+  if(!data || (uintptr_t)data % 4 || size < sizeof(*h))
+    return false;
+  if(h->magic != MESH_FILE_MAGIC || h->version != MESH_FILE_VERSION)
+    return false;
+
+  bool wide = h->flags & MESH_FILE_WIDE_INDICES;
+  size_t index_size = wide ? sizeof(uint16_t) : sizeof(uint8_t);
+
+  if(!section_ok(size, h->vertices, (size_t)h->num_vertices * 3 * sizeof(int16_t)))
+    return false;
+  if(!section_ok(size, h->faces, (size_t)h->num_faces * 3 * index_size))
+    return false;
+  if((h->flags & MESH_FILE_EDGES) && !section_ok(size, h->edges, (size_t)h->num_edges * 2 * index_size))
+    return false;
+  if((h->flags & MESH_FILE_EDGES) && !section_ok(size, h->face_edges, (size_t)h->num_faces * 3 * sizeof(uint16_t)))
+    return false;
+  if((h->flags & MESH_FILE_PLANES) && !section_ok(size, h->planes, (size_t)h->num_faces * sizeof(plane_t)))
+    return false;
+  if((h->flags & MESH_FILE_NORMALS) && !section_ok(size, h->normals, (size_t)h->num_vertices * sizeof(vec3_t)))
+    return false;
+
+  const uint8_t *base = data;
+  mesh_t m = {
+    .qvertices = (const int16_t (*)[3])(base + h->vertices),
+    .scale = { h->scale[0], h->scale[1], h->scale[2] },
+    .offset = { h->offset[0], h->offset[1], h->offset[2] },
+    .center = { h->center[0], h->center[1], h->center[2] },
+    .radius = h->radius,
+    .box_min = { h->box_min[0], h->box_min[1], h->box_min[2] },
+    .box_max = { h->box_max[0], h->box_max[1], h->box_max[2] },
+    .num_vertices = h->num_vertices,
+    .faces = base + h->faces,
+    .num_faces = h->num_faces,
+    .wide_indices = wide,
+  };
+  if(h->flags & MESH_FILE_EDGES)
+  {
+    m.edges = base + h->edges;
+    m.num_edges = h->num_edges;
+    m.face_edges = (const uint16_t (*)[3])(base + h->face_edges);
+  }
+  if(h->flags & MESH_FILE_PLANES)
+    m.planes = (const plane_t *)(base + h->planes);
+  if(h->flags & MESH_FILE_NORMALS)
+    m.normals = (const vec3_t *)(base + h->normals);
+
+  if(!indices_ok(&m, m.faces, m.num_faces * 3) || !indices_ok(&m, m.edges, m.num_edges * 2))
+    return false;
+  for(int f = 0; m.face_edges && f < m.num_faces; f++)
+  {
+    for(int k = 0; k < 3; k++)
+    {
+      if(m.face_edges[f][k] != MESH_NO_EDGE && m.face_edges[f][k] >= m.num_edges)
+        return false;
+    }
+  }
+
+  *mesh = m;
+  return true;
+}
+
+bool mesh_pack_find(const void *pack, size_t size, const char *name, mesh_t *mesh)
+{
+  const mesh_pack_header_t *h = pack;
+  if(!pack || size < sizeof(*h) || h->magic != MESH_PACK_MAGIC || h->version != MESH_FILE_VERSION)
+    return false;
+  if(h->count > (size - sizeof(*h)) / sizeof(mesh_pack_entry_t))
+    return false;
+
+  const mesh_pack_entry_t *entries = (const mesh_pack_entry_t *)(h + 1);
+  for(int i = 0; i < h->count; i++)
+  {
+    const mesh_pack_entry_t *e = &entries[i];
+    if(strncmp(e->name, name, MESH_NAME_LEN) != 0)
+      continue;
+    if(e->offset > size || e->size > size - e->offset)
+      return false;
+    return mesh_file_bind(mesh, (const uint8_t *)pack + e->offset, e->size);
+  }
+  return false;
+}
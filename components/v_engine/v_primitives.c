@@ -8,21 +8,43 @@ static const vec3_t cube_verts[8] = {
     { INT_TO_F16( 1), INT_TO_F16( 1), INT_TO_F16(-1) }, { INT_TO_F16(-1), INT_TO_F16( 1), INT_TO_F16(-1) }  
 };
 
-static const int cube_faces[12][3] = {
+static const uint8_t cube_faces[12][3] = {
     {0, 1, 2}, {0, 2, 3}, {5, 4, 7}, {5, 7, 6},
     {4, 0, 3}, {4, 3, 7}, {1, 5, 6}, {1, 6, 2},
     {3, 2, 6}, {3, 6, 7}, {4, 5, 1}, {4, 1, 0}  
 };
 
-static const int cube_edges[12][2] = {
+static const uint8_t cube_edges[12][2] = {
     {0,1}, {1,2}, {2,3}, {3,0}, {4,5}, {5,6}, 
     {6,7}, {7,4}, {0,4}, {1,5}, {2,6}, {3,7} 
 };
 
+// Quad diagonals are not in the edge list
+#define N MESH_NO_EDGE
+static const uint16_t cube_face_edges[12][3] = {
+    {0, 1, N}, {N, 2, 3}, {4, 7, N}, {N, 6, 5},
+    {8, 3, N}, {N, 11, 7}, {9, 5, N}, {N, 10, 1},
+    {2, 10, N}, {N, 6, 11}, {4, 9, N}, {N, 0, 8}
+};
+
+static const plane_t cube_planes[12] = {
+    {{ 0, 0, INT_TO_F16( 1) }, INT_TO_F16(-1)}, {{ 0, 0, INT_TO_F16( 1) }, INT_TO_F16(-1)},
+    {{ 0, 0, INT_TO_F16(-1) }, INT_TO_F16(-1)}, {{ 0, 0, INT_TO_F16(-1) }, INT_TO_F16(-1)},
+    {{ INT_TO_F16(-1), 0, 0 }, INT_TO_F16(-1)}, {{ INT_TO_F16(-1), 0, 0 }, INT_TO_F16(-1)},
+    {{ INT_TO_F16( 1), 0, 0 }, INT_TO_F16(-1)}, {{ INT_TO_F16( 1), 0, 0 }, INT_TO_F16(-1)},
+    {{ 0, INT_TO_F16( 1), 0 }, INT_TO_F16(-1)}, {{ 0, INT_TO_F16( 1), 0 }, INT_TO_F16(-1)},
+    {{ 0, INT_TO_F16(-1), 0 }, INT_TO_F16(-1)}, {{ 0, INT_TO_F16(-1), 0 }, INT_TO_F16(-1)}
+};
+
 const mesh_t MESH_CUBE = {
     .vertices = cube_verts, .num_vertices = 8,
     .faces = cube_faces,    .num_faces = 12,
-    .edges = cube_edges,    .num_edges = 12
+    .edges = cube_edges,    .num_edges = 12,
+    .face_edges = cube_face_edges,
+    .planes = cube_planes,
+    .radius = 113512, // sqrt(3), rounded up
+    .box_min = { INT_TO_F16(-1), INT_TO_F16(-1), INT_TO_F16(-1) },
+    .box_max = { INT_TO_F16( 1), INT_TO_F16( 1), INT_TO_F16( 1) }
 };
 
 static const vec3_t pyr_verts[5] = {
@@ -33,18 +55,37 @@ static const vec3_t pyr_verts[5] = {
     { INT_TO_F16(-1), INT_TO_F16(-1), INT_TO_F16(-1) }  
 };
 
-static const int pyr_faces[6][3] = {
+static const uint8_t pyr_faces[6][3] = {
     {0, 1, 2}, {0, 2, 3}, {0, 3, 4}, {0, 4, 1}, // Sides
     {1, 4, 3}, {1, 3, 2}                        // Base
 };
 
-static const int pyr_edges[8][2] = {
+static const uint8_t pyr_edges[8][2] = {
     {0,1}, {0,2}, {0,3}, {0,4}, // Slopes
     {1,2}, {2,3}, {3,4}, {4,1}  // Base
 };
 
+static const uint16_t pyr_face_edges[6][3] = {
+    {0, 4, 1}, {1, 5, 2}, {2, 6, 3}, {3, 7, 0},
+    {7, 6, N}, {N, 5, 4}
+};
+#undef N
+
+// Side normals are (0, 1, 2) / sqrt(5) turned about y: 29309 = 0.4472, 58617 = 0.8944
+static const plane_t pyr_planes[6] = {
+    {{ 0, 29309, 58617 }, -29309}, {{ 58617, 29309, 0 }, -29309},
+    {{ 0, 29309, -58617 }, -29309}, {{ -58617, 29309, 0 }, -29309},
+    {{ 0, INT_TO_F16(-1), 0 }, INT_TO_F16(-1)}, {{ 0, INT_TO_F16(-1), 0 }, INT_TO_F16(-1)}
+};
+
 const mesh_t MESH_PYRAMID = {
     .vertices = pyr_verts, .num_vertices = 5,
     .faces = pyr_faces,    .num_faces = 6,
-    .edges = pyr_edges,    .num_edges = 8
+    .edges = pyr_edges,    .num_edges = 8,
+    .face_edges = pyr_face_edges,
+    .planes = pyr_planes,
+    // Centred between apex and base, every vertex is 1.5 away
+    .center = { 0, -F16_ONE / 2, 0 }, .radius = F16_ONE * 3 / 2,
+    .box_min = { INT_TO_F16(-1), INT_TO_F16(-1), INT_TO_F16(-1) },
+    .box_max = { INT_TO_F16( 1), INT_TO_F16( 1), INT_TO_F16( 1) }
 };
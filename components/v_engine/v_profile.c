@@ -0,0 +1,111 @@
+#include "v_profile.h"
+
+#if V_PROFILE
+
+#include <stdio.h>
+#include "v_display.h"
+#include "v_graphics.h"
+#include "v_render.h"
+#include "v_timer.h"
+
+static const char *const stage_names[PROF_STAGES] = {
+  "update", "clear", "transform", "raster", "present", "spi_wait",
+};
+
+static profile_frame_t ring[V_PROFILE_FRAMES];
+static int ring_next = 0;
+static int ring_count = 0;
+static uint32_t frame_number = 0;
+
+static profile_frame_t current;
+static uint32_t frame_start;
+static uint32_t stage_start[PROF_STAGES];
+static uint32_t pixels_start;
+
+void profile_frame_begin(void)
+{
+  current = (profile_frame_t){ .frame = frame_number++ };
+  pixels_start = gfx_pixels_rasterized();
+  frame_start = timer_get_cycles();
+}
+
+void profile_stage_begin(profile_stage_t stage)
+{
+  stage_start[stage] = timer_get_cycles();
+}
+
+void profile_stage_end(profile_stage_t stage)
+{
+  current.stage_cycles[stage] += timer_get_cycles() - stage_start[stage];
+}
+
+void profile_frame_end(void)
+{
+  current.total_cycles = timer_get_cycles() - frame_start;
+
+  // display_present times its own waits and band rendering, move them out
+  // of the present stage
+  const display_stats_t *ds = display_get_stats();
+  uint32_t inner = ds->wait_cycles + ds->render_cycles;
+  uint32_t present = current.stage_cycles[PROF_PRESENT];
+  current.stage_cycles[PROF_PRESENT] = present > inner ? present - inner : 0;
+  current.stage_cycles[PROF_SPI_WAIT] += ds->wait_cycles;
+  current.stage_cycles[PROF_RASTER] += ds->render_cycles;
+
+  render_stats_t rs = render_get_stats();
+  current.triangles = rs.faces_drawn;
+  current.lod_saved = rs.lod_faces_saved;
+  current.pixels = gfx_pixels_rasterized() - pixels_start;
+  current.bytes = ds->bytes;
+
+  ring[ring_next] = current;
+  ring_next = (ring_next + 1) % V_PROFILE_FRAMES;
+  if(ring_count < V_PROFILE_FRAMES)
+    ring_count++;
+}
+
+int profile_get_frames(profile_frame_t *out, int max)
+{
+  int n = ring_count < max ? ring_count : max;
+  int first = (ring_next - n + V_PROFILE_FRAMES) % V_PROFILE_FRAMES;
+  for(int i = 0; i < n; i++)
+    out[i] = ring[(first + i) % V_PROFILE_FRAMES];
+  return n;
+}
+
+// Cycles as microseconds with two decimals, no floats in the output path
+static void print_us(uint32_t cycles, uint32_t per_us)
+{
+  uint64_t centi = (uint64_t)cycles * 100 / per_us;
+  printf(",%lu.%02lu", (unsigned long)(centi / 100), (unsigned long)(centi % 100));
+}
+
+void profile_dump_csv(void)
+{
+  uint32_t per_us = timer_cycles_per_us();
+
+  printf("frame,total_us");
+  for(int s = 0; s < PROF_STAGES; s++)
+    printf(",%s_us", stage_names[s]);
+  printf(",other_us,triangles,lod_saved,pixels,bytes\n");
+
+  int first = (ring_next - ring_count + V_PROFILE_FRAMES) % V_PROFILE_FRAMES;
+  for(int i = 0; i < ring_count; i++)
+  {
+    const profile_frame_t *f = &ring[(first + i) % V_PROFILE_FRAMES];
+    uint32_t staged = 0;
+
+    printf("%lu", (unsigned long)f->frame);
+    print_us(f->total_cycles, per_us);
+    for(int s = 0; s < PROF_STAGES; s++)
+    {
+      print_us(f->stage_cycles[s], per_us);
+      staged += f->stage_cycles[s];
+    }
+    print_us(f->total_cycles > staged ? f->total_cycles - staged : 0, per_us);
+    printf(",%lu,%lu,%lu,%lu\n", (unsigned long)f->triangles, (unsigned long)f->lod_saved, (unsigned long)f->pixels,
+           (unsigned long)f->bytes);
+  }
+}
+
+#endif
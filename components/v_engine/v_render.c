@@ -0,0 +1,808 @@
+#include "v_render.h"
+#include "v_graphics.h"
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_profile.h"
+#include <string.h>
+
+static render_stats_t stats;
+
+void render_begin_frame(void)
+{
+  stats = (render_stats_t){0};
+}
+
+render_stats_t render_get_stats(void)
+{
+  return stats;
+}
+
+void render_view_init(render_view_t *view, const projection_t *proj, render_shade_t shade)
+{
+  view->proj = *proj;
+  view->shade = shade;
+  view->light = NULL;
+  view->mode = RENDER_SOLID;
+  view->edge_color = V_BLACK;
+  frustum_from_projection(&view->frustum, proj, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT);
+}
+
+// Per-mesh scratch, static to keep it off the task stack
+static fix16_t vx[V_MAX_MESH_VERTS], vy[V_MAX_MESH_VERTS], vz[V_MAX_MESH_VERTS];
+static fix16_t sx[V_MAX_MESH_VERTS], sy[V_MAX_MESH_VERTS];
+static uint8_t outcode[V_MAX_MESH_VERTS];
+static uint8_t used[V_MAX_MESH_VERTS];
+static uint16_t used_list[V_MAX_MESH_VERTS];
+static vec3_t unpacked[V_MAX_MESH_VERTS]; // dequantized positions of binary meshes
+static fix16_t intensity[V_MAX_MESH_VERTS]; // per-vertex light of Gouraud shaded meshes
+static fix16_t tex_u[V_MAX_MESH_VERTS], tex_v[V_MAX_MESH_VERTS]; // texel coordinates of textured meshes
+static uint16_t visible[V_MAX_MESH_FACES];
+static uint8_t edge_mark[V_MAX_MESH_EDGES];
+
+// Bits to drop so a magnitude from vec3_bound fits in 15 bits
+static inline int fit15(uint32_t bound)
+{
+  return bound >> 15 ? 17 - __builtin_clz(bound) : 0;
+}
+
+// OR of the components' magnitudes, one less for negative ones
+static inline uint32_t vec3_bound(vec3_t v)
+{
+  return (uint32_t)((v.x ^ (v.x >> 31)) | (v.y ^ (v.y >> 31)) | (v.z ^ (v.z >> 31)));
+}
+
+// Outward face normal at an arbitrary scale, for meshes without stored
+// planes. The edges share one shift down to 15 bits, which keeps the cross
+// product's direction however large the face; vec3_normalize rescales it.
+static vec3_t face_normal(const mesh_t *mesh, const int idx[3])
+{
+  vec3_t a = mesh_vertex(mesh, idx[0]);
+  vec3_t e1 = vec3_sub(mesh_vertex(mesh, idx[1]), a);
+  vec3_t e2 = vec3_sub(mesh_vertex(mesh, idx[2]), a);
+  int s = fit15(vec3_bound(e1) | vec3_bound(e2));
+
+  int64_t x1 = e1.x >> s, y1 = e1.y >> s, z1 = e1.z >> s;
+  int64_t x2 = e2.x >> s, y2 = e2.y >> s, z2 = e2.z >> s;
+  // Up to 2^31 each, halved to fit
+  return (vec3_t){ (fix16_t)((y1 * z2 - z1 * y2) >> 1), (fix16_t)((z1 * x2 - x1 * z2) >> 1),
+                   (fix16_t)((x1 * y2 - y1 * x2) >> 1) };
+}
+
+// Whether the eye is in front of the face, for meshes without stored planes.
+// The edges share one shift and the eye vector takes its own; neither
+// changes the sign, and the products then fit int64 at any face size.
+static bool face_front(const mesh_t *mesh, const int idx[3], vec3_t eye)
+{
+  vec3_t a = mesh_vertex(mesh, idx[0]);
+  vec3_t e1 = vec3_sub(mesh_vertex(mesh, idx[1]), a);
+  vec3_t e2 = vec3_sub(mesh_vertex(mesh, idx[2]), a);
+  vec3_t t = vec3_sub(eye, a);
+  int s = fit15(vec3_bound(e1) | vec3_bound(e2)), st = fit15(vec3_bound(t));
+
+  int64_t x1 = e1.x >> s, y1 = e1.y >> s, z1 = e1.z >> s;
+  int64_t x2 = e2.x >> s, y2 = e2.y >> s, z2 = e2.z >> s;
+  return (y1 * z2 - z1 * y2) * (t.x >> st) + (z1 * x2 - x1 * z2) * (t.y >> st) +
+         (x1 * y2 - y1 * x2) * (t.z >> st) > 0;
+}
+
+// Projected face corner. Which of intensity and texel coordinates matter
+// depends on how the face is filled.
+typedef struct {
+  fix16_t x, y, z, i, u, v;
+} corner_t;
+
+typedef enum {
+  FILL_FLAT,
+  FILL_LIT,      // Gouraud from the vertex intensities
+  FILL_TEXTURED,
+} fill_t;
+
+static corner_t corner(int n)
+{
+  return (corner_t){ sx[n], sy[n], vz[n], intensity[n], tex_u[n], tex_v[n] };
+}
+
+static void draw_triangle(const corner_t c[3], fill_t fill, bool inside, uint16_t color, const gfx_texture_t *tex)
+{
+  if(fill == FILL_TEXTURED)
+  {
+    gfx_tex_vertex_t t[3];
+    for(int k = 0; k < 3; k++)
+      t[k] = (gfx_tex_vertex_t){ c[k].x, c[k].y, c[k].z, c[k].u, c[k].v };
+    if(inside)
+      gfx_fill_triangle_textured_unclipped(t, tex);
+    else
+      gfx_fill_triangle_textured(t, tex);
+    return;
+  }
+
+  bool lit = fill == FILL_LIT;
+#if V_DEPTH_BUFFER
+  if(lit && inside)
+    gfx_fill_triangle_depth_shaded_unclipped(c[0].x, c[0].y, c[0].z, c[0].i, c[1].x, c[1].y, c[1].z, c[1].i,
+                                             c[2].x, c[2].y, c[2].z, c[2].i, color);
+  else if(lit)
+    gfx_fill_triangle_depth_shaded(c[0].x, c[0].y, c[0].z, c[0].i, c[1].x, c[1].y, c[1].z, c[1].i,
+                                   c[2].x, c[2].y, c[2].z, c[2].i, color);
+  else if(inside)
+    gfx_fill_triangle_depth_unclipped(c[0].x, c[0].y, c[0].z, c[1].x, c[1].y, c[1].z, c[2].x, c[2].y, c[2].z, color);
+  else
+    gfx_fill_triangle_depth(c[0].x, c[0].y, c[0].z, c[1].x, c[1].y, c[1].z, c[2].x, c[2].y, c[2].z, color);
+#else
+  if(lit && inside)
+    gfx_fill_triangle_shaded_unclipped(c[0].x, c[0].y, c[0].i, c[1].x, c[1].y, c[1].i, c[2].x, c[2].y, c[2].i, color);
+  else if(lit)
+    gfx_fill_triangle_shaded(c[0].x, c[0].y, c[0].i, c[1].x, c[1].y, c[1].i, c[2].x, c[2].y, c[2].i, color);
+  else if(inside)
+    gfx_fill_triangle_fx_unclipped(c[0].x, c[0].y, c[1].x, c[1].y, c[2].x, c[2].y, color);
+  else
+    gfx_fill_triangle_fx(c[0].x, c[0].y, c[1].x, c[1].y, c[2].x, c[2].y, color);
+#endif
+}
+
+static fix16_t lerp(fix16_t a, fix16_t b, fix16_t t)
+{
+  return f16_add(a, f16_mul(t, f16_sub(b, a)));
+}
+
+// A vertex in view space with what gets interpolated along with it
+typedef struct {
+  fix16_t x, y, z, i, u, v;
+} view_vert_t;
+
+static view_vert_t view_vert(int n)
+{
+  return (view_vert_t){ vx[n], vy[n], vz[n], intensity[n], tex_u[n], tex_v[n] };
+}
+
+// Signed distance of v from one clip plane, negative outside. The side
+// planes pass through the eye at PROJECT_LIMIT pixels from the centre.
+static int64_t plane_dist(const projection_t *proj, uint8_t plane, const view_vert_t *v)
+{
+  int64_t z = (int64_t)v->z * PROJECT_LIMIT;
+  switch(plane)
+  {
+    case OUTCODE_LEFT:   return z + (((int64_t)v->x * proj->focal) >> F16_SHIFT);
+    case OUTCODE_RIGHT:  return z - (((int64_t)v->x * proj->focal) >> F16_SHIFT);
+    case OUTCODE_TOP:    return z + (((int64_t)v->y * proj->focal) >> F16_SHIFT);
+    case OUTCODE_BOTTOM: return z - (((int64_t)v->y * proj->focal) >> F16_SHIFT);
+    default:             return (int64_t)v->z - proj->near;
+  }
+}
+
+// Where the edge from in (inside) to out crosses the plane. Always
+// interpolating from the end inside makes every face and edge sharing it
+// agree on the point.
+static view_vert_t cut(const projection_t *proj, uint8_t plane, const view_vert_t *in, const view_vert_t *out,
+                       int64_t d_in, int64_t d_out)
+{
+  int64_t den = d_in - d_out;
+  int shift = den >> 31 ? 33 - __builtin_clzll((uint64_t)den) : 0;
+  fix16_t t = f16_div((fix16_t)(d_in >> shift), (fix16_t)(den >> shift));
+
+  view_vert_t c = {
+    lerp(in->x, out->x, t), lerp(in->y, out->y, t), lerp(in->z, out->z, t),
+    lerp(in->i, out->i, t), lerp(in->u, out->u, t), lerp(in->v, out->v, t),
+  };
+  if(plane == OUTCODE_NEAR)
+    c.z = proj->near;
+  return c;
+}
+
+// Screen position of a vertex inside every clip plane, as project_vertices
+// would have put it
+static void project(const projection_t *proj, const view_vert_t *v, fix16_t *px, fix16_t *py)
+{
+  fix16_t scale = f16_div(proj->focal, v->z < proj->near ? proj->near : v->z);
+  *px = f16_add(f16_mul(v->x, scale), proj->cx);
+  *py = f16_add(f16_mul(v->y, scale), proj->cy);
+}
+
+// Sutherland-Hodgman in view space against the near plane and the side
+// planes named in codes, then a fan of triangles. Intensity and texel
+// coordinates are cut along with the position.
+static void draw_clipped(const projection_t *proj, const int idx[3], uint8_t codes, fill_t fill, uint16_t color,
+                         const gfx_texture_t *tex)
+{
+  view_vert_t buf[2][8]; // three corners and one more per plane
+  view_vert_t *p = buf[0], *q = buf[1];
+  int n = 3;
+  for(int k = 0; k < 3; k++)
+    p[k] = view_vert(idx[k]);
+
+  for(uint8_t plane = OUTCODE_NEAR; plane <= OUTCODE_BOTTOM && n; plane <<= 1)
+  {
+    if(!(codes & plane))
+      continue;
+    int m = 0;
+    for(int k = 0; k < n; k++)
+    {
+      const view_vert_t *a = &p[k], *b = &p[k + 1 == n ? 0 : k + 1];
+      int64_t da = plane_dist(proj, plane, a), db = plane_dist(proj, plane, b);
+      if(da >= 0)
+        q[m++] = *a;
+      if((da >= 0) != (db >= 0))
+        q[m++] = da >= 0 ? cut(proj, plane, a, b, da, db) : cut(proj, plane, b, a, db, da);
+    }
+    view_vert_t *t = p;
+    p = q;
+    q = t;
+    n = m;
+  }
+
+  corner_t c[8];
+  for(int k = 0; k < n; k++)
+  {
+    project(proj, &p[k], &c[k].x, &c[k].y);
+    c[k].z = p[k].z;
+    c[k].i = p[k].i;
+    c[k].u = p[k].u;
+    c[k].v = p[k].v;
+  }
+  for(int k = 1; k + 1 < n; k++)
+  {
+    corner_t tri[3] = { c[0], c[k], c[k + 1] };
+    draw_triangle(tri, fill, false, color, tex);
+  }
+}
+
+// One edge between projected vertices a and b, cut at the clip planes if
+// clip is set and an end is outside one. Over faces the edge is pulled
+// slightly towards the camera so it wins the depth test against its own faces.
+static void draw_edge(const projection_t *proj, int a, int b, bool clip, bool over_faces, uint16_t color)
+{
+  fix16_t x0 = sx[a], y0 = sy[a], z0 = vz[a];
+  fix16_t x1 = sx[b], y1 = sy[b], z1 = vz[b];
+
+  if(clip && (outcode[a] | outcode[b]))
+  {
+    if(outcode[a] & outcode[b])
+      return;
+    view_vert_t va = view_vert(a), vb = view_vert(b);
+    uint8_t codes = outcode[a] | outcode[b];
+    for(uint8_t plane = OUTCODE_NEAR; plane <= OUTCODE_BOTTOM; plane <<= 1)
+    {
+      if(!(codes & plane))
+        continue;
+      int64_t da = plane_dist(proj, plane, &va), db = plane_dist(proj, plane, &vb);
+      if(da < 0 && db < 0)
+        return;
+      if(da < 0)
+        va = cut(proj, plane, &vb, &va, db, da);
+      else if(db < 0)
+        vb = cut(proj, plane, &va, &vb, da, db);
+    }
+    project(proj, &va, &x0, &y0);
+    project(proj, &vb, &x1, &y1);
+    z0 = va.z;
+    z1 = vb.z;
+  }
+
+#if V_DEPTH_BUFFER
+  if(over_faces)
+  {
+    z0 = f16_sub(z0, z0 >> 6);
+    z1 = f16_sub(z1, z1 >> 6);
+  }
+  gfx_draw_line_depth(x0, y0, z0, x1, y1, z1, color);
+#else
+  (void)z0; (void)z1; (void)over_faces;
+  gfx_draw_line(F16_TO_INT(x0), F16_TO_INT(y0), F16_TO_INT(x1), F16_TO_INT(y1), color);
+#endif
+}
+
+// Sphere first, the box only settles what the sphere could not
+static cull_t cull_mesh(const render_view_t *view, const mesh_t *mesh, const mat34_t *model)
+{
+  if(mesh->radius <= 0)
+    return CULL_PARTIAL;
+
+  cull_t cull = frustum_test_sphere(&view->frustum, mat34_transform(model, mesh->center), mesh->radius);
+  bool has_box = mesh->box_min.x != mesh->box_max.x || mesh->box_min.y != mesh->box_max.y ||
+                 mesh->box_min.z != mesh->box_max.z;
+  if(cull == CULL_PARTIAL && has_box)
+    cull = frustum_test_box(&view->frustum, model, mesh->box_min, mesh->box_max);
+  return cull;
+}
+
+// What render_mesh settled before drawing. Together with the scratch arrays
+// it is all draw_prepared needs, which lets the transform cache replay it.
+typedef struct {
+  bool culled;
+  bool inside;         // no clipping at all
+  bool wire, faces;
+  uint8_t any_clipped; // OR of the used vertices' outcodes
+  fill_t fill;
+  int num_used, num_visible;
+} prepared_t;
+
+static uint16_t face_color[V_MAX_MESH_FACES]; // shaded colour of each visible face, by position in visible
+
+#if V_RENDER_CACHE_BYTES
+typedef struct cache_entry cache_entry_t;
+static cache_entry_t *armed; // entry the next render_mesh stores into, see render_cache_replay
+static void cache_store(cache_entry_t *e, const mesh_t *mesh, const prepared_t *p);
+#endif
+
+// Culling, back faces, transform and lighting into the scratch arrays
+static void prepare(const render_view_t *view, const mesh_t *mesh, const mat34_t *model, prepared_t *p)
+{
+  int num_verts = mesh->num_vertices;
+  int num_faces = mesh->num_faces;
+
+  cull_t cull = cull_mesh(view, mesh, model);
+  *p = (prepared_t){ .culled = cull == CULL_OUTSIDE, .inside = cull == CULL_INSIDE };
+  if(p->culled)
+    return;
+
+  // Too many edges to mark falls back to faces alone
+  p->wire = view->mode != RENDER_SOLID && mesh->edges && mesh->num_edges <= V_MAX_MESH_EDGES;
+  p->faces = view->mode != RENDER_WIRE || !p->wire;
+  const uint16_t (*face_edges)[3] = p->wire ? mesh->face_edges : NULL;
+  if(p->wire)
+    memset(edge_mark, face_edges ? 0 : 1, (size_t)mesh->num_edges);
+
+  vertex_soa_t out = { vx, vy, vz, sx, sy, outcode };
+  memset(used, 0, (size_t)num_verts);
+  int num_visible = 0;
+
+  // Backface test against the camera in object space, so the vertices of
+  // faces that turn away are never transformed at all
+  vec3_t eye = mat34_untransform(model, (vec3_t){0, 0, 0});
+  const plane_t *planes = mesh->planes;
+
+  for(int f = 0; f < num_faces; f++)
+  {
+    int idx[3];
+    mesh_face(mesh, f, idx);
+
+    bool front = planes ? f16_add(vec3_dot(planes[f].n, eye), planes[f].d) > 0 : face_front(mesh, idx, eye);
+    if(!front)
+      continue;
+
+    visible[num_visible++] = (uint16_t)f;
+    used[idx[0]] = used[idx[1]] = used[idx[2]] = 1;
+
+    // Shared edges are marked by both faces and drawn once
+    if(face_edges)
+    {
+      for(int e = 0; e < 3; e++)
+      {
+        if(face_edges[f][e] != MESH_NO_EDGE)
+          edge_mark[face_edges[f][e]] = 1;
+      }
+    }
+  }
+
+  // Without face edges every edge is drawn, hidden or not
+  if(p->wire && !face_edges)
+  {
+    for(int e = 0; e < mesh->num_edges; e++)
+    {
+      int idx[2];
+      mesh_edge(mesh, e, idx);
+      used[idx[0]] = used[idx[1]] = 1;
+    }
+  }
+
+  int num_used = 0;
+  for(int i = 0; i < num_verts; i++)
+  {
+    if(used[i])
+      used_list[num_used++] = (uint16_t)i;
+  }
+  p->num_used = num_used;
+  p->num_visible = num_visible;
+
+  stats.verts_transformed += (uint32_t)num_used;
+
+  const vec3_t *positions = mesh->vertices;
+  if(!positions)
+  {
+    for(int n = 0; n < num_used; n++)
+      unpacked[used_list[n]] = mesh_vertex(mesh, used_list[n]);
+    positions = unpacked;
+  }
+
+  p->any_clipped = transform_project_list(model, &view->proj, positions, used_list, num_used, &out);
+
+  // Lit once per vertex rather than once per face
+  p->fill = mesh->uvs && mesh->texture ? FILL_TEXTURED : (view->light && mesh->normals ? FILL_LIT : FILL_FLAT);
+  for(int n = 0; n < num_used && p->faces && p->fill == FILL_LIT; n++)
+  {
+    int v = used_list[n];
+    intensity[v] = view->light(mat34_rotate(model, mesh->normals[v]));
+  }
+}
+
+// Fills the prepared faces and edges. model is only needed to shade flat
+// faces; without it the colours come from face_color.
+static void draw_prepared(const render_view_t *view, const mesh_t *mesh, const mat34_t *model, const prepared_t *p,
+                          uint16_t color)
+{
+  stats.faces_culled += (uint32_t)(mesh->num_faces - p->num_visible);
+  stats.verts_skipped += (uint32_t)(mesh->num_vertices - p->num_used);
+
+  const gfx_texture_t *tex = p->fill == FILL_TEXTURED ? mesh->texture : NULL;
+  for(int n = 0; n < p->num_used && p->faces && tex; n++)
+  {
+    int v = used_list[n];
+    tex_u[v] = mesh->uvs[v][0] << tex->width_log2;
+    tex_v[v] = mesh->uvs[v][1] << tex->height_log2;
+  }
+
+  for(int n = 0; n < p->num_visible && p->faces; n++)
+  {
+    int f = visible[n];
+    int idx[3];
+    mesh_face(mesh, f, idx);
+    int i1 = idx[0], i2 = idx[1], i3 = idx[2];
+
+    uint8_t clipped = p->inside || !p->any_clipped ? 0 : outcode[i1] | outcode[i2] | outcode[i3];
+    if(clipped && (outcode[i1] & outcode[i2] & outcode[i3]))
+      continue;
+
+    uint16_t shaded_color = color;
+    if(view->shade && p->fill == FILL_FLAT)
+    {
+      if(model)
+      {
+        vec3_t normal = mesh->planes ? mesh->planes[f].n : vec3_normalize(face_normal(mesh, idx));
+        face_color[n] = view->shade(color, mat34_rotate(model, normal));
+      }
+      shaded_color = face_color[n];
+    }
+
+    if(clipped)
+    {
+      draw_clipped(&view->proj, idx, clipped, p->fill, shaded_color, tex);
+      stats.faces_clipped++;
+    }
+    else
+    {
+      corner_t c[3] = { corner(i1), corner(i2), corner(i3) };
+      draw_triangle(c, p->fill, p->inside, shaded_color, tex);
+    }
+    stats.faces_drawn++;
+  }
+
+  uint16_t edge_color = p->faces ? view->edge_color : color;
+  bool clip = !p->inside && p->any_clipped;
+  for(int e = 0; e < mesh->num_edges && p->wire; e++)
+  {
+    if(!edge_mark[e])
+      continue;
+    int idx[2];
+    mesh_edge(mesh, e, idx);
+    draw_edge(&view->proj, idx[0], idx[1], clip, p->faces, edge_color);
+    stats.edges_drawn++;
+  }
+}
+
+void render_mesh(const render_view_t *view, const mesh_t *mesh, const mat34_t *model, uint16_t color)
+{
+#if V_RENDER_CACHE_BYTES
+  cache_entry_t *store = armed;
+  armed = NULL;
+#endif
+  if(mesh->num_vertices > V_MAX_MESH_VERTS || mesh->num_faces > V_MAX_MESH_FACES)
+    return;
+
+  prepared_t p;
+  PROFILE_BEGIN(PROF_TRANSFORM);
+  prepare(view, mesh, model, &p);
+  PROFILE_END(PROF_TRANSFORM);
+  if(p.culled)
+    stats.entities_culled++;
+  else
+  {
+    stats.entities_drawn++;
+    PROFILE_BEGIN(PROF_RASTER);
+    draw_prepared(view, mesh, model, &p, color);
+    PROFILE_END(PROF_RASTER);
+  }
+
+#if V_RENDER_CACHE_BYTES
+  if(store)
+    cache_store(store, mesh, &p);
+#endif
+}
+
+void render_mesh_lod(const render_view_t *view, const mesh_lod_t *lod, uint8_t *level, const mat34_t *model,
+                     uint16_t color)
+{
+  *level = (uint8_t)mesh_lod_select(lod, *level, model->m[2][3]);
+  const mesh_t *mesh = lod->levels[*level];
+
+  uint32_t drawn = stats.entities_drawn;
+  render_mesh(view, mesh, model, color);
+  if(*level && stats.entities_drawn != drawn)
+  {
+    stats.lod_coarse++;
+    stats.lod_faces_saved += (uint32_t)(lod->levels[0]->num_faces - mesh->num_faces);
+  }
+}
+
+#if V_RENDER_CACHE_BYTES
+
+// Transform cache. Entries are few, so lookups scan them; the arena holds
+// each entry's scratch arrays packed back to back and is compacted when a
+// store does not fit at the top, evicting least recently used entries until
+// it does. Entries drawn this frame are never evicted: with more objects on
+// screen than the cache holds, the first ones keep their places and the rest
+// go uncached, rather than each evicting the next in a cycle.
+struct cache_entry {
+  uint32_t key;        // 0 = free
+  const mesh_t *mesh;
+  vec3_t pos, rot;
+  quat_t orient;       // all zero for objects placed by rot
+  uint16_t color;
+  bool stored;         // prep and the arena data are valid
+  uint32_t epoch;
+  uint32_t last_used;  // frame number
+  uint32_t offset, size;
+  prepared_t prep;
+};
+
+static cache_entry_t entries[V_RENDER_CACHE_ENTRIES];
+static uint32_t arena[V_RENDER_CACHE_BYTES / 4];
+static uint32_t arena_top;  // bytes
+static uint32_t epoch = 1;  // bumped whenever the view or the camera changes
+static uint32_t frame;
+
+// View settings the cached data depends on, compared field by field
+static render_view_t last_view;
+static mat34_t last_camera;
+
+static bool vec3_same(vec3_t a, vec3_t b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool quat_same(quat_t a, quat_t b)
+{
+  return a.w == b.w && a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+void render_cache_begin(const render_view_t *view, const mat34_t *world_to_view)
+{
+  frame++;
+  armed = NULL;
+
+  bool same = view->proj.focal == last_view.proj.focal && view->proj.cx == last_view.proj.cx &&
+              view->proj.cy == last_view.proj.cy && view->proj.near == last_view.proj.near &&
+              view->shade == last_view.shade && view->light == last_view.light &&
+              view->mode == last_view.mode && view->edge_color == last_view.edge_color &&
+              !memcmp(world_to_view, &last_camera, sizeof(last_camera));
+  if(!same)
+  {
+    epoch++;
+    last_view = *view;
+    last_camera = *world_to_view;
+  }
+}
+
+void render_cache_clear(void)
+{
+  memset(entries, 0, sizeof(entries));
+  arena_top = 0;
+  armed = NULL;
+  epoch++;
+}
+
+// The data goes too, its arena space is reclaimed by the next compaction
+static void cache_drop(cache_entry_t *e)
+{
+  e->stored = false;
+  e->size = 0;
+}
+
+static cache_entry_t *cache_lru(const cache_entry_t *keep, bool with_data)
+{
+  cache_entry_t *lru = NULL;
+  for(int i = 0; i < V_RENDER_CACHE_ENTRIES; i++)
+  {
+    cache_entry_t *e = &entries[i];
+    if(e == keep || (with_data && !e->size))
+      continue;
+    if(!lru || e->last_used < lru->last_used)
+      lru = e;
+  }
+  return lru;
+}
+
+// Slides every entry's data down to the bottom of the arena, in place
+static void cache_compact(void)
+{
+  uint32_t top = 0, floor = 0;
+  for(;;)
+  {
+    cache_entry_t *next = NULL;
+    for(int i = 0; i < V_RENDER_CACHE_ENTRIES; i++)
+    {
+      cache_entry_t *e = &entries[i];
+      if(e->size && e->offset >= floor && (!next || e->offset < next->offset))
+        next = e;
+    }
+    if(!next)
+      break;
+    floor = next->offset + 1;
+    if(next->offset != top)
+      memmove((uint8_t *)arena + top, (uint8_t *)arena + next->offset, next->size);
+    next->offset = top;
+    top += next->size;
+  }
+  arena_top = top;
+}
+
+// Room for size bytes for e, false if the data can never fit or only would
+// by evicting an entry drawn this frame
+static bool cache_alloc(cache_entry_t *e, uint32_t size)
+{
+  if(size > sizeof(arena))
+    return false;
+  while(arena_top + size > sizeof(arena))
+  {
+    uint32_t live = 0;
+    for(int i = 0; i < V_RENDER_CACHE_ENTRIES; i++)
+      live += entries[i].size;
+    if(live + size <= sizeof(arena))
+    {
+      cache_compact();
+      break;
+    }
+    cache_entry_t *lru = cache_lru(e, true);
+    if(!lru || lru->last_used == frame)
+      return false;
+    cache_drop(lru);
+    stats.cache_evictions++;
+  }
+  e->offset = arena_top;
+  e->size = size;
+  arena_top += size;
+  return true;
+}
+
+// Arena layout of an entry: used_list, then per used vertex vx, vy, vz, sx
+// and sy, intensity when lit, the visible faces with their colours, the
+// edge marks and the outcodes, each rounded up to 4 bytes
+#define CACHE_ALIGN(n) (((n) + 3u) & ~3u)
+
+static uint32_t cache_size(const mesh_t *mesh, const prepared_t *p)
+{
+  uint32_t u = (uint32_t)p->num_used, v = (uint32_t)p->num_visible;
+  uint32_t size = CACHE_ALIGN(u * 2) + u * 5 * sizeof(fix16_t) + CACHE_ALIGN(v * 2) * 2 + CACHE_ALIGN(u);
+  if(p->fill == FILL_LIT)
+    size += u * sizeof(fix16_t);
+  if(p->wire)
+    size += CACHE_ALIGN((uint32_t)mesh->num_edges);
+  return size;
+}
+
+// Copies between the scratch arrays and an entry's data, in either direction
+static void cache_copy(const mesh_t *mesh, const prepared_t *p, uint8_t *data, bool save)
+{
+  int u = p->num_used, v = p->num_visible;
+#define COPY(arr, n) \
+  do { \
+    if(save) memcpy(data, arr, (n)); else memcpy(arr, data, (n)); \
+    data += CACHE_ALIGN((uint32_t)(n)); \
+  } while(0)
+  COPY(used_list, (size_t)u * 2);
+  fix16_t *vert = (fix16_t *)data;
+  for(int n = 0; n < u; n++, vert += 5)
+  {
+    int i = used_list[n];
+    if(save)
+    {
+      vert[0] = vx[i]; vert[1] = vy[i]; vert[2] = vz[i]; vert[3] = sx[i]; vert[4] = sy[i];
+    }
+    else
+    {
+      vx[i] = vert[0]; vy[i] = vert[1]; vz[i] = vert[2]; sx[i] = vert[3]; sy[i] = vert[4];
+    }
+  }
+  data = (uint8_t *)vert;
+  if(p->fill == FILL_LIT)
+  {
+    fix16_t *lit = (fix16_t *)data;
+    for(int n = 0; n < u; n++)
+    {
+      if(save)
+        lit[n] = intensity[used_list[n]];
+      else
+        intensity[used_list[n]] = lit[n];
+    }
+    data += (size_t)u * sizeof(fix16_t);
+  }
+  COPY(visible, (size_t)v * 2);
+  COPY(face_color, (size_t)v * 2);
+  if(p->wire)
+    COPY(edge_mark, (size_t)mesh->num_edges);
+  for(int n = 0; n < u; n++)
+  {
+    if(save)
+      data[n] = outcode[used_list[n]];
+    else
+      outcode[used_list[n]] = data[n];
+  }
+#undef COPY
+}
+
+static void cache_store(cache_entry_t *e, const mesh_t *mesh, const prepared_t *p)
+{
+  if(e->mesh != mesh)
+    return;
+  uint32_t size = p->culled ? 0 : cache_size(mesh, p);
+  if(size && !cache_alloc(e, size))
+    return;
+  if(size)
+    cache_copy(mesh, p, (uint8_t *)arena + e->offset, true);
+  e->prep = *p;
+  e->stored = true;
+}
+
+bool render_cache_replay(const render_view_t *view, uint32_t key, const mesh_t *mesh, vec3_t pos, vec3_t rot,
+                         quat_t orient, uint16_t color)
+{
+  armed = NULL;
+  if(!key)
+    return false;
+
+  cache_entry_t *e = NULL;
+  for(int i = 0; i < V_RENDER_CACHE_ENTRIES && !e; i++)
+  {
+    if(entries[i].key == key)
+      e = &entries[i];
+  }
+  bool same = e && e->mesh == mesh && e->color == color && e->epoch == epoch && vec3_same(e->pos, pos) &&
+              vec3_same(e->rot, rot) && quat_same(e->orient, orient);
+
+  if(same && e->stored)
+  {
+    e->last_used = frame;
+    stats.cache_hits++;
+    if(e->prep.culled)
+    {
+      stats.entities_culled++;
+      return true;
+    }
+    stats.entities_drawn++;
+    PROFILE_BEGIN(PROF_TRANSFORM);
+    cache_copy(mesh, &e->prep, (uint8_t *)arena + e->offset, false);
+    PROFILE_END(PROF_TRANSFORM);
+    PROFILE_BEGIN(PROF_RASTER);
+    draw_prepared(view, mesh, NULL, &e->prep, color);
+    PROFILE_END(PROF_RASTER);
+    return true;
+  }
+  stats.cache_misses++;
+
+  if(!e)
+  {
+    for(int i = 0; i < V_RENDER_CACHE_ENTRIES && !e; i++)
+    {
+      if(!entries[i].key)
+        e = &entries[i];
+    }
+    if(!e)
+    {
+      e = cache_lru(NULL, false);
+      if(e->last_used == frame)
+        return false;
+      stats.cache_evictions++;
+    }
+  }
+
+  // Only a placement seen twice running is stored, so anything that moves
+  // every frame never takes arena space
+  if(same)
+    armed = e;
+  else
+    *e = (cache_entry_t){ .key = key, .mesh = mesh, .pos = pos, .rot = rot, .orient = orient, .color = color,
+                              .epoch = epoch };
+  e->last_used = frame;
+  return false;
+}
+
+#endif
@@ -1,6 +1,28 @@
 #ifndef V_COLORS_H
 #define V_COLORS_H
 
+#include "v_config.h"
+
+#if V_INDEXED_COLOR
+
+// The default palette is 16 ramps of 16 shades, shade 0 black and 15 the
+// full colour, so darkening a colour is a subtraction: V_RAMP_SHADE(V_RED, 7)
+// is red at 7/15. Ramps 0-6 are the colours below, 7-15 are grey until
+// a game loads its own with display_set_palette.
+#define V_RAMP_SHADES 16
+#define V_RAMP_SHADE(color, shade) (((color) & ~(V_RAMP_SHADES - 1)) | (shade))
+
+#define V_BLACK   0x00
+#define V_WHITE   0x0F
+#define V_RED     0x1F
+#define V_GREEN   0x2F
+#define V_BLUE    0x3F
+#define V_CYAN    0x4F
+#define V_MAGENTA 0x5F
+#define V_YELLOW  0x6F
+
+#else
+
 #define V_BLACK   0x0000
 #define V_BLUE    0x001F
 #define V_RED     0xF800
@@ -11,3 +33,5 @@
 #define V_WHITE   0xFFFF
 
 #endif
+
+#endif
@@ -17,11 +17,68 @@
 
 #define V_SPI_SPEED_HZ    (60 * 1000 * 1000) // 26 MHz
 #define V_DMA_CHUNK_LINES 20                 // How many lines to send at once
+#define V_SPI_QUEUE_SIZE  16                 // In-flight SPI transactions (one frame + window setup)
 #define V_RESET_DELAY_MS  100                // Delay for hardware reset
 #define V_BOOT_DELAY_MS   150                // Delay for screen wakeup
 
 #define V_BUFFER_SIZE (V_DISPLAY_WIDTH * V_DISPLAY_HEIGHT) // Total pixels
 
+// Render mode
+#define V_RENDER_STRIPS      0   // 1 = no framebuffer, rasterize per band into two strip buffers
+#define V_NUM_BANDS          ((V_DISPLAY_HEIGHT + V_DMA_CHUNK_LINES - 1) / V_DMA_CHUNK_LINES)
+#define V_DISPLAY_LIST_SIZE  512 // Primitives recorded per frame in strip mode
+#define V_DISPLAY_LIST_BINS  1024 // Primitive-to-band links per frame
+#define V_DISPLAY_LIST_TEXTURED 128 // Of those, textured triangles
+
+// Indexed colour
+#define V_INDEXED_COLOR 0 // 1 = 8-bit palette framebuffer (20 KB), expanded to RGB565 while it streams
+
+// Depth buffer
+#define V_DEPTH_BUFFER 0     // 1 = 16-bit per-pixel depth test for the *_depth primitives
+#define V_DEPTH_SHIFT  0     // 1 = one depth sample per 2x2 pixels (quarter the RAM)
+#define V_DEPTH_NEAR   16384 // Q16.16 (0.25), closest z with full depth precision, must stay below 1.0
+
+// Textures
+#define V_TEXTURE_SUBSPAN 8 // Pixels between perspective divides, u and v step linearly in between
+
+// Mesh renderer
+#define V_MAX_MESH_VERTS 256 // Larger meshes are skipped, sizes the static per-mesh scratch arrays
+#define V_MAX_MESH_FACES 512
+#define V_MAX_MESH_EDGES 768 // Over this the wireframe is skipped, the faces still draw
+#define V_MAX_ENTITIES   256 // Entity store capacity, below 0xFFFF, about 120 bytes each with the grid
+#define V_MAX_LODS       4   // Levels in a mesh_lod_t chain
+
+// Transform cache, see render_cache_replay
+#define V_RENDER_CACHE_BYTES   16384 // Arena of projected vertices, 0 compiles the cache out
+#define V_RENDER_CACHE_ENTRIES 32    // Objects tracked at once
+
+// Entity grid, see v_grid.h. Centred on the world origin.
+#define V_GRID_CELL_SHIFT 18     // Cells 1 << 18 Q16.16 units (4.0) on a side
+#define V_GRID_DIM_X      8
+#define V_GRID_DIM_Y      8
+#define V_GRID_DIM_Z      8
+#define V_GRID_MARGIN     131072 // Q16.16 (2.0), entities reaching further are tested every query
+
+// Frame profiler, see v_profile.h
+#define V_PROFILE        0  // 1 = time engine stages and count pixels, 0 compiles it all out
+#define V_PROFILE_FRAMES 64 // Frames kept in the ring buffer
+
+// Main loop, see v_engine.h
+#define V_TICK_HZ             60   // Fixed update rate, on_update always steps 1/V_TICK_HZ seconds
+#define V_TARGET_FPS          60   // Frames are paced to this rate, 0 draws as fast as possible
+#define V_MAX_TICKS_PER_FRAME 4    // Updates one frame may catch up on, any older backlog is dropped
+#define V_YIELD_MS            1000 // engine_start gives the idle task a tick at least this often
+
+// Dirty rectangles
+#define V_DIRTY_RECTS          1    // 0 = always send the full frame
+#define V_DIRTY_MAX_RECTS      8    // Rects tracked per frame before they get merged
+#define V_DIRTY_MERGE_SLACK    256  // Extra pixels worth sending to save a window setup
+#define V_DIRTY_STAGING_PIXELS 2048 // Per buffer, packs narrow rects into one contiguous transfer
+
+// Input
+#define V_INPUT_QUEUE_SIZE  32   // Buffered press/release events, power of two
+#define V_INPUT_DEBOUNCE_US 5000 // A button ignores further edges this long after one is taken
+
 // Buttons 
 #define BUTTON_1 14 
 #define BUTTON_2 13 
@@ -3,17 +3,50 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "v_config.h"
+
+// Monotonic id of a queued transfer, transfers complete in queue order
+typedef uint32_t display_ticket_t;
+
+// Byte pipe to the panel. The ESP32 build uses the SPI DMA queue, the host
+// build a stub with simulated transfer latency. Pixel buffers handed to
+// queue_pixels must not be touched until wait() has returned for their ticket.
+typedef struct {
+  bool (*init)(void);                                            // Bus + panel bring-up
+  uint16_t *(*alloc)(int pixels);                                // DMA-capable pixel memory
+  void (*set_window)(int x, int y, int w, int h);                // Queued CASET/RASET/RAMWR
+  display_ticket_t (*queue_pixels)(const uint16_t *pixels, int count); // Asynchronous
+  void (*wait)(display_ticket_t ticket);                         // Blocks until ticket is on the panel
+  void (*frame_end)(void);                                       // Optional, marks the end of a frame
+} display_transport_t;
+
+typedef struct {
+  uint32_t bytes; // SPI bytes of the last presented frame, window setup included
+  uint16_t rects; // Windows it was sent as
+#if V_PROFILE
+  uint32_t wait_cycles;   // Blocked on the transport during display_present
+  uint32_t render_cycles; // Rasterizing bands in strip mode
+#endif
+} display_stats_t;
 
-void display_init(void);
+const display_transport_t *display_default_transport(void); // Provided by the platform backend
+void display_set_transport(const display_transport_t *transport); // Call before display_init
 
-//void display_set_window(int x, int y, int w, int h);
+void display_init(void);
 
-//void display_push_color(uint16_t color);
+#if V_INDEXED_COLOR
+// 256-entry RGB565 palette the framebuffer indices expand through. Writing
+// entries marks the whole screen dirty; the panel picks them up with the
+// next display_present.
+void display_set_palette(int first, int count, const uint16_t *rgb565);
+uint16_t display_palette_color(uint8_t index);
+#endif
 
-//void display_push_pixels(uint16_t *colors, int count);
+void display_present(void);    // Queues the back buffer and swaps, returns while the frame is on the wire
+void display_wait_vsync(void); // Blocks until the last presented frame has been fully sent
 
-//void display_fill_rect(int x, int y, int w, int h, uint16_t color);
+void display_draw(void); // present + wait_vsync, the old blocking behaviour
 
-void display_draw(void); // Sends the entire frame buffer to the screen via DMA
+const display_stats_t *display_get_stats(void);
 
 #endif
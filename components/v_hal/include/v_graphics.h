@@ -3,6 +3,24 @@
 
 #include "v_display.h"
 #include "v_config.h"
+#include "v_fixed.h"
+
+typedef struct {
+  int x, y, w, h;
+} gfx_rect_t;
+
+// Framebuffer pixels. With V_INDEXED_COLOR every gfx_* colour is an index
+// into the display palette (see v_colors.h and display_set_palette), the
+// buffer holds it as is and display_present expands it to RGB565; otherwise
+// colours are RGB565, stored byte-swapped for the panel.
+#if V_INDEXED_COLOR
+typedef uint8_t gfx_pixel_t;
+#if V_RENDER_STRIPS
+#error "V_INDEXED_COLOR shrinks the framebuffer, V_RENDER_STRIPS has none"
+#endif
+#else
+typedef uint16_t gfx_pixel_t;
+#endif
 
 
 void gfx_draw_pixel(int x, int y, uint16_t color);
@@ -13,6 +31,82 @@ void gfx_fill_rect(int x, int y, int w, int h, uint16_t color);
 
 void gfx_clear(uint16_t color);
 
-void gfx_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color);
+void gfx_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color); // Vertices at pixel centres
+
+// Sub-pixel vertices in Q16.16 screen space, pixel (x, y) covers [x, x + 1)
+void gfx_fill_triangle_fx(fix16_t x1, fix16_t y1, fix16_t x2, fix16_t y2, fix16_t x3, fix16_t y3, uint16_t color);
+
+// Same without clamping spans to the screen. Only for vertices known to lie
+// within [0, V_DISPLAY_WIDTH] x [0, V_DISPLAY_HEIGHT], e.g. from an entity
+// that passed the frustum test as fully inside.
+void gfx_fill_triangle_fx_unclipped(fix16_t x1, fix16_t y1, fix16_t x2, fix16_t y2, fix16_t x3, fix16_t y3, uint16_t color);
+
+// Gouraud shading: i1..i3 are vertex intensities (Q16.16, [0, 1]) that fade
+// color towards black. They are interpolated along the spans and each pixel
+// looks its shade up in a ramp of precomputed shades of color, built on first
+// use and cached for the last few colours, so no pixel unpacks RGB565.
+void gfx_fill_triangle_shaded(fix16_t x1, fix16_t y1, fix16_t i1, fix16_t x2, fix16_t y2, fix16_t i2,
+                              fix16_t x3, fix16_t y3, fix16_t i3, uint16_t color);
+void gfx_fill_triangle_shaded_unclipped(fix16_t x1, fix16_t y1, fix16_t i1, fix16_t x2, fix16_t y2, fix16_t i2,
+                                        fix16_t x3, fix16_t y3, fix16_t i3, uint16_t color);
+
+// Texture read in place, straight from rodata or a memory-mapped flash
+// partition. Both sides are powers of two and coordinates wrap. 16-bit
+// texels are gfx colours; 8-bit texels index colors, which holds gfx colours.
+typedef struct {
+  const void *texels;     // [height][width] uint16_t, or uint8_t with colors
+  const uint16_t *colors; // NULL for 16-bit texels
+  uint8_t width_log2, height_log2;
+} gfx_texture_t;
+
+// Vertex of a textured triangle: Q16.16 screen position, camera-space depth
+// (> 0, as for the depth buffer) and texel coordinates in Q16.16. Keep u and v
+// within +-256 texels; offset them by whole texture sizes if they wander.
+typedef struct {
+  fix16_t x, y, z, u, v;
+} gfx_tex_vertex_t;
+
+// Perspective-correct texture mapping: u/z, v/z and 1/z are interpolated
+// along the spans, u and v recovered through the reciprocal every
+// V_TEXTURE_SUBSPAN pixels and stepped linearly in between. With
+// V_DEPTH_BUFFER the triangle is depth tested like gfx_fill_triangle_depth.
+void gfx_fill_triangle_textured(const gfx_tex_vertex_t v[3], const gfx_texture_t *tex);
+void gfx_fill_triangle_textured_unclipped(const gfx_tex_vertex_t v[3], const gfx_texture_t *tex);
+
+#if V_DEPTH_BUFFER
+// Depth-tested primitives. z is camera-space depth (Q16.16, > 0 in front of
+// the camera); the buffer stores V_DEPTH_NEAR / z so it interpolates linearly
+// across the screen and clears to 0.
+uint16_t gfx_depth_from_z(fix16_t z);
+void gfx_depth_clear(void);
+void gfx_fill_triangle_depth(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t x2, fix16_t y2, fix16_t z2,
+                             fix16_t x3, fix16_t y3, fix16_t z3, uint16_t color);
+void gfx_fill_triangle_depth_unclipped(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t x2, fix16_t y2, fix16_t z2,
+                                       fix16_t x3, fix16_t y3, fix16_t z3, uint16_t color);
+void gfx_fill_triangle_depth_shaded(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t i1,
+                                    fix16_t x2, fix16_t y2, fix16_t z2, fix16_t i2,
+                                    fix16_t x3, fix16_t y3, fix16_t z3, fix16_t i3, uint16_t color);
+void gfx_fill_triangle_depth_shaded_unclipped(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t i1,
+                                              fix16_t x2, fix16_t y2, fix16_t z2, fix16_t i2,
+                                              fix16_t x3, fix16_t y3, fix16_t z3, fix16_t i3, uint16_t color);
+void gfx_draw_line_depth(fix16_t x0, fix16_t y0, fix16_t z0, fix16_t x1, fix16_t y1, fix16_t z1, uint16_t color);
+#endif
+
+// Dirty rectangles: every primitive records the screen area it touched.
+// gfx_dirty_end_frame returns what changed since the panel was last updated
+// (this frame's rects merged with the previous frame's) and starts a new frame.
+int gfx_dirty_end_frame(gfx_rect_t *out, int max);
+void gfx_dirty_invalidate(void); // Forces the next frame to be sent in full
+
+#if V_PROFILE
+uint32_t gfx_pixels_rasterized(void); // Running total of pixels covered by primitives, clears excluded
+#endif
+
+#if V_RENDER_STRIPS
+// Strip mode: gfx_* calls only record, the display replays them band by band
+void gfx_render_band(uint16_t *strip, int band); // Rasterizes rows of one band into strip
+void gfx_display_list_reset(void);               // Drops the recorded frame
+uint32_t gfx_dropped_commands(void);             // Primitives lost to a full display list
+#endif
 
 #endif
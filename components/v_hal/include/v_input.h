@@ -11,8 +11,24 @@
 #define INPUT_A     (1 << 4)
 #define INPUT_B     (1 << 5)
 
+typedef struct {
+  int64_t time_us; // timer_get_us() when the edge was taken
+  uint8_t button;  // one INPUT_* bit
+  bool pressed;    // false for a release
+} input_event_t;
 
 void input_init(void);
-uint8_t input_get(void);
+uint8_t input_get(void); // Buttons held as of the newest event, INPUT_* bits
+
+// Pops the oldest event, false when there is none. Events are queued as the
+// edges happen (from interrupts on the ESP32), so a press and release that
+// both fall between two reads still show up here while input_get() misses
+// them. Only one task may read.
+bool input_poll_event(input_event_t *ev);
+uint32_t input_dropped_events(void); // Lost to a full queue since input_init
+
+// Platform backend side
+void input_backend_init(void); // Provided by the platform backend, input_init calls it
+void input_push_event(uint8_t button, bool pressed, int64_t time_us); // Only one context may push at a time
 
 #endif
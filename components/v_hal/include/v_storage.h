@@ -0,0 +1,14 @@
+#ifndef V_STORAGE_H
+#define V_STORAGE_H
+
+#include <stddef.h>
+
+#define V_STORAGE_MAX_MAPS 4 // Distinct areas that can be mapped at once
+
+// Read-only, memory-mapped view of a named asset area: a data partition on
+// the ESP32, <dir>/<name>.bin on the host. Mapping the same name again
+// returns the same pointer, it stays valid for the life of the program.
+// NULL when the area does not exist or cannot be mapped.
+const void *storage_map(const char *name, size_t *size);
+
+#endif
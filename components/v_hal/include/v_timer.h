@@ -0,0 +1,22 @@
+#ifndef V_TIMER_H
+#define V_TIMER_H
+
+#include <stdint.h>
+
+void timer_init(void);
+
+int64_t timer_get_us(void); // Monotonic time since boot in microseconds
+
+// Free-running cycle counter for timing short stretches of code, wraps
+// every few seconds so only differences between close reads mean anything.
+// The host counts nanoseconds instead of CPU cycles.
+uint32_t timer_get_cycles(void);
+uint32_t timer_cycles_per_us(void);
+
+// Blocks for us microseconds: whole scheduler ticks are slept, the remainder
+// is spun so short waits do not round up to a full tick. No-op for us <= 0.
+void timer_sleep_us(int64_t us);
+
+void timer_yield(void); // Give the scheduler one tick (feeds the idle task watchdog)
+
+#endif
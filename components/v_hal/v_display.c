@@ -1,217 +1,364 @@
 #include "v_display.h"
+#include "v_graphics.h"
+#include "v_colors.h"
 #include "v_config.h"
+#include "v_timer.h"
 
+#include <stddef.h>
 #include <string.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "driver/spi_master.h"
-#include "driver/gpio.h"
-#include "esp_log.h"
-#include "esp_heap_caps.h"
 
+// Double-buffered framebuffer. v_frameBuffer always points at the back buffer
+// the CPU draws into, the other one may still be streaming to the panel.
+// With V_RENDER_STRIPS there is no framebuffer at all: each band is
+// rasterized into one of two strip buffers while the other one streams.
+// With V_INDEXED_COLOR there is a single 8-bit framebuffer that only the CPU
+// reads: display_present expands it through the palette into two small DMA
+// buffers, one filling while the other streams, so drawing can resume as
+// soon as it returns.
+
+#define WINDOW_BYTES 11 // CASET + RASET + RAMWR with their parameters
+
+gfx_pixel_t *v_frameBuffer = NULL;
+
+static const display_transport_t *transport = NULL;
+
+#if V_RENDER_STRIPS
+static uint16_t *strips[2] = { NULL, NULL };
+static display_ticket_t strip_ticket[2] = { 0, 0 };
+#elif V_INDEXED_COLOR
+static gfx_pixel_t framebuffer[V_BUFFER_SIZE];
+static uint16_t *chunks[2] = { NULL, NULL };
+static display_ticket_t chunk_ticket[2] = { 0, 0 };
+static int chunk_next = 0;
+static uint16_t palette[256]; // Byte-swapped for the panel
+#else
+static uint16_t *buffers[2] = { NULL, NULL };
+static int back = 0;
+
+// Narrow dirty rects are packed here so each goes out as one transfer.
+// One staging area per framebuffer, it is free whenever its buffer is.
+static uint16_t *staging[2] = { NULL, NULL };
+
+static display_ticket_t buffer_ticket[2] = { 0, 0 }; // Last transfer reading from each buffer
+#endif
+
+static display_ticket_t frame_ticket = 0; // Last transfer of the newest frame
+
+static bool ready = false;
+static display_stats_t stats;
+
+// Adds the cycles spent in call to a stats field when profiling
+#if V_PROFILE
+#define TIMED(field, call) \
+  do { uint32_t t0_ = timer_get_cycles(); call; stats.field += timer_get_cycles() - t0_; } while (0)
+#define TIMED_RESET() (stats.wait_cycles = stats.render_cycles = 0)
+#else
+#define TIMED(field, call) call
+#define TIMED_RESET() ((void)0)
+#endif
+
+void display_set_transport(const display_transport_t *t)
+{
+  transport = t;
+}
 
-// Command Reg
-#define CMD_SWRESET 0x01 // Software Reset
-#define CMD_SLPOUT  0x11 // Sleep Out
-#define CMD_INVON   0x21 // Inversion On
-#define CMD_INVOFF  0x20 // Inversion Off
-#define CMD_DISPON  0x29 // Display On
-#define CMD_CASET   0x2A // Column Address Set
-#define CMD_RASET   0x2B // Row Address Set
-#define CMD_RAMWR   0x2C // Memory Write
-#define CMD_MADCTL  0x36 // Memory Access Control (Rotation)
-#define CMD_COLMOD  0x3A // Interface Pixel Format
+#if V_INDEXED_COLOR
+void display_set_palette(int first, int count, const uint16_t *rgb565)
+{
+  for (int i = 0; i < count && first + i < 256; i++)
+    palette[first + i] = (rgb565[i] >> 8) | (rgb565[i] << 8);
+  gfx_dirty_invalidate();
+}
 
-// Data constants
-#define COLMOD_16BIT 0x05
-#define MADCTL_BGR   0xC8
-#define MADCTL_RGB   0xC0
+uint16_t display_palette_color(uint8_t index)
+{
+  return (palette[index] >> 8) | (palette[index] << 8);
+}
 
+// Ramps of V_RAMP_SHADES from black up to each base colour, see v_colors.h
+static void default_palette(void)
+{
+  static const uint16_t bases[] = { 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x07FF, 0xF81F, 0xFFE0 };
+  uint16_t ramp[V_RAMP_SHADES];
 
-uint16_t *v_frameBuffer = NULL;
+  for (int r = 0; r < 256 / V_RAMP_SHADES; r++)
+  {
+    uint16_t base = r < (int)(sizeof(bases) / sizeof(bases[0])) ? bases[r] : 0xFFFF;
+    for (int s = 0; s < V_RAMP_SHADES; s++)
+    {
+      int red = ((base >> 11) & 0x1F) * s / (V_RAMP_SHADES - 1);
+      int green = ((base >> 5) & 0x3F) * s / (V_RAMP_SHADES - 1);
+      int blue = (base & 0x1F) * s / (V_RAMP_SHADES - 1);
+      ramp[s] = (uint16_t)((red << 11) | (green << 5) | blue);
+    }
+    display_set_palette(r * V_RAMP_SHADES, V_RAMP_SHADES, ramp);
+  }
+}
+#endif
 
+void display_init(void)
+{
+  if (!transport)
+    transport = display_default_transport();
 
-static spi_device_handle_t spi;
+#if V_RENDER_STRIPS
+  if (!strips[0])
+  {
+    strips[0] = transport->alloc(V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES);
+    strips[1] = transport->alloc(V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES);
+  }
 
-static void lcd_cmd(const uint8_t cmd)
+  if (!strips[0] || !strips[1])
+  {
+    strips[0] = strips[1] = NULL;
+    return;
+  }
+#elif V_INDEXED_COLOR
+  if (!chunks[0])
+  {
+    chunks[0] = transport->alloc(V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES);
+    chunks[1] = transport->alloc(V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES);
+  }
+
+  if (!chunks[0] || !chunks[1])
+  {
+    chunks[0] = chunks[1] = NULL;
+    return;
+  }
+#else
+  if (!buffers[0])
+  {
+    buffers[0] = transport->alloc(V_BUFFER_SIZE);
+    buffers[1] = transport->alloc(V_BUFFER_SIZE);
+#if V_DIRTY_RECTS
+    staging[0] = transport->alloc(V_DIRTY_STAGING_PIXELS);
+    staging[1] = transport->alloc(V_DIRTY_STAGING_PIXELS);
+#endif
+  }
+
+  if (!buffers[0] || !buffers[1])
+  {
+    buffers[0] = buffers[1] = NULL;
+    return;
+  }
+#endif
+
+  if (!transport->init())
+    return;
+
+#if V_RENDER_STRIPS
+  strip_ticket[0] = strip_ticket[1] = 0;
+#elif V_INDEXED_COLOR
+  chunk_ticket[0] = chunk_ticket[1] = 0;
+  chunk_next = 0;
+  default_palette();
+  v_frameBuffer = framebuffer;
+#else
+  back = 0;
+  buffer_ticket[0] = buffer_ticket[1] = 0;
+  v_frameBuffer = buffers[back];
+#endif
+  frame_ticket = 0;
+  memset(&stats, 0, sizeof(stats));
+  ready = true;
+
+  gfx_dirty_invalidate();
+}
+
+#if V_RENDER_STRIPS
+
+static bool band_dirty(const gfx_rect_t *rects, int count, int y0, int y1)
 {
-  spi_transaction_t t;
-  memset(&t, 0, sizeof(t));
-  t.length = 8;
-  t.tx_buffer = &cmd;
-  gpio_set_level(PIN_DC, 0);
-  spi_device_polling_transmit(spi, &t);
+  for (int i = 0; i < count; i++)
+    if (rects[i].y < y1 && rects[i].y + rects[i].h > y0)
+      return true;
+  return false;
 }
 
-static void lcd_data(const uint8_t *data, int len)
+void display_present(void)
 {
-  if(len == 0) return;
-  spi_transaction_t t;
-  memset(&t, 0, sizeof(t));
-  t.length = len * 8;
-  t.tx_buffer = data;
-  gpio_set_level(PIN_DC, 1);
-  spi_device_polling_transmit(spi, &t);
+  if (!ready) return;
+
+  display_ticket_t ticket = frame_ticket;
+  int s = 0;
+
+  stats.bytes = 0;
+  stats.rects = 0;
+  TIMED_RESET();
+
+  gfx_rect_t rects[V_DIRTY_MAX_RECTS];
+  int count = gfx_dirty_end_frame(rects, V_DIRTY_MAX_RECTS);
+
+  for (int band = 0; band < V_NUM_BANDS; band++)
+  {
+    int y0 = band * V_DMA_CHUNK_LINES;
+    int h = V_DISPLAY_HEIGHT - y0;
+    if (h > V_DMA_CHUNK_LINES) h = V_DMA_CHUNK_LINES;
+
+    if (!band_dirty(rects, count, y0, y0 + h))
+      continue;
+
+    // Rasterize into this strip while the other one is on the wire
+    TIMED(wait_cycles, transport->wait(strip_ticket[s]));
+    TIMED(render_cycles, gfx_render_band(strips[s], band));
+
+    transport->set_window(0, y0, V_DISPLAY_WIDTH, h);
+    ticket = strip_ticket[s] = transport->queue_pixels(strips[s], V_DISPLAY_WIDTH * h);
+    stats.bytes += WINDOW_BYTES + V_DISPLAY_WIDTH * h * 2;
+    stats.rects++;
+    s ^= 1;
+  }
+
+  if (transport->frame_end) transport->frame_end();
+
+  frame_ticket = ticket;
+  gfx_display_list_reset();
 }
 
-void display_init(void)
+#elif V_INDEXED_COLOR
+
+// Expands one rect through the palette, as many whole rows per chunk buffer
+// as fit, filling one buffer while the other is on the wire
+static display_ticket_t send_expanded(gfx_rect_t r)
 {
-  v_frameBuffer = (uint16_t*)heap_caps_calloc(V_BUFFER_SIZE, sizeof(uint16_t), MALLOC_CAP_DMA);
+  const int rows_per_chunk = V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES / r.w;
+  display_ticket_t ticket = 0;
 
-  if(!v_frameBuffer)
+  transport->set_window(r.x, r.y, r.w, r.h);
+  for (int y = 0; y < r.h; y += rows_per_chunk)
   {
-    ESP_LOGE("Display.h", "Failed to allocate framebuffer");
-    return;
+    int rows = r.h - y < rows_per_chunk ? r.h - y : rows_per_chunk;
+    int c = chunk_next;
+    chunk_next ^= 1;
+
+    TIMED(wait_cycles, transport->wait(chunk_ticket[c]));
+    uint16_t *dst = chunks[c];
+    for (int row = 0; row < rows; row++)
+    {
+      const gfx_pixel_t *src = framebuffer + (r.y + y + row) * V_DISPLAY_WIDTH + r.x;
+      for (int x = 0; x < r.w; x++)
+        *dst++ = palette[src[x]];
+    }
+    ticket = chunk_ticket[c] = transport->queue_pixels(chunks[c], r.w * rows);
   }
 
-  gpio_set_direction(PIN_DC, GPIO_MODE_OUTPUT);
-  gpio_set_direction(PIN_RST, GPIO_MODE_OUTPUT);
-
-  spi_bus_config_t buscfg = {
-    .mosi_io_num = PIN_MOSI,
-    .sclk_io_num = PIN_CLK,
-    .miso_io_num = -1,
-    .quadwp_io_num = -1,
-    .quadhd_io_num = -1,
-    .max_transfer_sz = V_DISPLAY_WIDTH * V_DISPLAY_HEIGHT * 2 + 8
-  };
-
-  spi_device_interface_config_t devcfg = {
-    .clock_speed_hz = V_SPI_SPEED_HZ,
-    .mode = 0,
-    .spics_io_num = PIN_CS,
-    .queue_size = 7,
-    .flags = SPI_DEVICE_HALFDUPLEX,
-  };
-
-  ESP_ERROR_CHECK(spi_bus_initialize(SPI3_HOST, &buscfg, SPI_DMA_CH_AUTO));
-  ESP_ERROR_CHECK(spi_bus_add_device(SPI3_HOST, &devcfg, &spi));
-
-  gpio_set_level(PIN_RST, 0);
-  vTaskDelay(V_RESET_DELAY_MS / portTICK_PERIOD_MS);
-  gpio_set_level(PIN_RST, 1);
-  vTaskDelay(V_RESET_DELAY_MS / portTICK_PERIOD_MS);
-
-  lcd_cmd(CMD_SWRESET);
-  vTaskDelay(V_BOOT_DELAY_MS / portTICK_PERIOD_MS);
-
-  lcd_cmd(CMD_SLPOUT);
-  vTaskDelay(V_BOOT_DELAY_MS / portTICK_PERIOD_MS);
-
-  lcd_cmd(CMD_COLMOD);
-  uint8_t colmod[] = { COLMOD_16BIT };
-  lcd_data(colmod, 1);
-
-  lcd_cmd(CMD_MADCTL);
-  uint8_t madctl[] = { MADCTL_RGB };
-  lcd_data(madctl, 1);
-
-  lcd_cmd(CMD_INVOFF);
-  lcd_cmd(CMD_DISPON);
+  stats.bytes += WINDOW_BYTES + r.w * r.h * 2;
+  stats.rects++;
+  return ticket;
 }
 
-/*
-void display_set_window(int x, int y, int w, int h)
+void display_present(void)
 {
-  uint8_t data[4];
-  
-  uint16_t x_start = x + V_OFFSET_X;
-  uint16_t x_end = x + w - 1 + V_OFFSET_X;
-  uint16_t y_start = y + V_OFFSET_Y;
-  uint16_t y_end = y + h - 1 + V_OFFSET_Y;
-
-  lcd_cmd(CMD_CASET);
-  data[0] = x_start >> 8;
-  data[1] = x_start & 0xFF;
-  data[2] = x_end >> 8;
-  data[3] = x_end & 0xFF;
-  lcd_data(data, 4);
-
-  lcd_cmd(CMD_RASET);
-  data[0] = y_start >> 8;
-  data[1] = y_start & 0xFF;
-  data[2] = y_end >> 8;
-  data[3] = y_end & 0xFF;
-  lcd_data(data, 4);
-
-  lcd_cmd(CMD_RAMWR);
+  if (!ready) return;
+
+  display_ticket_t ticket = frame_ticket;
+
+  stats.bytes = 0;
+  stats.rects = 0;
+  TIMED_RESET();
+
+  gfx_rect_t rects[V_DIRTY_MAX_RECTS];
+  int count = gfx_dirty_end_frame(rects, V_DIRTY_MAX_RECTS);
+  for (int i = 0; i < count; i++)
+    ticket = send_expanded(rects[i]);
+
+  if (transport->frame_end) transport->frame_end();
+
+  frame_ticket = ticket;
 }
 
-void display_push_color(uint16_t color)
+#else
+
+// Full-width rows are contiguous in the framebuffer and go out zero-copy
+static display_ticket_t send_rows(const uint16_t *frame, int y, int h)
 {
-  uint8_t data[2] = {color >> 8, color & 0xFF};
-  lcd_data(data, 2);
+  const int chunk = V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES;
+  const uint16_t *src = frame + y * V_DISPLAY_WIDTH;
+  const int total = V_DISPLAY_WIDTH * h;
+  display_ticket_t ticket = 0;
+
+  transport->set_window(0, y, V_DISPLAY_WIDTH, h);
+  for (int sent = 0; sent < total; sent += chunk)
+  {
+    int count = total - sent;
+    if (count > chunk) count = chunk;
+    ticket = transport->queue_pixels(src + sent, count);
+  }
+
+  stats.bytes += WINDOW_BYTES + total * 2;
+  stats.rects++;
+  return ticket;
 }
 
-void display_push_pixels(uint16_t *colors, int count)
+static display_ticket_t send_packed(const uint16_t *frame, gfx_rect_t r, uint16_t *dst)
 {
-  if (count == 0) return;
-  spi_transaction_t t;
-  memset(&t, 0, sizeof(t));
-  t.length = count * 16;
-  t.tx_buffer = colors;
-
-  gpio_set_level(PIN_DC, 1);
-  spi_device_polling_transmit(spi, &t);
+  for (int row = 0; row < r.h; row++)
+    memcpy(dst + row * r.w, frame + (r.y + row) * V_DISPLAY_WIDTH + r.x, r.w * sizeof(uint16_t));
+
+  transport->set_window(r.x, r.y, r.w, r.h);
+  stats.bytes += WINDOW_BYTES + r.w * r.h * 2;
+  stats.rects++;
+  return transport->queue_pixels(dst, r.w * r.h);
 }
 
-void display_fill_rect(int x, int y, int w, int h, uint16_t color)
+void display_present(void)
 {
-  display_set_window(x, y, w, h);
-  const int chunk_size = w * V_DMA_CHUNK_LINES;
-  uint16_t *buffer = heap_caps_malloc(chunk_size * 2, MALLOC_CAP_DMA);
+  if (!ready) return;
 
-  uint16_t swapped = (color >> 8) | (color << 8);
-  for (int i = 0; i < chunk_size; i++)
-  {
-    buffer[i] = swapped;
-  }
+  const uint16_t *frame = buffers[back];
+  display_ticket_t ticket = frame_ticket;
 
-  int total_pixels = w * h;
-  int pixels_sent = 0;
+  stats.bytes = 0;
+  stats.rects = 0;
+  TIMED_RESET();
 
-  while(pixels_sent < total_pixels)
+  gfx_rect_t rects[V_DIRTY_MAX_RECTS];
+  int count = gfx_dirty_end_frame(rects, V_DIRTY_MAX_RECTS);
+
+  // Small rects are packed into staging, the rest widen to full-width bands
+  int used = 0;
+  for (int i = 0; i < count; i++)
   {
-    int pixels_to_send = total_pixels - pixels_sent;
-    if (pixels_to_send > chunk_size)
+    gfx_rect_t r = rects[i];
+    int pixels = r.w * r.h;
+
+    if (staging[back] && r.w < V_DISPLAY_WIDTH && used + pixels <= V_DIRTY_STAGING_PIXELS)
     {
-      pixels_to_send = chunk_size;
+      ticket = send_packed(frame, r, staging[back] + used);
+      used += pixels;
+    }
+    else
+    {
+      ticket = send_rows(frame, r.y, r.h);
     }
-
-    display_push_pixels(buffer, pixels_to_send);
-    pixels_sent += pixels_to_send;
   }
 
-  free(buffer);
+  if (transport->frame_end) transport->frame_end();
+
+  buffer_ticket[back] = ticket;
+  frame_ticket = ticket;
+
+  // Draw the next frame into the other buffer once its previous frame is out
+  back ^= 1;
+  TIMED(wait_cycles, transport->wait(buffer_ticket[back]));
+  v_frameBuffer = buffers[back];
+}
+
+#endif
+
+void display_wait_vsync(void)
+{
+  if (!transport) return;
+  transport->wait(frame_ticket);
 }
-*/
 
 void display_draw(void)
 {
-  if (!v_frameBuffer) return;
-
-  uint8_t data[4];
-  lcd_cmd(CMD_CASET);
-  data[0] = 0; data[1] = 0 + V_OFFSET_X;
-    data[2] = (V_DISPLAY_WIDTH-1) >> 8; 
-    data[3] = (V_DISPLAY_WIDTH-1) & 0xFF;
-    lcd_data(data, 4);
-
-    lcd_cmd(CMD_RASET);
-    data[0] = 0; data[1] = 0 + V_OFFSET_Y;
-    data[2] = (V_DISPLAY_HEIGHT-1) >> 8; 
-    data[3] = (V_DISPLAY_HEIGHT-1) & 0xFF;
-    lcd_data(data, 4);
-
-    lcd_cmd(CMD_RAMWR);
-
-    spi_transaction_t t;
-    memset(&t, 0, sizeof(t));
-    t.length = V_BUFFER_SIZE * 16; // Total bits
-    t.tx_buffer = v_frameBuffer;
-    
-    gpio_set_level(PIN_DC, 1);
-    // polling_transmit blocks until done (safe). 
-    // Later we can use queue_transmit for async double-buffering!
-    spi_device_polling_transmit(spi, &t);
+  display_present();
+  display_wait_vsync();
+}
+
+const display_stats_t *display_get_stats(void)
+{
+  return &stats;
 }
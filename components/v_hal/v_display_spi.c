@@ -0,0 +1,218 @@
+#include "v_display.h"
+#include "v_config.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+
+
+// Command Reg
+#define CMD_SWRESET 0x01 // Software Reset
+#define CMD_SLPOUT  0x11 // Sleep Out
+#define CMD_INVON   0x21 // Inversion On
+#define CMD_INVOFF  0x20 // Inversion Off
+#define CMD_DISPON  0x29 // Display On
+#define CMD_CASET   0x2A // Column Address Set
+#define CMD_RASET   0x2B // Row Address Set
+#define CMD_RAMWR   0x2C // Memory Write
+#define CMD_MADCTL  0x36 // Memory Access Control (Rotation)
+#define CMD_COLMOD  0x3A // Interface Pixel Format
+
+// Data constants
+#define COLMOD_16BIT 0x05
+#define MADCTL_BGR   0xC8
+#define MADCTL_RGB   0xC0
+
+// D/C level travels with each transaction in t.user
+#define DC_CMD  ((void*)0)
+#define DC_DATA ((void*)1)
+
+
+static spi_device_handle_t spi;
+
+// Ring of in-flight transactions. Descriptors must stay valid until the
+// driver hands them back, so a slot is only reused after its result is read.
+static spi_transaction_t trans[V_SPI_QUEUE_SIZE];
+static display_ticket_t queued = 0;
+static display_ticket_t completed = 0;
+
+static void IRAM_ATTR lcd_pre_transfer(spi_transaction_t *t)
+{
+  gpio_set_level(PIN_DC, (int)t->user);
+}
+
+static void lcd_cmd(const uint8_t cmd)
+{
+  spi_transaction_t t;
+  memset(&t, 0, sizeof(t));
+  t.length = 8;
+  t.tx_buffer = &cmd;
+  t.user = DC_CMD;
+  spi_device_polling_transmit(spi, &t);
+}
+
+static void lcd_data(const uint8_t *data, int len)
+{
+  if(len == 0) return;
+  spi_transaction_t t;
+  memset(&t, 0, sizeof(t));
+  t.length = len * 8;
+  t.tx_buffer = data;
+  t.user = DC_DATA;
+  spi_device_polling_transmit(spi, &t);
+}
+
+static void retire_one(void)
+{
+  spi_transaction_t *done;
+  ESP_ERROR_CHECK(spi_device_get_trans_result(spi, &done, portMAX_DELAY));
+  completed++;
+}
+
+static spi_transaction_t *next_slot(void)
+{
+  if (queued - completed >= V_SPI_QUEUE_SIZE)
+    retire_one();
+
+  spi_transaction_t *t = &trans[queued % V_SPI_QUEUE_SIZE];
+  memset(t, 0, sizeof(*t));
+  return t;
+}
+
+static display_ticket_t queue(spi_transaction_t *t)
+{
+  ESP_ERROR_CHECK(spi_device_queue_trans(spi, t, portMAX_DELAY));
+  return ++queued;
+}
+
+static void queue_small(void *dc, const uint8_t *bytes, int len)
+{
+  spi_transaction_t *t = next_slot();
+  t->flags = SPI_TRANS_USE_TXDATA;
+  t->length = len * 8;
+  memcpy(t->tx_data, bytes, len);
+  t->user = dc;
+  queue(t);
+}
+
+static uint16_t *spi_alloc(int pixels)
+{
+  uint16_t *buf = (uint16_t*)heap_caps_calloc(pixels, sizeof(uint16_t), MALLOC_CAP_DMA);
+  if (!buf)
+    ESP_LOGE("Display.h", "Failed to allocate framebuffer");
+  return buf;
+}
+
+static bool spi_init(void)
+{
+  gpio_set_direction(PIN_DC, GPIO_MODE_OUTPUT);
+  gpio_set_direction(PIN_RST, GPIO_MODE_OUTPUT);
+
+  spi_bus_config_t buscfg = {
+    .mosi_io_num = PIN_MOSI,
+    .sclk_io_num = PIN_CLK,
+    .miso_io_num = -1,
+    .quadwp_io_num = -1,
+    .quadhd_io_num = -1,
+    .max_transfer_sz = V_DISPLAY_WIDTH * V_DMA_CHUNK_LINES * 2 + 8
+  };
+
+  spi_device_interface_config_t devcfg = {
+    .clock_speed_hz = V_SPI_SPEED_HZ,
+    .mode = 0,
+    .spics_io_num = PIN_CS,
+    .queue_size = V_SPI_QUEUE_SIZE,
+    .flags = SPI_DEVICE_HALFDUPLEX,
+    .pre_cb = lcd_pre_transfer,
+  };
+
+  ESP_ERROR_CHECK(spi_bus_initialize(SPI3_HOST, &buscfg, SPI_DMA_CH_AUTO));
+  ESP_ERROR_CHECK(spi_bus_add_device(SPI3_HOST, &devcfg, &spi));
+
+  gpio_set_level(PIN_RST, 0);
+  vTaskDelay(V_RESET_DELAY_MS / portTICK_PERIOD_MS);
+  gpio_set_level(PIN_RST, 1);
+  vTaskDelay(V_RESET_DELAY_MS / portTICK_PERIOD_MS);
+
+  lcd_cmd(CMD_SWRESET);
+  vTaskDelay(V_BOOT_DELAY_MS / portTICK_PERIOD_MS);
+
+  lcd_cmd(CMD_SLPOUT);
+  vTaskDelay(V_BOOT_DELAY_MS / portTICK_PERIOD_MS);
+
+  lcd_cmd(CMD_COLMOD);
+  uint8_t colmod[] = { COLMOD_16BIT };
+  lcd_data(colmod, 1);
+
+  lcd_cmd(CMD_MADCTL);
+  uint8_t madctl[] = { MADCTL_RGB };
+  lcd_data(madctl, 1);
+
+  lcd_cmd(CMD_INVOFF);
+  lcd_cmd(CMD_DISPON);
+
+  return true;
+}
+
+static void spi_set_window(int x, int y, int w, int h)
+{
+  uint8_t data[4];
+
+  uint16_t x_start = x + V_OFFSET_X;
+  uint16_t x_end = x + w - 1 + V_OFFSET_X;
+  uint16_t y_start = y + V_OFFSET_Y;
+  uint16_t y_end = y + h - 1 + V_OFFSET_Y;
+
+  uint8_t cmd = CMD_CASET;
+  queue_small(DC_CMD, &cmd, 1);
+  data[0] = x_start >> 8;
+  data[1] = x_start & 0xFF;
+  data[2] = x_end >> 8;
+  data[3] = x_end & 0xFF;
+  queue_small(DC_DATA, data, 4);
+
+  cmd = CMD_RASET;
+  queue_small(DC_CMD, &cmd, 1);
+  data[0] = y_start >> 8;
+  data[1] = y_start & 0xFF;
+  data[2] = y_end >> 8;
+  data[3] = y_end & 0xFF;
+  queue_small(DC_DATA, data, 4);
+
+  cmd = CMD_RAMWR;
+  queue_small(DC_CMD, &cmd, 1);
+}
+
+static display_ticket_t spi_queue_pixels(const uint16_t *pixels, int count)
+{
+  spi_transaction_t *t = next_slot();
+  t->length = count * 16; // Total bits
+  t->tx_buffer = pixels;
+  t->user = DC_DATA;
+  return queue(t);
+}
+
+static void spi_wait(display_ticket_t ticket)
+{
+  while ((int32_t)(ticket - completed) > 0)
+    retire_one();
+}
+
+static const display_transport_t spi_transport = {
+  .init = spi_init,
+  .alloc = spi_alloc,
+  .set_window = spi_set_window,
+  .queue_pixels = spi_queue_pixels,
+  .wait = spi_wait,
+  .frame_end = NULL,
+};
+
+const display_transport_t *display_default_transport(void)
+{
+  return &spi_transport;
+}
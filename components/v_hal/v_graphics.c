@@ -1,138 +1,1549 @@
 #include "v_graphics.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include "v_colors.h"
 
 
-extern uint16_t *v_frameBuffer;
+extern gfx_pixel_t *v_frameBuffer;
 
-void gfx_clear(uint16_t color)
+// Framebuffer value of a gfx_* colour
+#if V_INDEXED_COLOR
+#define TO_PIXEL(color) ((gfx_pixel_t)(color))
+#else
+#define TO_PIXEL(color) ((gfx_pixel_t)(((color) >> 8) | ((color) << 8)))
+#endif
+
+#if V_DIRTY_RECTS
+
+typedef struct {
+  int x0, y0, x1, y1; // Inclusive
+} box_t;
+
+static box_t dirty[V_DIRTY_MAX_RECTS] = { { 0, 0, V_DISPLAY_WIDTH - 1, V_DISPLAY_HEIGHT - 1 } };
+static int dirty_count = 1; // The panel starts with garbage, first frame goes out in full
+static int dirty_last = 0;
+
+static box_t prev_dirty[V_DIRTY_MAX_RECTS];
+static int prev_count = 0;
+
+static uint16_t last_clear = V_BLACK;
+
+static int box_area(box_t b)
 {
-  if (!v_frameBuffer) return;
+  return (b.x1 - b.x0 + 1) * (b.y1 - b.y0 + 1);
+}
+
+static box_t box_union(box_t a, box_t b)
+{
+  box_t u;
+  u.x0 = a.x0 < b.x0 ? a.x0 : b.x0;
+  u.y0 = a.y0 < b.y0 ? a.y0 : b.y0;
+  u.x1 = a.x1 > b.x1 ? a.x1 : b.x1;
+  u.y1 = a.y1 > b.y1 ? a.y1 : b.y1;
+  return u;
+}
+
+static bool box_contains(box_t a, box_t b)
+{
+  return b.x0 >= a.x0 && b.x1 <= a.x1 && b.y0 >= a.y0 && b.y1 <= a.y1;
+}
+
+static bool box_overlaps(box_t a, box_t b)
+{
+  return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+}
+
+// Pixels sent for nothing if a and b go out as one window
+static int merge_cost(box_t a, box_t b)
+{
+  return box_area(box_union(a, b)) - box_area(a) - box_area(b);
+}
+
+static void box_add(box_t *list, int *count, int max, box_t b)
+{
+  int best = -1;
+  int best_cost = 0;
+
+  for (int i = 0; i < *count; i++)
+  {
+    if (box_contains(list[i], b))
+    {
+      dirty_last = i;
+      return;
+    }
+
+    int cost = merge_cost(list[i], b);
+    if (best < 0 || cost < best_cost)
+    {
+      best = i;
+      best_cost = cost;
+    }
+  }
+
+  if (best >= 0 && (best_cost <= V_DIRTY_MERGE_SLACK || *count == max))
+  {
+    list[best] = box_union(list[best], b);
+    dirty_last = best;
+    return;
+  }
+
+  dirty_last = *count;
+  list[(*count)++] = b;
+}
+
+static void dirty_mark(int x0, int y0, int x1, int y1)
+{
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 >= V_DISPLAY_WIDTH) x1 = V_DISPLAY_WIDTH - 1;
+  if (y1 >= V_DISPLAY_HEIGHT) y1 = V_DISPLAY_HEIGHT - 1;
+  if (x0 > x1 || y0 > y1) return;
+
+  box_add(dirty, &dirty_count, V_DIRTY_MAX_RECTS, (box_t){ x0, y0, x1, y1 });
+}
+
+#define DIRTY_MARK(x0, y0, x1, y1) dirty_mark((x0), (y0), (x1), (y1))
+
+int gfx_dirty_end_frame(gfx_rect_t *out, int max)
+{
+  box_t all[V_DIRTY_MAX_RECTS * 2];
+  int n = 0;
+
+  for (int i = 0; i < prev_count; i++) all[n++] = prev_dirty[i];
+  for (int i = 0; i < dirty_count; i++) all[n++] = dirty[i];
+
+  // Fold anything that overlaps or is cheap to merge, then squeeze to max
+  bool merged = true;
+  while (merged)
+  {
+    merged = false;
+    for (int i = 0; i < n && !merged; i++)
+    {
+      for (int j = i + 1; j < n; j++)
+      {
+        if (box_overlaps(all[i], all[j]) || merge_cost(all[i], all[j]) <= V_DIRTY_MERGE_SLACK)
+        {
+          all[i] = box_union(all[i], all[j]);
+          all[j] = all[--n];
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+
+  while (n > max && n > 1)
+  {
+    int bi = 0, bj = 1;
+    int best = merge_cost(all[0], all[1]);
+    for (int i = 0; i < n; i++)
+      for (int j = i + 1; j < n; j++)
+      {
+        int cost = merge_cost(all[i], all[j]);
+        if (cost < best) { best = cost; bi = i; bj = j; }
+      }
+    all[bi] = box_union(all[bi], all[bj]);
+    all[bj] = all[--n];
+  }
+
+  for (int i = 0; i < n && i < max; i++)
+  {
+    out[i].x = all[i].x0;
+    out[i].y = all[i].y0;
+    out[i].w = all[i].x1 - all[i].x0 + 1;
+    out[i].h = all[i].y1 - all[i].y0 + 1;
+  }
+
+  memcpy(prev_dirty, dirty, sizeof(box_t) * dirty_count);
+  prev_count = dirty_count;
+  dirty_count = 0;
+  dirty_last = 0;
+
+  return n < max ? n : max;
+}
+
+void gfx_dirty_invalidate(void)
+{
+  dirty[0] = (box_t){ 0, 0, V_DISPLAY_WIDTH - 1, V_DISPLAY_HEIGHT - 1 };
+  dirty_count = 1;
+  dirty_last = 0;
+}
+
+#else
+
+#define DIRTY_MARK(x0, y0, x1, y1) ((void)(x0), (void)(y0), (void)(x1), (void)(y1))
+
+int gfx_dirty_end_frame(gfx_rect_t *out, int max)
+{
+  if (max < 1) return 0;
+  out[0] = (gfx_rect_t){ 0, 0, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT };
+  return 1;
+}
+
+void gfx_dirty_invalidate(void)
+{
+}
+
+#endif
+
+// Raster target. The framebuffer path draws straight into v_frameBuffer with
+// compile-time clip rows; the strip path points it at one band at a time.
+#if V_RENDER_STRIPS
+static gfx_pixel_t *target = NULL;
+static int clip_y0 = 0;
+static int clip_y1 = 0;
+#define TARGET  target
+#define CLIP_Y0 clip_y0
+#define CLIP_Y1 clip_y1
+#else
+#define TARGET  v_frameBuffer
+#define CLIP_Y0 0
+#define CLIP_Y1 V_DISPLAY_HEIGHT
+#endif
+
+#if V_PROFILE
+static uint32_t pixel_count = 0;
+#define COUNT_PIXELS(n) (pixel_count += (uint32_t)(n))
+
+uint32_t gfx_pixels_rasterized(void)
+{
+  return pixel_count;
+}
+#else
+#define COUNT_PIXELS(n) ((void)0)
+#endif
+
+#if V_DEPTH_BUFFER
+// 16-bit inverse depth, larger is closer and 0 is infinitely far so a clear is
+// a memset. One sample covers (1 << V_DEPTH_SHIFT)^2 pixels. The strip
+// renderer only needs the band being rasterized.
+#define DEPTH_W (V_DISPLAY_WIDTH >> V_DEPTH_SHIFT)
+#if V_RENDER_STRIPS
+#define DEPTH_ROWS (V_DMA_CHUNK_LINES >> V_DEPTH_SHIFT)
+#else
+#define DEPTH_ROWS (V_DISPLAY_HEIGHT >> V_DEPTH_SHIFT)
+#endif
+
+static uint16_t depth_buffer[DEPTH_W * DEPTH_ROWS];
+
+static inline uint16_t *depth_row(int y)
+{
+  return depth_buffer + ((y - CLIP_Y0) >> V_DEPTH_SHIFT) * DEPTH_W;
+}
+
+static void raster_depth_clear(void)
+{
+  memset(depth_buffer, 0, sizeof(depth_buffer));
+}
+
+uint16_t gfx_depth_from_z(fix16_t z)
+{
+  // V_DEPTH_NEAR / z in 0.16, z at or in front of V_DEPTH_NEAR saturates
+  if (z <= V_DEPTH_NEAR) return 0xFFFF;
+  return (uint16_t)(((uint32_t)V_DEPTH_NEAR << 16) / (uint32_t)z);
+}
+#endif
+
+// Bounds-checked write that does not touch the dirty list, callers mark their own bbox
+static inline void plot(int x, int y, uint16_t color)
+{
+  if (x < 0 || x >= V_DISPLAY_WIDTH || y < CLIP_Y0 || y >= CLIP_Y1) return;
+  COUNT_PIXELS(1);
+
+  TARGET[(y - CLIP_Y0) * V_DISPLAY_WIDTH + x] = TO_PIXEL(color);
+}
+
+static void raster_clear(uint16_t color)
+{
+  const int count = (CLIP_Y1 - CLIP_Y0) * V_DISPLAY_WIDTH;
+
+#if V_INDEXED_COLOR
+  memset(TARGET, TO_PIXEL(color), count);
+#else
   if (color == V_BLACK)
   {
-    memset(v_frameBuffer, 0, V_BUFFER_SIZE * 2);
+    memset(TARGET, 0, count * 2);
   }
   else
   {
-    uint16_t swapped = (color >> 8) | (color << 8);
-    for (int i = 0; i < V_BUFFER_SIZE; i++)
+    uint16_t swapped = TO_PIXEL(color);
+    for (int i = 0; i < count; i++)
     {
-      v_frameBuffer[i] = swapped;
+      TARGET[i] = swapped;
     }
   }
+#endif
 }
 
-void gfx_draw_pixel(int x, int y, uint16_t color)
+// Shade ramps for Gouraud triangles. Entry k is the colour at intensity
+// k / (SHADES - 1) in framebuffer form. Indexed colours already are ramps in
+// the palette; RGB565 ramps are built per channel and cached round robin.
+#if V_INDEXED_COLOR
+#define SHADES V_RAMP_SHADES
+#else
+#define SHADES 32 // One per step of the 5-bit channels
+#endif
+#define RAMP_CACHE 8
+
+typedef struct {
+  uint16_t color;
+  bool valid;
+  gfx_pixel_t shade[SHADES];
+} ramp_t;
+
+static ramp_t ramps[RAMP_CACHE];
+static int ramp_next = 0;
+
+static const gfx_pixel_t *shade_ramp(uint16_t color)
 {
-  if (x < 0 || x >= V_DISPLAY_WIDTH || y < 0 || y >= V_DISPLAY_HEIGHT) return;
+  for (int i = 0; i < RAMP_CACHE; i++)
+  {
+    if (ramps[i].valid && ramps[i].color == color)
+      return ramps[i].shade;
+  }
 
-  v_frameBuffer[y * V_DISPLAY_WIDTH + x] = (color >> 8) | (color << 8);
+  ramp_t *r = &ramps[ramp_next];
+  ramp_next = (ramp_next + 1) % RAMP_CACHE;
+  r->color = color;
+  r->valid = true;
+  for (int k = 0; k < SHADES; k++)
+  {
+#if V_INDEXED_COLOR
+    r->shade[k] = TO_PIXEL(V_RAMP_SHADE(color, k));
+#else
+    int red = (((color >> 11) & 0x1F) * k + (SHADES - 1) / 2) / (SHADES - 1);
+    int green = (((color >> 5) & 0x3F) * k + (SHADES - 1) / 2) / (SHADES - 1);
+    int blue = ((color & 0x1F) * k + (SHADES - 1) / 2) / (SHADES - 1);
+    r->shade[k] = TO_PIXEL((uint16_t)((red << 11) | (green << 5) | blue));
+#endif
+  }
+  return r->shade;
 }
 
-void gfx_draw_line(int x0, int y0, int x1, int y1, uint16_t color)
+// Intensity as a Q.8 ramp position, offset by half a shade so truncating the
+// interpolated value rounds to the nearest shade and the small errors of the
+// plane gradients never step outside the ramp
+static inline int32_t shade_from_intensity(fix16_t i)
 {
-  int dx = abs(x1 - x0);
-  int sx = x0 < x1 ? 1 : -1;
+  if (i < 0) i = 0;
+  if (i > F16_ONE) i = F16_ONE;
+  return (int32_t)(((int64_t)i * (SHADES - 1)) >> 8) + 128;
+}
 
-  int dy = -abs(y1 - y0);
-  int sy = y0 < y1 ? 1 : -1;
+// Lines are walked along their major axis. Step i sits at minor offset
+// floor((2 i dmin + dmaj) / (2 dmaj)), the same pixels as the symmetric
+// Bresenham loop this replaced. Clipping is Liang-Barsky on the integer step
+// parameter: it only narrows the range of i against the screen columns and
+// the target rows, so a clipped line keeps exactly the pixels it had and the
+// loop itself needs no bounds checks.
 
-  int err = dx + dy, e2;
+static inline int64_t floor_div(int64_t a, int64_t b) // b > 0
+{
+  int64_t q = a / b;
+  return q * b > a ? q - 1 : q;
+}
+
+// First step whose minor offset f(i) is >= k
+static inline int64_t line_first_at(int64_t k, int64_t dmaj, int64_t dmin)
+{
+  return -floor_div(-(2 * dmaj * k - dmaj), 2 * dmin);
+}
 
-  while(1)
+// Last step whose minor offset f(i) is <= k
+static inline int64_t line_last_at(int64_t k, int64_t dmaj, int64_t dmin)
+{
+  return floor_div(2 * dmaj * (k + 1) - dmaj - 1, 2 * dmin);
+}
+
+// d0/d1 are depth samples, ignored unless depth is set
+static inline void raster_line_impl(int x0, int y0, int d0, int x1, int y1, int d1, bool depth, uint16_t color)
+{
+  bool x_major = abs(x1 - x0) >= abs(y1 - y0);
+  int64_t a0 = x_major ? x0 : y0, b0 = x_major ? y0 : x0;
+  int64_t dmaj = x_major ? abs(x1 - x0) : abs(y1 - y0);
+  int64_t dmin = x_major ? abs(y1 - y0) : abs(x1 - x0);
+  int sa = (x_major ? x0 < x1 : y0 < y1) ? 1 : -1;
+  int sb = (x_major ? y0 < y1 : x0 < x1) ? 1 : -1;
+  int64_t amin = x_major ? 0 : CLIP_Y0, amax = x_major ? V_DISPLAY_WIDTH - 1 : CLIP_Y1 - 1;
+  int64_t bmin = x_major ? CLIP_Y0 : 0, bmax = x_major ? CLIP_Y1 - 1 : V_DISPLAY_WIDTH - 1;
+
+  // Steps whose major coordinate is inside
+  int64_t i0 = 0, i1 = dmaj;
+  int64_t lo = sa > 0 ? amin - a0 : a0 - amax, hi = sa > 0 ? amax - a0 : a0 - amin;
+  if (lo > i0) i0 = lo;
+  if (hi < i1) i1 = hi;
+
+  // And whose minor coordinate is, f(i) only grows with i
+  int64_t klo = sb > 0 ? bmin - b0 : b0 - bmax, khi = sb > 0 ? bmax - b0 : b0 - bmin;
+  if (dmin == 0)
+  {
+    if (klo > 0 || khi < 0) return;
+  }
+  else
   {
-    gfx_draw_pixel(x0, y0, color);
-    
-    if (x0 == x1 && y0 == y1) break;
-    
-    e2 = 2 * err;
-    if (e2 >= dy)
+    int64_t first = line_first_at(klo, dmaj, dmin), last = line_last_at(khi, dmaj, dmin);
+    if (first > i0) i0 = first;
+    if (last < i1) i1 = last;
+  }
+  if (i0 > i1) return;
+  COUNT_PIXELS(i1 - i0 + 1);
+
+  // Bresenham state at step i0
+  int64_t num = 2 * i0 * dmin + dmaj;
+  int64_t den = dmaj ? 2 * dmaj : 1;
+  int32_t r = (int32_t)(num % den), step_r = (int32_t)(2 * dmin), wrap = (int32_t)den;
+  int a = (int)(a0 + sa * i0), b = (int)(b0 + sb * (num / den));
+  int pa = x_major ? sa : sa * V_DISPLAY_WIDTH, pb = x_major ? sb * V_DISPLAY_WIDTH : sb;
+  gfx_pixel_t *p = TARGET + ((x_major ? b : a) - CLIP_Y0) * V_DISPLAY_WIDTH + (x_major ? a : b);
+  gfx_pixel_t pixel = TO_PIXEL(color);
+
+#if V_DEPTH_BUFFER
+  // Depth steps along the major axis as before, lines pass on equal depth so
+  // edges drawn over their own faces stay visible
+  int32_t dd = dmaj ? ((d1 - d0) * 256) / (int32_t)dmaj : 0;
+  int32_t d = (d0 << 8) + (int32_t)i0 * dd;
+  int x = x_major ? a : b, y = x_major ? b : a;
+  int px = x_major ? sa : 0, py = x_major ? 0 : sa, qx = x_major ? 0 : sb, qy = x_major ? sb : 0;
+#else
+  (void)d0; (void)d1; (void)depth;
+#endif
+
+  for (int64_t i = i0; i <= i1; i++)
+  {
+#if V_DEPTH_BUFFER
+    if (depth)
     {
-      err += dy;
-      x0 += sx;
+      uint16_t *dp = depth_row(y) + (x >> V_DEPTH_SHIFT);
+      uint16_t z = d >> 8;
+      if (z >= *dp)
+      {
+        *dp = z;
+        *p = pixel;
+      }
+      d += dd;
+      x += px;
+      y += py;
     }
+    else
+#endif
+    *p = pixel;
 
-    if (e2 <= dx)
+    p += pa;
+    r += step_r;
+    if (r >= wrap)
     {
-      err += dx;
-      y0 += sy;
+      r -= wrap;
+      p += pb;
+#if V_DEPTH_BUFFER
+      x += qx;
+      y += qy;
+#endif
     }
   }
 }
 
-void gfx_draw_rect(int x, int y, int w, int h, uint16_t color)
+static void raster_line(int x0, int y0, int x1, int y1, uint16_t color)
 {
-  gfx_draw_line(x, y, x + w - 1, y, color);
-  gfx_draw_line(x, y + h - 1, x + w - 1, y + h - 1, color);
-  gfx_draw_line(x, y, x, y + h - 1, color);
-  gfx_draw_line(x + w - 1, y, x + w - 1, y + h - 1, color);
+  raster_line_impl(x0, y0, 0, x1, y1, 0, false, color);
 }
 
-void gfx_fill_rect(int x, int y, int w, int h, uint16_t color)
+#if V_DEPTH_BUFFER
+static void raster_line_depth(int x0, int y0, int d0, int x1, int y1, int d1, uint16_t color)
+{
+  raster_line_impl(x0, y0, d0, x1, y1, d1, true, color);
+}
+#endif
+
+// Rect already clipped to the screen, trimmed to the target rows once
+static void raster_rect(int x, int y, int w, int h, uint16_t color)
 {
-  for (int i = x; i < x + w; i++)
-    for (int j = y; j < y + h; j++)
-      gfx_draw_pixel(i, j, color);
+  int y0 = y < CLIP_Y0 ? CLIP_Y0 : y;
+  int y1 = y + h > CLIP_Y1 ? CLIP_Y1 : y + h;
+  gfx_pixel_t pixel = TO_PIXEL(color);
+  if (y1 > y0) COUNT_PIXELS(w * (y1 - y0));
+
+  for (int j = y0; j < y1; j++)
+  {
+    gfx_pixel_t *row = TARGET + (j - CLIP_Y0) * V_DISPLAY_WIDTH + x;
+    for (int i = 0; i < w; i++)
+      row[i] = pixel;
+  }
 }
 
-static void swap(int *a, int *b) 
-{ 
+static void swap(int *a, int *b)
+{
   int t = *a;
   *a = *b;
   *b = t;
 }
 
-void gfx_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color)
+static inline int16_t clamp16(int v)
+{
+  return v < INT16_MIN ? INT16_MIN : (v > INT16_MAX ? INT16_MAX : v);
+}
+
+// Triangle vertices are snapped to 1/16 pixel (Q12.4). Keeps the edge maths
+// exact in integers; after guard band clipping they fit the int16 slots of
+// the strip display list.
+static inline int32_t fx_to_q4(fix16_t v)
+{
+  return (int32_t)(((int64_t)v + (F16_ONE >> 5)) >> 12);
+}
+
+// Integer coordinates address pixel centres
+static inline int32_t pixel_to_q4(int v)
+{
+  return (int32_t)((int64_t)v * 16 + 8);
+}
+
+static inline int64_t ceil_div(int64_t a, int64_t b) // b > 0
+{
+  int64_t q = a / b;
+  return q * b < a ? q + 1 : q;
+}
+
+// First pixel whose centre is at or after the Q12.4 coordinate v
+static inline int q4_center_ceil(int v)
+{
+  return (v + 7) >> 4;
+}
+
+// Exact edge walker: q is the first pixel whose centre is on or right of the
+// edge at the current row, stepped with a quotient/remainder pair so every row
+// costs two 32-bit adds and no division.
+typedef struct {
+  int32_t q, r, m;
+  int32_t step_q, step_r;
+} edge_t;
+
+static inline edge_t edge_setup(int xa, int ya, int xb, int yb, int py)
+{
+  edge_t e;
+  int32_t d = yb - ya; // > 0
+  e.m = 16 * d;
+
+  // Centre of pixel q is at 16q + 8 >= xa + (yc - ya)(xb - xa) / d
+  int64_t yc = (int64_t)py * 16 + 8;
+  int64_t v = (int64_t)(xa - 8) * d + (yc - ya) * (xb - xa);
+  if (v >= INT32_MIN && v <= INT32_MAX)
+  {
+    // Common case on a 128x160 screen, stays on the 32-bit hardware divider
+    int32_t v32 = (int32_t)v;
+    e.q = v32 / e.m;
+    if (e.q * e.m < v32) e.q++;
+  }
+  else
+  {
+    e.q = (int32_t)ceil_div(v, e.m);
+  }
+  e.r = (int32_t)((int64_t)e.q * e.m - v);
+
+  int32_t s = 16 * (xb - xa);
+  e.step_q = s / e.m;
+  if (e.step_q * e.m > s) e.step_q--;
+  e.step_r = s - e.step_q * e.m;
+  return e;
+}
+
+static inline void edge_step(edge_t *e)
+{
+  e->q += e->step_q;
+  e->r -= e->step_r;
+  if (e->r < 0)
+  {
+    e->q++;
+    e->r += e->m;
+  }
+}
+
+// clip is false for triangles the caller has proven to be on screen
+static inline void fill_span(gfx_pixel_t *row, int x0, int x1, gfx_pixel_t pixel, bool clip)
+{
+  if (clip)
+  {
+    if (x0 < 0) x0 = 0;
+    if (x1 > V_DISPLAY_WIDTH) x1 = V_DISPLAY_WIDTH;
+  }
+  if (x1 > x0) COUNT_PIXELS(x1 - x0);
+
+  for (int x = x0; x < x1; x++)
+    row[x] = pixel;
+}
+
+// s is the Q.16 ramp position at the centre of pixel x0, dsdx its step per
+// pixel; x0 is already clamped to the screen
+static inline void fill_span_shaded(gfx_pixel_t *row, int x0, int x1, int32_t s, int32_t dsdx,
+                                    const gfx_pixel_t *ramp, bool clip)
+{
+  if (clip && x1 > V_DISPLAY_WIDTH) x1 = V_DISPLAY_WIDTH;
+  if (x1 > x0) COUNT_PIXELS(x1 - x0);
+
+  for (int x = x0; x < x1; x++, s += dsdx)
+    row[x] = ramp[s >> 16];
+}
+
+#if V_DEPTH_BUFFER
+// d is the Q.8 depth at the centre of pixel x0, dddx its step per pixel. With
+// a ramp the pixel comes from it as in fill_span_shaded.
+static inline void fill_span_depth(gfx_pixel_t *row, uint16_t *drow, int x0, int x1, int32_t d, int32_t dddx,
+                                   int32_t s, int32_t dsdx, const gfx_pixel_t *ramp, gfx_pixel_t pixel, bool clip)
+{
+  if (clip && x1 > V_DISPLAY_WIDTH) x1 = V_DISPLAY_WIDTH;
+  if (x1 > x0) COUNT_PIXELS(x1 - x0);
+
+  for (int x = x0; x < x1; x++, d += dddx, s += dsdx)
+  {
+    uint16_t z = d >> 8;
+    uint16_t *dp = drow + (x >> V_DEPTH_SHIFT);
+    if (z > *dp)
+    {
+      *dp = z;
+      row[x] = ramp ? ramp[s >> 16] : pixel;
+    }
+  }
+}
+#endif
+
+// Per-pixel x and y steps, in Q.8 units of a, of the screen-space plane
+// through a1..a3 at the Q12.4 vertices; cross is twice the signed area
+static inline void plane_gradient(int64_t a1, int64_t a2, int64_t a3, int x1, int y1, int x2, int y2, int x3, int y3,
+                                  int64_t cross, int64_t *gx, int64_t *gy)
+{
+  int64_t e1 = (a2 - a1) * 256, e2 = (a3 - a1) * 256;
+  *gx = (e1 * (y3 - y1) - e2 * (y2 - y1)) * 16 / cross;
+  *gy = ((int64_t)(x2 - x1) * e2 - (int64_t)(x3 - x1) * e1) * 16 / cross;
+}
+
+// Scanline rasterizer on Q12.4 vertices. Pixels are sampled at their centres
+// with a top-left fill rule, so triangles sharing an edge never overlap or
+// leave gaps. Spans go straight into the target with the colour converted once.
+// With depth the Q.8 inverse depth is interpolated as a screen-space plane and
+// tested per pixel; shaded does the same with the Q.8 ramp positions s1..s3
+// and looks every pixel up in the colour's ramp. The plain path is the same
+// code with both off. Without clip the spans are not clamped to the screen
+// width, rows are still limited to the current target.
+static inline void raster_triangle_impl(int x1, int y1, int x2, int y2, int x3, int y3,
+                                        int d1, int d2, int d3, bool depth,
+                                        int s1, int s2, int s3, bool shaded, bool clip, uint16_t color)
 {
   // y1 <- y2 <- y3
-  if (y1 > y2) 
+  if (y1 > y2)
   {
     swap(&x1, &x2);
     swap(&y1, &y2);
+    swap(&d1, &d2);
+    swap(&s1, &s2);
   }
 
-  if (y1 > y3) 
+  if (y1 > y3)
   {
     swap(&x1, &x3);
     swap(&y1, &y3);
+    swap(&d1, &d3);
+    swap(&s1, &s3);
   }
 
-  if (y2 > y3) 
+  if (y2 > y3)
   {
     swap(&x2, &x3);
     swap(&y2, &y3);
+    swap(&d2, &d3);
+    swap(&s2, &s3);
+  }
+
+  // Rows whose centre lies in [y1, y3)
+  int y_top = q4_center_ceil(y1);
+  int y_mid = q4_center_ceil(y2);
+  int y_end = q4_center_ceil(y3);
+
+  if (y_top < CLIP_Y0) y_top = CLIP_Y0;
+  if (y_end > CLIP_Y1) y_end = CLIP_Y1;
+  if (y_top >= y_end) return;
+
+  // Which side of the long edge the middle vertex is on
+  int64_t cross = (int64_t)(x2 - x1) * (y3 - y1) - (int64_t)(x3 - x1) * (y2 - y1);
+  if (cross == 0) return;
+  bool long_left = cross > 0;
+
+  gfx_pixel_t pixel = TO_PIXEL(color);
+  edge_t lng = edge_setup(x1, y1, x3, y3, y_top);
+
+  const gfx_pixel_t *ramp = NULL;
+  int64_t sgx = 0, sgy = 0;
+  if (shaded)
+  {
+    ramp = shade_ramp(color);
+    plane_gradient(s1, s2, s3, x1, y1, x2, y2, x3, y3, cross, &sgx, &sgy);
+  }
+
+#if V_DEPTH_BUFFER
+  int64_t gx = 0, gy = 0;
+  if (depth)
+    plane_gradient(d1, d2, d3, x1, y1, x2, y2, x3, y3, cross, &gx, &gy);
+#else
+  (void)d1; (void)d2; (void)d3; (void)depth;
+#endif
+
+  int y = y_top;
+  gfx_pixel_t *row = TARGET + (y - CLIP_Y0) * V_DISPLAY_WIDTH;
+
+  for (int half = 0; half < 2; half++)
+  {
+    int stop = half ? y_end : (y_mid < y_end ? y_mid : y_end);
+    if (y >= stop) continue;
+
+    edge_t shrt = half ? edge_setup(x2, y2, x3, y3, y) : edge_setup(x1, y1, x2, y2, y);
+    edge_t *l = long_left ? &lng : &shrt;
+    edge_t *r = long_left ? &shrt : &lng;
+
+    for (; y < stop; y++, row += V_DISPLAY_WIDTH)
+    {
+      int x0 = clip && l->q < 0 ? 0 : l->q;
+      int32_t s = 0;
+      if (shaded)
+        s = (int32_t)(((int64_t)s1 << 8) + (sgx * (16 * x0 + 8 - x1) + sgy * (16 * y + 8 - y1)) / 16);
+
+#if V_DEPTH_BUFFER
+      if (depth)
+      {
+        int64_t d = ((int64_t)d1 << 8) + (gx * (16 * x0 + 8 - x1) + gy * (16 * y + 8 - y1)) / 16;
+        fill_span_depth(row, depth_row(y), x0, r->q, (int32_t)d, (int32_t)gx, s, (int32_t)sgx, ramp, pixel, clip);
+      }
+      else
+#endif
+      if (shaded)
+        fill_span_shaded(row, x0, r->q, s, (int32_t)sgx, ramp, clip);
+      else
+        fill_span(row, l->q, r->q, pixel, clip);
+      edge_step(&lng);
+      edge_step(&shrt);
+    }
+  }
+}
+
+static void raster_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color)
+{
+  raster_triangle_impl(x1, y1, x2, y2, x3, y3, 0, 0, 0, false, 0, 0, 0, false, true, color);
+}
+
+static void raster_triangle_unclipped(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color)
+{
+  raster_triangle_impl(x1, y1, x2, y2, x3, y3, 0, 0, 0, false, 0, 0, 0, false, false, color);
+}
+
+// Shaded triangles are rarer, one copy serves both clip cases
+static void raster_triangle_shaded(int x1, int y1, int x2, int y2, int x3, int y3,
+                                   int s1, int s2, int s3, bool clip, uint16_t color)
+{
+  raster_triangle_impl(x1, y1, x2, y2, x3, y3, 0, 0, 0, false, s1, s2, s3, true, clip, color);
+}
+
+#if V_DEPTH_BUFFER
+static void raster_triangle_depth(int x1, int y1, int x2, int y2, int x3, int y3,
+                                  int d1, int d2, int d3, uint16_t color)
+{
+  raster_triangle_impl(x1, y1, x2, y2, x3, y3, d1, d2, d3, true, 0, 0, 0, false, true, color);
+}
+
+static void raster_triangle_depth_unclipped(int x1, int y1, int x2, int y2, int x3, int y3,
+                                            int d1, int d2, int d3, uint16_t color)
+{
+  raster_triangle_impl(x1, y1, x2, y2, x3, y3, d1, d2, d3, true, 0, 0, 0, false, false, color);
+}
+
+static void raster_triangle_depth_shaded(int x1, int y1, int x2, int y2, int x3, int y3,
+                                         int d1, int d2, int d3, int s1, int s2, int s3,
+                                         bool clip, uint16_t color)
+{
+  raster_triangle_impl(x1, y1, x2, y2, x3, y3, d1, d2, d3, true, s1, s2, s3, true, clip, color);
+}
+#endif
+
+// Q12.4 vertex with its depth sample and Q.8 ramp position. Textured
+// triangles add 1/z in Q8.24 and u/z, v/z in texels Q16.16 times 1/z.
+typedef struct {
+  int32_t x, y, d, s;
+  int32_t w, u, v;
+} clip_vert_t;
+
+// Per-triangle state of the textured spans. The attributes step in Q.8 of
+// their clip_vert_t units, see plane_gradient.
+typedef struct {
+  int64_t gw, gu, gv;
+  int32_t dddx;
+  const void *texels;
+  const uint16_t *colors;
+  int32_t umask, vmask;
+  int wshift;
+} tex_span_t;
+
+// u and v in texels Q16.16 through the reciprocal of the interpolated 1/z
+static inline void tex_at(int64_t w, int64_t uw, int64_t vw, int32_t *u, int32_t *v)
+{
+  w >>= 8;
+  // Far outside the triangle, the sample is never drawn
+  if (w < 256) w = 256;
+  if (w > INT32_MAX) w = INT32_MAX;
+  int64_t z = (int64_t)v_recip((uint32_t)w, 40);
+  *u = (int32_t)(((uw >> 8) * z) >> 16);
+  *v = (int32_t)(((vw >> 8) * z) >> 16);
+}
+
+static inline gfx_pixel_t tex_fetch(const tex_span_t *t, int32_t u, int32_t v, bool palettized)
+{
+  int i = (((v >> 16) & t->vmask) << t->wshift) | ((u >> 16) & t->umask);
+  if (palettized)
+    return TO_PIXEL(t->colors[((const uint8_t *)t->texels)[i]]);
+  return TO_PIXEL(((const uint16_t *)t->texels)[i]);
+}
+
+// w, uw, vw and d are the values at the centre of pixel x0. Exact u and v
+// every V_TEXTURE_SUBSPAN pixels, linear steps between them.
+static inline void fill_span_textured(gfx_pixel_t *row, uint16_t *drow, int x0, int x1, int64_t w, int64_t uw,
+                                      int64_t vw, int32_t d, const tex_span_t *t, bool palettized, bool clip)
+{
+  if (clip && x1 > V_DISPLAY_WIDTH) x1 = V_DISPLAY_WIDTH;
+  if (x1 <= x0) return;
+  COUNT_PIXELS(x1 - x0);
+#if !V_DEPTH_BUFFER
+  (void)drow; (void)d;
+#endif
+
+  int32_t u, v;
+  tex_at(w, uw, vw, &u, &v);
+  for (int x = x0; x < x1;)
+  {
+    int n = x1 - x < V_TEXTURE_SUBSPAN ? x1 - x : V_TEXTURE_SUBSPAN;
+    w += t->gw * n;
+    uw += t->gu * n;
+    vw += t->gv * n;
+    int32_t u_end, v_end;
+    tex_at(w, uw, vw, &u_end, &v_end);
+    int32_t du = n == V_TEXTURE_SUBSPAN ? (u_end - u) / V_TEXTURE_SUBSPAN : (u_end - u) / n;
+    int32_t dv = n == V_TEXTURE_SUBSPAN ? (v_end - v) / V_TEXTURE_SUBSPAN : (v_end - v) / n;
+
+    for (int end = x + n; x < end; x++, u += du, v += dv)
+    {
+#if V_DEPTH_BUFFER
+      uint16_t z = d >> 8;
+      uint16_t *dp = drow + (x >> V_DEPTH_SHIFT);
+      d += t->dddx;
+      if (z <= *dp)
+        continue;
+      *dp = z;
+#endif
+      row[x] = tex_fetch(t, u, v, palettized);
+    }
+    u = u_end;
+    v = v_end;
   }
+}
+
+// Same scanline walk as raster_triangle_impl with the texture attributes
+// interpolated as screen-space planes
+static inline void raster_triangle_textured_impl(const clip_vert_t *a, const clip_vert_t *b, const clip_vert_t *c,
+                                                 const gfx_texture_t *tex, bool palettized, bool clip)
+{
+  const clip_vert_t *t;
+  if (a->y > b->y) { t = a; a = b; b = t; }
+  if (a->y > c->y) { t = a; a = c; c = t; }
+  if (b->y > c->y) { t = b; b = c; c = t; }
+
+  int y_top = q4_center_ceil(a->y);
+  int y_mid = q4_center_ceil(b->y);
+  int y_end = q4_center_ceil(c->y);
+
+  if (y_top < CLIP_Y0) y_top = CLIP_Y0;
+  if (y_end > CLIP_Y1) y_end = CLIP_Y1;
+  if (y_top >= y_end) return;
+
+  int64_t cross = (int64_t)(b->x - a->x) * (c->y - a->y) - (int64_t)(c->x - a->x) * (b->y - a->y);
+  if (cross == 0) return;
+  bool long_left = cross > 0;
+
+  tex_span_t ts = {
+    .texels = tex->texels,
+    .colors = tex->colors,
+    .umask = (1 << tex->width_log2) - 1,
+    .vmask = (1 << tex->height_log2) - 1,
+    .wshift = tex->width_log2,
+  };
+  int64_t wy, uy, vy;
+  plane_gradient(a->w, b->w, c->w, a->x, a->y, b->x, b->y, c->x, c->y, cross, &ts.gw, &wy);
+  plane_gradient(a->u, b->u, c->u, a->x, a->y, b->x, b->y, c->x, c->y, cross, &ts.gu, &uy);
+  plane_gradient(a->v, b->v, c->v, a->x, a->y, b->x, b->y, c->x, c->y, cross, &ts.gv, &vy);
+  int64_t dgy = 0;
+#if V_DEPTH_BUFFER
+  int64_t dgx;
+  plane_gradient(a->d, b->d, c->d, a->x, a->y, b->x, b->y, c->x, c->y, cross, &dgx, &dgy);
+  ts.dddx = (int32_t)dgx;
+#endif
+
+  edge_t lng = edge_setup(a->x, a->y, c->x, c->y, y_top);
+  int y = y_top;
+  gfx_pixel_t *row = TARGET + (y - CLIP_Y0) * V_DISPLAY_WIDTH;
+
+  for (int half = 0; half < 2; half++)
+  {
+    int stop = half ? y_end : (y_mid < y_end ? y_mid : y_end);
+    if (y >= stop) continue;
+
+    edge_t shrt = half ? edge_setup(b->x, b->y, c->x, c->y, y) : edge_setup(a->x, a->y, b->x, b->y, y);
+    edge_t *l = long_left ? &lng : &shrt;
+    edge_t *r = long_left ? &shrt : &lng;
+
+    for (; y < stop; y++, row += V_DISPLAY_WIDTH)
+    {
+      int x0 = clip && l->q < 0 ? 0 : l->q;
+      int64_t ox = 16 * x0 + 8 - a->x, oy = 16 * y + 8 - a->y;
+      int64_t w = (int64_t)a->w * 256 + (ts.gw * ox + wy * oy) / 16;
+      int64_t uw = (int64_t)a->u * 256 + (ts.gu * ox + uy * oy) / 16;
+      int64_t vw = (int64_t)a->v * 256 + (ts.gv * ox + vy * oy) / 16;
+      int32_t d = 0;
+      uint16_t *drow = NULL;
+#if V_DEPTH_BUFFER
+      d = (int32_t)(((int64_t)a->d << 8) + ((int64_t)ts.dddx * ox + dgy * oy) / 16);
+      drow = depth_row(y);
+#else
+      (void)dgy;
+#endif
+      fill_span_textured(row, drow, x0, r->q, w, uw, vw, d, &ts, palettized, clip);
+      edge_step(&lng);
+      edge_step(&shrt);
+    }
+  }
+}
+
+static void raster_triangle_textured(const clip_vert_t *a, const clip_vert_t *b, const clip_vert_t *c,
+                                     const gfx_texture_t *tex, bool clip)
+{
+  if (tex->colors)
+    raster_triangle_textured_impl(a, b, c, tex, true, clip);
+  else
+    raster_triangle_textured_impl(a, b, c, tex, false, clip);
+}
+
+#if V_RENDER_STRIPS
+
+// Display list. Primitives are recorded during the frame and binned to every
+// band of V_DMA_CHUNK_LINES rows they overlap, then replayed one band at a
+// time by gfx_render_band. Bins keep submission order so overdraw matches
+// the framebuffer path.
+
+typedef enum {
+  CMD_PIXEL,
+  CMD_LINE,
+  CMD_RECT,
+  CMD_TRIANGLE,
+  CMD_LINE_DEPTH,
+  CMD_TRIANGLE_DEPTH,
+  CMD_DEPTH_CLEAR,
+  CMD_TRIANGLE_TEXTURED
+} cmd_type_t;
+
+#define CMD_UNCLIPPED 0x80 // Or'ed into triangle types that are known to be on screen
+#define CMD_SHADED    0x40 // Or'ed into triangle types with Gouraud shading
+
+typedef struct {
+  uint8_t type;
+  uint16_t color;
+  int16_t x[3], y[3]; // Pixels, Q12.4 for triangles
+  uint16_t s[3];      // Q.8 ramp positions of shaded triangles, s[0] indexes tex_cmds for textured ones
+#if V_DEPTH_BUFFER
+  uint16_t z[3];
+#endif
+} gfx_cmd_t;
+
+// The texture side of textured triangles, too big for every command to carry
+typedef struct {
+  const gfx_texture_t *tex;
+  int32_t w[3], u[3], v[3];
+} tex_cmd_t;
+
+static tex_cmd_t tex_cmds[V_DISPLAY_LIST_TEXTURED];
+static int tex_count = 0;
+
+#define BIN_NONE 0xFFFF
+
+static gfx_cmd_t cmds[V_DISPLAY_LIST_SIZE];
+static int cmd_count = 0;
+
+static uint16_t bin_cmd[V_DISPLAY_LIST_BINS];
+static uint16_t bin_next[V_DISPLAY_LIST_BINS];
+static int bin_count = 0;
+
+static uint16_t band_head[V_NUM_BANDS];
+static uint16_t band_tail[V_NUM_BANDS];
+
+static uint16_t clear_color = V_BLACK;
+static uint32_t dropped = 0;
+
+static void reset_bands(void)
+{
+  for (int b = 0; b < V_NUM_BANDS; b++)
+    band_head[b] = band_tail[b] = BIN_NONE;
+}
 
-  int total_height = y3 - y1;
+void gfx_display_list_reset(void)
+{
+  cmd_count = 0;
+  bin_count = 0;
+  tex_count = 0;
+  reset_bands();
+}
+
+uint32_t gfx_dropped_commands(void)
+{
+  return dropped;
+}
 
-  if (total_height == 0) return;
+static void record(gfx_cmd_t cmd, int ymin, int ymax)
+{
+  if (ymin < 0) ymin = 0;
+  if (ymax >= V_DISPLAY_HEIGHT) ymax = V_DISPLAY_HEIGHT - 1;
+  if (ymin > ymax) return;
 
-  int i_start = (y1 < 0) ? -y1 : 0;
-  int i_end   = (y1 + total_height > V_DISPLAY_HEIGHT) ? V_DISPLAY_HEIGHT - y1 : total_height;
+  int b0 = ymin / V_DMA_CHUNK_LINES;
+  int b1 = ymax / V_DMA_CHUNK_LINES;
 
-  for(int i = i_start; i < i_end; i++)
+  if (cmd_count == V_DISPLAY_LIST_SIZE || bin_count + (b1 - b0 + 1) > V_DISPLAY_LIST_BINS)
   {
-    int second_half = i > y2 - y1 || y2 == y1;
-    int segment_height = second_half ? y3 - y2 : y2 - y1;
-    
-    if (segment_height == 0) 
-      continue;
+    dropped++;
+    return;
+  }
 
-    float alpha = (float)i / total_height;
-    float beta = (float)(i - (second_half ? y2 - y1 : 0)) / segment_height;
+  // Only the bands: a textured command has already taken its tex_cmds entry
+  if (cmd_count == 0 && bin_count == 0)
+    reset_bands();
 
-    int A_x = x1 + (x3 - x1) * alpha;
-    int B_x = second_half ? x2 + (x3 - x2) * beta : x1 + (x2 - x1) * beta;
+  int idx = cmd_count++;
+  cmds[idx] = cmd;
 
-    if (A_x > B_x) swap(&A_x, &B_x);
+  for (int b = b0; b <= b1; b++)
+  {
+    int e = bin_count++;
+    bin_cmd[e] = idx;
+    bin_next[e] = BIN_NONE;
 
-    if (A_x < 0) A_x = 0;
-    if (B_x >= V_DISPLAY_WIDTH) B_x = V_DISPLAY_WIDTH - 1;
+    if (band_tail[b] == BIN_NONE)
+      band_head[b] = e;
+    else
+      bin_next[band_tail[b]] = e;
+    band_tail[b] = e;
+  }
+}
 
-    for(int j = A_x; j <= B_x; j++)
+static void replay(const gfx_cmd_t *c)
+{
+  switch (c->type)
+  {
+    case CMD_PIXEL:
+      plot(c->x[0], c->y[0], c->color);
+      break;
+    case CMD_LINE:
+      raster_line(c->x[0], c->y[0], c->x[1], c->y[1], c->color);
+      break;
+    case CMD_RECT:
+      raster_rect(c->x[0], c->y[0], c->x[1], c->y[1], c->color);
+      break;
+    case CMD_TRIANGLE:
+      raster_triangle(c->x[0], c->y[0], c->x[1], c->y[1], c->x[2], c->y[2], c->color);
+      break;
+    case CMD_TRIANGLE | CMD_UNCLIPPED:
+      raster_triangle_unclipped(c->x[0], c->y[0], c->x[1], c->y[1], c->x[2], c->y[2], c->color);
+      break;
+    case CMD_TRIANGLE_TEXTURED:
+    case CMD_TRIANGLE_TEXTURED | CMD_UNCLIPPED:
     {
-      gfx_draw_pixel(j, y1 + i, color);
+      const tex_cmd_t *t = &tex_cmds[c->s[0]];
+      clip_vert_t v[3];
+      for (int k = 0; k < 3; k++)
+      {
+#if V_DEPTH_BUFFER
+        v[k] = (clip_vert_t){ c->x[k], c->y[k], c->z[k], 0, t->w[k], t->u[k], t->v[k] };
+#else
+        v[k] = (clip_vert_t){ c->x[k], c->y[k], 0, 0, t->w[k], t->u[k], t->v[k] };
+#endif
+      }
+      raster_triangle_textured(&v[0], &v[1], &v[2], t->tex, !(c->type & CMD_UNCLIPPED));
+      break;
     }
+    case CMD_TRIANGLE | CMD_SHADED:
+    case CMD_TRIANGLE | CMD_SHADED | CMD_UNCLIPPED:
+      raster_triangle_shaded(c->x[0], c->y[0], c->x[1], c->y[1], c->x[2], c->y[2],
+                             c->s[0], c->s[1], c->s[2], !(c->type & CMD_UNCLIPPED), c->color);
+      break;
+#if V_DEPTH_BUFFER
+    case CMD_LINE_DEPTH:
+      raster_line_depth(c->x[0], c->y[0], c->z[0], c->x[1], c->y[1], c->z[1], c->color);
+      break;
+    case CMD_TRIANGLE_DEPTH:
+      raster_triangle_depth(c->x[0], c->y[0], c->x[1], c->y[1], c->x[2], c->y[2],
+                            c->z[0], c->z[1], c->z[2], c->color);
+      break;
+    case CMD_TRIANGLE_DEPTH | CMD_UNCLIPPED:
+      raster_triangle_depth_unclipped(c->x[0], c->y[0], c->x[1], c->y[1], c->x[2], c->y[2],
+                                      c->z[0], c->z[1], c->z[2], c->color);
+      break;
+    case CMD_TRIANGLE_DEPTH | CMD_SHADED:
+    case CMD_TRIANGLE_DEPTH | CMD_SHADED | CMD_UNCLIPPED:
+      raster_triangle_depth_shaded(c->x[0], c->y[0], c->x[1], c->y[1], c->x[2], c->y[2],
+                                   c->z[0], c->z[1], c->z[2], c->s[0], c->s[1], c->s[2],
+                                   !(c->type & CMD_UNCLIPPED), c->color);
+      break;
+    case CMD_DEPTH_CLEAR:
+      raster_depth_clear();
+      break;
+#endif
   }
 }
+
+void gfx_render_band(uint16_t *strip, int band)
+{
+  target = strip;
+  clip_y0 = band * V_DMA_CHUNK_LINES;
+  clip_y1 = clip_y0 + V_DMA_CHUNK_LINES;
+  if (clip_y1 > V_DISPLAY_HEIGHT) clip_y1 = V_DISPLAY_HEIGHT;
+
+  raster_clear(clear_color);
+#if V_DEPTH_BUFFER
+  raster_depth_clear();
+#endif
+
+  if (cmd_count == 0) return;
+
+  for (int e = band_head[band]; e != BIN_NONE; e = bin_next[e])
+    replay(&cmds[bin_cmd[e]]);
+}
+
+#endif
+
+void gfx_clear(uint16_t color)
+{
+#if V_DIRTY_RECTS
+  // Areas nobody draws into only change on the panel if the background does
+  if (color != last_clear)
+    gfx_dirty_invalidate();
+  last_clear = color;
+#endif
+
+#if V_RENDER_STRIPS
+  // Everything recorded so far would be painted over
+  clear_color = color;
+  gfx_display_list_reset();
+#else
+  if (!v_frameBuffer) return;
+  raster_clear(color);
+#endif
+}
+
+void gfx_draw_pixel(int x, int y, uint16_t color)
+{
+  if (x < 0 || x >= V_DISPLAY_WIDTH || y < 0 || y >= V_DISPLAY_HEIGHT) return;
+
+#if V_DIRTY_RECTS
+  // Runs of pixels usually land in the rect that was just grown
+  box_t last = dirty[dirty_last];
+  if (dirty_count == 0 || x < last.x0 || x > last.x1 || y < last.y0 || y > last.y1)
+    dirty_mark(x, y, x, y);
+#endif
+
+#if V_RENDER_STRIPS
+  record((gfx_cmd_t){ .type = CMD_PIXEL, .color = color, .x = { clamp16(x) }, .y = { clamp16(y) } }, y, y);
+#else
+  v_frameBuffer[y * V_DISPLAY_WIDTH + x] = TO_PIXEL(color);
+#endif
+}
+
+// Clipping. Lines entirely off one screen edge are dropped here, the rest are
+// clipped exactly by raster_line. Rects are cut to the screen before they are
+// recorded. Triangles inside the screen go to the unclipped rasterizer, ones
+// inside the guard band only clamp their spans, and the rest are cut to the
+// guard band.
+
+#define OUT_LEFT   1
+#define OUT_RIGHT  2
+#define OUT_TOP    4
+#define OUT_BOTTOM 8
+
+static inline int outcode(int64_t x, int64_t y, int64_t x0, int64_t y0, int64_t x1, int64_t y1)
+{
+  return (x < x0 ? OUT_LEFT : 0) | (x > x1 ? OUT_RIGHT : 0) |
+         (y < y0 ? OUT_TOP : 0) | (y > y1 ? OUT_BOTTOM : 0);
+}
+
+static inline int32_t div_round(int64_t num, int64_t den)
+{
+  if (den < 0)
+  {
+    num = -num;
+    den = -den;
+  }
+  return (int32_t)(num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den));
+}
+
+// Pixels of slack around the screen. Triangles inside it are rasterized as
+// they are; its corners in Q12.4 still fit in int16.
+#define GUARD_BAND 1024
+
+#define SCREEN_X1 (V_DISPLAY_WIDTH * 16)
+#define SCREEN_Y1 (V_DISPLAY_HEIGHT * 16)
+#define GUARD_X0  (-GUARD_BAND * 16)
+#define GUARD_Y0  (-GUARD_BAND * 16)
+#define GUARD_X1  ((V_DISPLAY_WIDTH + GUARD_BAND) * 16)
+#define GUARD_Y1  ((V_DISPLAY_HEIGHT + GUARD_BAND) * 16)
+
+// tex set draws a textured triangle, depth tested whenever there is a depth buffer
+static void emit_triangle(const clip_vert_t *a, const clip_vert_t *b, const clip_vert_t *c,
+                          bool depth, bool shaded, const gfx_texture_t *tex, bool clip, uint16_t color)
+{
+  int min_x = a->x < b->x ? (a->x < c->x ? a->x : c->x) : (b->x < c->x ? b->x : c->x);
+  int max_x = a->x > b->x ? (a->x > c->x ? a->x : c->x) : (b->x > c->x ? b->x : c->x);
+  int min_y = a->y < b->y ? (a->y < c->y ? a->y : c->y) : (b->y < c->y ? b->y : c->y);
+  int max_y = a->y > b->y ? (a->y > c->y ? a->y : c->y) : (b->y > c->y ? b->y : c->y);
+
+  DIRTY_MARK(min_x >> 4, min_y >> 4, max_x >> 4, max_y >> 4);
+
+#if V_RENDER_STRIPS
+  if (tex)
+  {
+    if (tex_count == V_DISPLAY_LIST_TEXTURED)
+    {
+      dropped++;
+      return;
+    }
+    // A command record() drops leaves its tex_cmds entry unused until the reset
+    int t = tex_count++;
+    tex_cmds[t] = (tex_cmd_t){ tex, { a->w, b->w, c->w }, { a->u, b->u, c->u }, { a->v, b->v, c->v } };
+    record((gfx_cmd_t){ .type = clip ? CMD_TRIANGLE_TEXTURED : CMD_TRIANGLE_TEXTURED | CMD_UNCLIPPED,
+                        .x = { a->x, b->x, c->x }, .y = { a->y, b->y, c->y }, .s = { (uint16_t)t },
+#if V_DEPTH_BUFFER
+                        .z = { a->d, b->d, c->d },
+#endif
+                      }, min_y >> 4, max_y >> 4);
+    return;
+  }
+  uint8_t type = (depth ? CMD_TRIANGLE_DEPTH : CMD_TRIANGLE) | (shaded ? CMD_SHADED : 0);
+  record((gfx_cmd_t){ .type = clip ? type : type | CMD_UNCLIPPED, .color = color,
+                      .x = { a->x, b->x, c->x }, .y = { a->y, b->y, c->y },
+                      .s = { a->s, b->s, c->s },
+#if V_DEPTH_BUFFER
+                      .z = { a->d, b->d, c->d },
+#endif
+                    }, min_y >> 4, max_y >> 4);
+#else
+  if (!v_frameBuffer) return;
+  (void)depth;
+  if (tex)
+  {
+    raster_triangle_textured(a, b, c, tex, clip);
+    return;
+  }
+#if V_DEPTH_BUFFER
+  if (depth && shaded)
+  {
+    raster_triangle_depth_shaded(a->x, a->y, b->x, b->y, c->x, c->y, a->d, b->d, c->d, a->s, b->s, c->s,
+                                 clip, color);
+    return;
+  }
+  if (depth)
+  {
+    if (clip)
+      raster_triangle_depth(a->x, a->y, b->x, b->y, c->x, c->y, a->d, b->d, c->d, color);
+    else
+      raster_triangle_depth_unclipped(a->x, a->y, b->x, b->y, c->x, c->y, a->d, b->d, c->d, color);
+    return;
+  }
+#endif
+  if (shaded)
+    raster_triangle_shaded(a->x, a->y, b->x, b->y, c->x, c->y, a->s, b->s, c->s, clip, color);
+  else if (clip)
+    raster_triangle(a->x, a->y, b->x, b->y, c->x, c->y, color);
+  else
+    raster_triangle_unclipped(a->x, a->y, b->x, b->y, c->x, c->y, color);
+#endif
+}
+
+// Point where the edge from inside vertex p to outside vertex q crosses the
+// bound. Always interpolating from the inside end makes the two triangles on
+// a shared edge agree on the new vertex, so clipped meshes stay watertight.
+static clip_vert_t clip_cross(const clip_vert_t *p, const clip_vert_t *q, bool on_y, int32_t bound)
+{
+  int64_t pa = on_y ? p->y : p->x, qa = on_y ? q->y : q->x;
+  int64_t pb = on_y ? p->x : p->y, qb = on_y ? q->x : q->y;
+  int32_t other = (int32_t)(pb + div_round((qb - pb) * (bound - pa), qa - pa));
+  clip_vert_t v;
+  v.x = on_y ? other : bound;
+  v.y = on_y ? bound : other;
+  v.d = p->d + div_round((int64_t)(q->d - p->d) * (bound - pa), qa - pa);
+  v.s = p->s + div_round((int64_t)(q->s - p->s) * (bound - pa), qa - pa);
+  v.w = p->w + div_round(((int64_t)q->w - p->w) * (bound - pa), qa - pa);
+  v.u = p->u + div_round(((int64_t)q->u - p->u) * (bound - pa), qa - pa);
+  v.v = p->v + div_round(((int64_t)q->v - p->v) * (bound - pa), qa - pa);
+  return v;
+}
+
+// Sutherland-Hodgman step: keeps the part of the polygon on the inside of
+// one guard band edge. keep_above keeps coordinates >= bound.
+static int clip_polygon(const clip_vert_t *in, int n, clip_vert_t *out, bool on_y, bool keep_above, int32_t bound)
+{
+  int m = 0;
+  for (int i = 0; i < n; i++)
+  {
+    const clip_vert_t *p = &in[i], *q = &in[i + 1 < n ? i + 1 : 0];
+    int32_t pa = on_y ? p->y : p->x, qa = on_y ? q->y : q->x;
+    bool p_in = keep_above ? pa >= bound : pa <= bound;
+    bool q_in = keep_above ? qa >= bound : qa <= bound;
+
+    if (p_in)
+      out[m++] = *p;
+    if (p_in != q_in)
+      out[m++] = p_in ? clip_cross(p, q, on_y, bound) : clip_cross(q, p, on_y, bound);
+  }
+  return m;
+}
+
+static void fill_triangle_clip(const clip_vert_t v[3], bool depth, bool shaded, const gfx_texture_t *tex,
+                               uint16_t color)
+{
+  int s0 = outcode(v[0].x, v[0].y, 0, 0, SCREEN_X1, SCREEN_Y1);
+  int s1 = outcode(v[1].x, v[1].y, 0, 0, SCREEN_X1, SCREEN_Y1);
+  int s2 = outcode(v[2].x, v[2].y, 0, 0, SCREEN_X1, SCREEN_Y1);
+
+  if (s0 & s1 & s2) return;
+  if (!(s0 | s1 | s2))
+  {
+    emit_triangle(&v[0], &v[1], &v[2], depth, shaded, tex, false, color);
+    return;
+  }
+
+  int g0 = outcode(v[0].x, v[0].y, GUARD_X0, GUARD_Y0, GUARD_X1, GUARD_Y1);
+  int g1 = outcode(v[1].x, v[1].y, GUARD_X0, GUARD_Y0, GUARD_X1, GUARD_Y1);
+  int g2 = outcode(v[2].x, v[2].y, GUARD_X0, GUARD_Y0, GUARD_X1, GUARD_Y1);
+  int g = g0 | g1 | g2;
+
+  if (!g)
+  {
+    emit_triangle(&v[0], &v[1], &v[2], depth, shaded, tex, true, color);
+    return;
+  }
+
+  // A triangle gains at most one vertex per edge it is cut against
+  clip_vert_t a[7], b[7];
+  int n = 3;
+  memcpy(a, v, 3 * sizeof(clip_vert_t));
+  if (n && (g & OUT_LEFT))   { n = clip_polygon(a, n, b, false, true, GUARD_X0);  memcpy(a, b, n * sizeof(*a)); }
+  if (n && (g & OUT_RIGHT))  { n = clip_polygon(a, n, b, false, false, GUARD_X1); memcpy(a, b, n * sizeof(*a)); }
+  if (n && (g & OUT_TOP))    { n = clip_polygon(a, n, b, true, true, GUARD_Y0);   memcpy(a, b, n * sizeof(*a)); }
+  if (n && (g & OUT_BOTTOM)) { n = clip_polygon(a, n, b, true, false, GUARD_Y1);  memcpy(a, b, n * sizeof(*a)); }
+
+  for (int i = 1; i + 1 < n; i++)
+    emit_triangle(&a[0], &a[i], &a[i + 1], depth, shaded, tex, true, color);
+}
+
+void gfx_draw_line(int x0, int y0, int x1, int y1, uint16_t color)
+{
+  const int xmax = V_DISPLAY_WIDTH - 1, ymax = V_DISPLAY_HEIGHT - 1;
+  if (outcode(x0, y0, 0, 0, xmax, ymax) & outcode(x1, y1, 0, 0, xmax, ymax)) return;
+
+  int min_y = y0 < y1 ? y0 : y1;
+  int max_y = y0 > y1 ? y0 : y1;
+
+  DIRTY_MARK(x0 < x1 ? x0 : x1, min_y, x0 > x1 ? x0 : x1, max_y);
+
+  // Both paths see the same int16 endpoints, that keeps the stepping in 32 bits
+  x0 = clamp16(x0); y0 = clamp16(y0);
+  x1 = clamp16(x1); y1 = clamp16(y1);
+
+#if V_RENDER_STRIPS
+  record((gfx_cmd_t){ .type = CMD_LINE, .color = color, .x = { x0, x1 }, .y = { y0, y1 } }, min_y, max_y);
+#else
+  if (!v_frameBuffer) return;
+  raster_line(x0, y0, x1, y1, color);
+#endif
+}
+
+void gfx_draw_rect(int x, int y, int w, int h, uint16_t color)
+{
+  gfx_draw_line(x, y, x + w - 1, y, color);
+  gfx_draw_line(x, y + h - 1, x + w - 1, y + h - 1, color);
+  gfx_draw_line(x, y, x, y + h - 1, color);
+  gfx_draw_line(x + w - 1, y, x + w - 1, y + h - 1, color);
+}
+
+void gfx_fill_rect(int x, int y, int w, int h, uint16_t color)
+{
+  int x1 = x + w, y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > V_DISPLAY_WIDTH) x1 = V_DISPLAY_WIDTH;
+  if (y1 > V_DISPLAY_HEIGHT) y1 = V_DISPLAY_HEIGHT;
+  if (x >= x1 || y >= y1) return;
+  w = x1 - x;
+  h = y1 - y;
+
+  DIRTY_MARK(x, y, x1 - 1, y1 - 1);
+
+#if V_RENDER_STRIPS
+  record((gfx_cmd_t){ .type = CMD_RECT, .color = color, .x = { x, w }, .y = { y, h } }, y, y1 - 1);
+#else
+  if (!v_frameBuffer) return;
+  raster_rect(x, y, w, h, color);
+#endif
+}
+
+void gfx_fill_triangle_fx(fix16_t x1, fix16_t y1, fix16_t x2, fix16_t y2, fix16_t x3, fix16_t y3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), 0 }, { fx_to_q4(x2), fx_to_q4(y2), 0 },
+                       { fx_to_q4(x3), fx_to_q4(y3), 0 } };
+  fill_triangle_clip(v, false, false, NULL, color);
+}
+
+void gfx_fill_triangle_fx_unclipped(fix16_t x1, fix16_t y1, fix16_t x2, fix16_t y2, fix16_t x3, fix16_t y3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), 0 }, { fx_to_q4(x2), fx_to_q4(y2), 0 },
+                       { fx_to_q4(x3), fx_to_q4(y3), 0 } };
+  emit_triangle(&v[0], &v[1], &v[2], false, false, NULL, false, color);
+}
+
+void gfx_fill_triangle_shaded(fix16_t x1, fix16_t y1, fix16_t i1, fix16_t x2, fix16_t y2, fix16_t i2,
+                              fix16_t x3, fix16_t y3, fix16_t i3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), 0, shade_from_intensity(i1) },
+                       { fx_to_q4(x2), fx_to_q4(y2), 0, shade_from_intensity(i2) },
+                       { fx_to_q4(x3), fx_to_q4(y3), 0, shade_from_intensity(i3) } };
+  fill_triangle_clip(v, false, true, NULL, color);
+}
+
+void gfx_fill_triangle_shaded_unclipped(fix16_t x1, fix16_t y1, fix16_t i1, fix16_t x2, fix16_t y2, fix16_t i2,
+                                        fix16_t x3, fix16_t y3, fix16_t i3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), 0, shade_from_intensity(i1) },
+                       { fx_to_q4(x2), fx_to_q4(y2), 0, shade_from_intensity(i2) },
+                       { fx_to_q4(x3), fx_to_q4(y3), 0, shade_from_intensity(i3) } };
+  emit_triangle(&v[0], &v[1], &v[2], false, true, NULL, false, color);
+}
+
+// 1/z in Q8.24, z kept off zero
+static inline int32_t tex_w(fix16_t z)
+{
+  if (z < F16_ONE / 64) z = F16_ONE / 64;
+  return (int32_t)v_recip((uint32_t)z, 40);
+}
+
+static void tex_verts(const gfx_tex_vertex_t in[3], clip_vert_t out[3])
+{
+  for (int k = 0; k < 3; k++)
+  {
+    int32_t w = tex_w(in[k].z);
+    out[k] = (clip_vert_t){
+      .x = fx_to_q4(in[k].x),
+      .y = fx_to_q4(in[k].y),
+#if V_DEPTH_BUFFER
+      .d = gfx_depth_from_z(in[k].z),
+#endif
+      .w = w,
+      .u = (int32_t)(((int64_t)in[k].u * w) >> 24),
+      .v = (int32_t)(((int64_t)in[k].v * w) >> 24),
+    };
+  }
+}
+
+void gfx_fill_triangle_textured(const gfx_tex_vertex_t v[3], const gfx_texture_t *tex)
+{
+  clip_vert_t cv[3];
+  tex_verts(v, cv);
+  fill_triangle_clip(cv, V_DEPTH_BUFFER, false, tex, 0);
+}
+
+void gfx_fill_triangle_textured_unclipped(const gfx_tex_vertex_t v[3], const gfx_texture_t *tex)
+{
+  clip_vert_t cv[3];
+  tex_verts(v, cv);
+  emit_triangle(&cv[0], &cv[1], &cv[2], V_DEPTH_BUFFER, false, tex, false, 0);
+}
+
+void gfx_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color)
+{
+  clip_vert_t v[3] = { { pixel_to_q4(x1), pixel_to_q4(y1), 0 }, { pixel_to_q4(x2), pixel_to_q4(y2), 0 },
+                       { pixel_to_q4(x3), pixel_to_q4(y3), 0 } };
+  fill_triangle_clip(v, false, false, NULL, color);
+}
+
+#if V_DEPTH_BUFFER
+
+void gfx_depth_clear(void)
+{
+#if V_RENDER_STRIPS
+  record((gfx_cmd_t){ .type = CMD_DEPTH_CLEAR }, 0, V_DISPLAY_HEIGHT - 1);
+#else
+  raster_depth_clear();
+#endif
+}
+
+void gfx_fill_triangle_depth(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t x2, fix16_t y2, fix16_t z2,
+                             fix16_t x3, fix16_t y3, fix16_t z3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), gfx_depth_from_z(z1) },
+                       { fx_to_q4(x2), fx_to_q4(y2), gfx_depth_from_z(z2) },
+                       { fx_to_q4(x3), fx_to_q4(y3), gfx_depth_from_z(z3) } };
+  fill_triangle_clip(v, true, false, NULL, color);
+}
+
+void gfx_fill_triangle_depth_unclipped(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t x2, fix16_t y2, fix16_t z2,
+                                       fix16_t x3, fix16_t y3, fix16_t z3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), gfx_depth_from_z(z1) },
+                       { fx_to_q4(x2), fx_to_q4(y2), gfx_depth_from_z(z2) },
+                       { fx_to_q4(x3), fx_to_q4(y3), gfx_depth_from_z(z3) } };
+  emit_triangle(&v[0], &v[1], &v[2], true, false, NULL, false, color);
+}
+
+void gfx_fill_triangle_depth_shaded(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t i1,
+                                    fix16_t x2, fix16_t y2, fix16_t z2, fix16_t i2,
+                                    fix16_t x3, fix16_t y3, fix16_t z3, fix16_t i3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), gfx_depth_from_z(z1), shade_from_intensity(i1) },
+                       { fx_to_q4(x2), fx_to_q4(y2), gfx_depth_from_z(z2), shade_from_intensity(i2) },
+                       { fx_to_q4(x3), fx_to_q4(y3), gfx_depth_from_z(z3), shade_from_intensity(i3) } };
+  fill_triangle_clip(v, true, true, NULL, color);
+}
+
+void gfx_fill_triangle_depth_shaded_unclipped(fix16_t x1, fix16_t y1, fix16_t z1, fix16_t i1,
+                                              fix16_t x2, fix16_t y2, fix16_t z2, fix16_t i2,
+                                              fix16_t x3, fix16_t y3, fix16_t z3, fix16_t i3, uint16_t color)
+{
+  clip_vert_t v[3] = { { fx_to_q4(x1), fx_to_q4(y1), gfx_depth_from_z(z1), shade_from_intensity(i1) },
+                       { fx_to_q4(x2), fx_to_q4(y2), gfx_depth_from_z(z2), shade_from_intensity(i2) },
+                       { fx_to_q4(x3), fx_to_q4(y3), gfx_depth_from_z(z3), shade_from_intensity(i3) } };
+  emit_triangle(&v[0], &v[1], &v[2], true, true, NULL, false, color);
+}
+
+void gfx_draw_line_depth(fix16_t x0, fix16_t y0, fix16_t z0, fix16_t x1, fix16_t y1, fix16_t z1, uint16_t color)
+{
+  int px0 = F16_TO_INT(x0), py0 = F16_TO_INT(y0);
+  int px1 = F16_TO_INT(x1), py1 = F16_TO_INT(y1);
+  const int xmax = V_DISPLAY_WIDTH - 1, ymax = V_DISPLAY_HEIGHT - 1;
+  if (outcode(px0, py0, 0, 0, xmax, ymax) & outcode(px1, py1, 0, 0, xmax, ymax)) return;
+
+  uint16_t d0 = gfx_depth_from_z(z0), d1 = gfx_depth_from_z(z1);
+
+  int min_y = py0 < py1 ? py0 : py1;
+  int max_y = py0 > py1 ? py0 : py1;
+
+  DIRTY_MARK(px0 < px1 ? px0 : px1, min_y, px0 > px1 ? px0 : px1, max_y);
+
+  px0 = clamp16(px0); py0 = clamp16(py0);
+  px1 = clamp16(px1); py1 = clamp16(py1);
+
+#if V_RENDER_STRIPS
+  record((gfx_cmd_t){ .type = CMD_LINE_DEPTH, .color = color, .x = { px0, px1 },
+                     .y = { py0, py1 }, .z = { d0, d1 } }, min_y, max_y);
+#else
+  if (!v_frameBuffer) return;
+  raster_line_depth(px0, py0, d0, px1, py1, d1, color);
+#endif
+}
+
+#endif
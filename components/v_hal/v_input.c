@@ -1,55 +1,60 @@
 #include "v_input.h"
 #include "v_config.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "driver/gpio.h"
 
-static volatile uint8_t input_state = 0;
+// head and tail wrap at 2^32, which the slot index only follows for a power of two
+#if V_INPUT_QUEUE_SIZE & (V_INPUT_QUEUE_SIZE - 1)
+#error "V_INPUT_QUEUE_SIZE must be a power of two"
+#endif
 
-#define PIN_A     BUTTON_1
-#define PIN_B     BUTTON_2
-#define PIN_UP    BUTTON_3
-#define PIN_DOWN  BUTTON_4
-#define PIN_LEFT  BUTTON_5
-#define PIN_RIGHT BUTTON_6
+// Single-producer/single-consumer ring. The backend fills a slot and then
+// publishes head, the reader copies a slot out and then publishes tail;
+// each index has one writer, so neither side locks or waits on the other.
+static input_event_t queue[V_INPUT_QUEUE_SIZE];
+static uint32_t head = 0;
+static uint32_t tail = 0;
+static volatile uint8_t level = 0;
+static volatile uint32_t dropped = 0;
 
-void input_task(void *pvParameter)
+void input_init(void)
 {
-  while(1)
-  {
-    uint8_t current_state = 0;
+  head = 0;
+  tail = 0;
+  level = 0;
+  dropped = 0;
+  input_backend_init();
+}
 
-    if(!gpio_get_level(PIN_UP)) current_state |= INPUT_UP;
-    if(!gpio_get_level(PIN_DOWN)) current_state |= INPUT_DOWN;
-    if(!gpio_get_level(PIN_LEFT)) current_state |= INPUT_LEFT;
-    if(!gpio_get_level(PIN_RIGHT)) current_state |= INPUT_RIGHT;
-    if(!gpio_get_level(PIN_A)) current_state |= INPUT_A;
-    if(!gpio_get_level(PIN_B)) current_state |= INPUT_B;
+uint8_t input_get(void)
+{
+  return level;
+}
 
-    input_state = current_state;
+void input_push_event(uint8_t button, bool pressed, int64_t time_us)
+{
+  // The level is right even when the event itself has to be dropped
+  level = pressed ? (level | button) : (level & ~button);
 
-    vTaskDelay(10 / portTICK_PERIOD_MS);
+  uint32_t h = head;
+  if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= V_INPUT_QUEUE_SIZE)
+  {
+    dropped++;
+    return;
   }
+  queue[h % V_INPUT_QUEUE_SIZE] = (input_event_t){ .time_us = time_us, .button = button, .pressed = pressed };
+  __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
 }
 
-void input_init(void)
+bool input_poll_event(input_event_t *ev)
 {
-  gpio_config_t io_conf = {
-    .intr_type = GPIO_INTR_DISABLE,
-    .mode = GPIO_MODE_INPUT,
-    .pull_down_en = 0,
-    .pull_up_en = 1,
-    .pin_bit_mask = (1ULL << PIN_UP) | (1ULL << PIN_DOWN) |
-                    (1ULL << PIN_LEFT) | (1ULL << PIN_RIGHT) |
-                    (1ULL << PIN_A) | (1ULL << PIN_B)
-  };
-
-  gpio_config(&io_conf);
-
-  xTaskCreate(input_task, "InputTask", 2048, NULL, 5, NULL);
+  uint32_t t = tail;
+  if (t == __atomic_load_n(&head, __ATOMIC_ACQUIRE))
+    return false;
+  *ev = queue[t % V_INPUT_QUEUE_SIZE];
+  __atomic_store_n(&tail, t + 1, __ATOMIC_RELEASE);
+  return true;
 }
 
-uint8_t input_get(void)
+uint32_t input_dropped_events(void)
 {
-  return input_state;
+  return dropped;
 }
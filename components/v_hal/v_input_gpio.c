@@ -0,0 +1,91 @@
+#include "v_input.h"
+#include "v_config.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+
+// Buttons pull their pin low. Each edge interrupt takes the new level at
+// once, then mutes the pin for V_INPUT_DEBOUNCE_US while the contacts
+// bounce; when the timer runs out the pin is sampled again, which catches a
+// release (or press) that happened inside the window.
+
+static const struct {
+  gpio_num_t pin;
+  uint8_t button;
+} buttons[] = {
+  { BUTTON_1, INPUT_A },
+  { BUTTON_2, INPUT_B },
+  { BUTTON_3, INPUT_UP },
+  { BUTTON_4, INPUT_DOWN },
+  { BUTTON_5, INPUT_LEFT },
+  { BUTTON_6, INPUT_RIGHT },
+};
+
+#define NUM_BUTTONS ((int)(sizeof(buttons) / sizeof(buttons[0])))
+
+static esp_timer_handle_t settle_timers[NUM_BUTTONS];
+static uint8_t taken = 0; // levels already queued, one bit per button
+
+// The edge ISR and the settle timer task both push, the lock keeps them to
+// one producer at a time
+static portMUX_TYPE push_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void take_level(int b, int64_t now)
+{
+  uint8_t bit = buttons[b].button;
+  bool pressed = !gpio_get_level(buttons[b].pin);
+  if (pressed == !!(taken & bit))
+    return;
+  taken ^= bit;
+  input_push_event(bit, pressed, now);
+}
+
+static void button_isr(void *arg)
+{
+  int b = (int)(intptr_t)arg;
+  int64_t now = esp_timer_get_time();
+
+  gpio_intr_disable(buttons[b].pin);
+  portENTER_CRITICAL_ISR(&push_lock);
+  take_level(b, now);
+  portEXIT_CRITICAL_ISR(&push_lock);
+  esp_timer_start_once(settle_timers[b], V_INPUT_DEBOUNCE_US);
+}
+
+static void settle(void *arg)
+{
+  int b = (int)(intptr_t)arg;
+
+  portENTER_CRITICAL(&push_lock);
+  take_level(b, esp_timer_get_time());
+  portEXIT_CRITICAL(&push_lock);
+  gpio_intr_enable(buttons[b].pin);
+}
+
+void input_backend_init(void)
+{
+  uint64_t mask = 0;
+  for (int b = 0; b < NUM_BUTTONS; b++)
+    mask |= 1ULL << buttons[b].pin;
+
+  gpio_config_t io_conf = {
+    .intr_type = GPIO_INTR_ANYEDGE,
+    .mode = GPIO_MODE_INPUT,
+    .pull_down_en = 0,
+    .pull_up_en = 1,
+    .pin_bit_mask = mask
+  };
+  gpio_config(&io_conf);
+
+  gpio_install_isr_service(0);
+  taken = 0;
+  for (int b = 0; b < NUM_BUTTONS; b++)
+  {
+    esp_timer_create_args_t args = { .callback = settle, .arg = (void *)(intptr_t)b, .name = "input" };
+    esp_timer_create(&args, &settle_timers[b]);
+
+    // A button held through boot is queued as a press straight away
+    take_level(b, esp_timer_get_time());
+    gpio_isr_handler_add(buttons[b].pin, button_isr, (void *)(intptr_t)b);
+  }
+}
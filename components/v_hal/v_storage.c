@@ -0,0 +1,46 @@
+#include "v_storage.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+
+typedef struct {
+  const esp_partition_t *part;
+  const void *data;
+} mapping_t;
+
+static mapping_t maps[V_STORAGE_MAX_MAPS];
+
+const void *storage_map(const char *name, size_t *size)
+{
+  const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                         ESP_PARTITION_SUBTYPE_ANY, name);
+  if(!part)
+    return NULL;
+
+  mapping_t *slot = NULL;
+  for(int i = 0; i < V_STORAGE_MAX_MAPS; i++)
+  {
+    if(maps[i].part == part)
+    {
+      *size = part->size;
+      return maps[i].data;
+    }
+    if(!maps[i].part && !slot)
+      slot = &maps[i];
+  }
+  if(!slot)
+    return NULL;
+
+  // Flash goes through the data cache MMU, reads cost no DRAM
+  const void *data;
+  esp_partition_mmap_handle_t handle;
+  if(esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &data, &handle) != ESP_OK)
+  {
+    ESP_LOGE("Storage", "Failed to map partition %s", name);
+    return NULL;
+  }
+
+  slot->part = part;
+  slot->data = data;
+  *size = part->size;
+  return data;
+}
@@ -0,0 +1,43 @@
+#include "v_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+
+void timer_init(void)
+{
+  // esp_timer is started by the IDF before app_main
+}
+
+int64_t timer_get_us(void)
+{
+  return esp_timer_get_time();
+}
+
+uint32_t timer_get_cycles(void)
+{
+  return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+uint32_t timer_cycles_per_us(void)
+{
+  return esp_rom_get_cpu_ticks_per_us();
+}
+
+void timer_sleep_us(int64_t us)
+{
+  if (us <= 0)
+    return;
+
+  int64_t until = esp_timer_get_time() + us;
+  TickType_t ticks = (TickType_t)(us / (portTICK_PERIOD_MS * 1000));
+  if (ticks)
+    vTaskDelay(ticks);
+  while (esp_timer_get_time() < until) { }
+}
+
+void timer_yield(void)
+{
+  vTaskDelay(1);
+}
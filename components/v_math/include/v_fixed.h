@@ -12,7 +12,7 @@ typedef int32_t fix16_t;
         
 
 #define FLT_TO_F16(x) ((fix16_t)((x) * 65536.0f))
-#define INT_TO_F16(x) ((fix16_t)((x) << F16_SHIFT))
+#define INT_TO_F16(x) ((fix16_t)((x) * F16_ONE))
 #define F16_TO_INT(x) ((x) >> F16_SHIFT)
 #define F16_TO_FLT(x) ((float)(x) / 65536.0f)
 
@@ -27,13 +27,30 @@ static inline fix16_t f16_mul(fix16_t a, fix16_t b)
   return (fix16_t)(((int64_t)a * b) >> F16_SHIFT);
 }
 
-static inline fix16_t f16_div(fix16_t a, fix16_t b)
-{
-  // (A << 16) / B
-  return (fix16_t)(((int64_t)a << F16_SHIFT) / b);
-}
+// Division-free kernels: a table seed refined by two Newton-Raphson steps,
+// then a multiply-only fix-up that makes the result exact.
+// f16_div truncates toward zero like (a << 16) / b and f16_recip(x) equals
+// f16_div(F16_ONE, x). Results outside the fix16_t range, including b == 0,
+// saturate to INT32_MAX / INT32_MIN.
+fix16_t f16_div(fix16_t a, fix16_t b);
+fix16_t f16_recip(fix16_t x);
+
+// 2^bits / x for x > 0 and bits <= 62, from the same seed and Newton steps
+// but without the fix-up: a few counts low in the top 30 bits. No divide and
+// no loop, for reciprocals taken per pixel.
+uint64_t v_recip(uint32_t x, int bits);
+
+// floor(sqrt(x)) and floor(1 / sqrt(x)) in Q16.16, both exact.
+// f16_sqrt returns 0 and f16_rsqrt returns INT32_MAX for x <= 0.
+fix16_t f16_sqrt(fix16_t x);
+fix16_t f16_rsqrt(fix16_t x);
 
 fix16_t v_sin(fix16_t theta);
 fix16_t v_cos(fix16_t theta);
+fix16_t v_tan(fix16_t theta); // INT32_MAX at a quarter turn either way
+
+// Same for Q16.16 angles (fractions of the 256 units), interpolated
+fix16_t v_sin_fx(fix16_t theta);
+fix16_t v_cos_fx(fix16_t theta);
 
 #endif
@@ -15,10 +15,26 @@ mat4_t mat4_rotate_x(fix16_t angle);
 mat4_t mat4_rotate_y(fix16_t angle);
 mat4_t mat4_rotate_z(fix16_t angle);
 
-mat4_t mat4_perspective(fix16_t fov, fix16_t aspect, fix16_t near, fix16_t far); // Camera lens creates a perspective proj
+// Fused builders: rot.y about y, then rot.x about x, then rot.z about z
+// (Ry * Rx * Rz, how entities are turned), written straight from the sine
+// table. 12 multiplies, 4 with rot.z == 0, against 128 for two mat4_mul.
+// rotation_from_euler fills the 3x3 part of any matrix with 4 columns, a
+// mat4_t or a mat34_t, scaled by scale (F16_ONE skips the scaling).
+void rotation_from_euler(fix16_t (*m)[4], vec3_t rot, fix16_t scale);
+mat4_t mat4_rotate_euler(vec3_t rot);
+void mat4_compose(mat4_t *out, vec3_t rot, fix16_t scale, vec3_t pos); // rotated, scaled, then moved to pos
+
+// Camera lens creates a perspective proj. fov is the vertical field of view in
+// angle units (256 per turn), w comes out as view-space z
+mat4_t mat4_perspective(fix16_t fov, fix16_t aspect, fix16_t near, fix16_t far);
 
 mat4_t mat4_mul(mat4_t a, mat4_t b);
 
 vec3_t mat4_mul_vec3(mat4_t m, vec3_t v);
 
+// Same as above without copying 64-byte matrices through the stack.
+// out may not alias a or b.
+void mat4_mul_into(mat4_t *out, const mat4_t *a, const mat4_t *b);
+vec3_t mat4_transform(const mat4_t *m, vec3_t v);
+
 #endif
@@ -0,0 +1,35 @@
+#ifndef V_QUAT_H
+#define V_QUAT_H
+
+#include "v_matrix.h"
+
+// Rotation as a unit quaternion in Q16.16. Turning by small steps keeps
+// full precision where accumulating whole-unit angles would not, and
+// orientations compose without building matrices. Angles are Q16.16 angle
+// units (256 per turn, see v_sin_fx).
+typedef struct {
+  fix16_t w, x, y, z;
+} quat_t;
+
+quat_t quat_identity(void);
+
+quat_t quat_from_axis_angle(vec3_t axis, fix16_t angle); // axis unit length
+quat_t quat_from_euler(vec3_t rot);                      // same rotation as mat4_rotate_euler
+
+quat_t quat_mul(quat_t a, quat_t b); // rotating by a * b is rotating by b, then a
+quat_t quat_normalize(quat_t q);
+
+// q turned by angle about axis in its own (object) frame, renormalized so
+// repeated steps do not drift
+quat_t quat_rotate(quat_t q, vec3_t axis, fix16_t angle);
+
+// Spherical interpolation, t in [0, 1], the short way round. Close
+// orientations fall back to a normalized lerp, which is as good there.
+quat_t quat_slerp(quat_t a, quat_t b, fix16_t t);
+
+// 3x3 part of a matrix with 4 columns, as rotation_from_euler. 9 multiplies
+// and 9 more with scale != F16_ONE.
+void rotation_from_quat(fix16_t (*m)[4], quat_t q, fix16_t scale);
+mat4_t quat_to_mat4(quat_t q);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef V_TRANSFORM_H
+#define V_TRANSFORM_H
+
+#include <stdint.h>
+#include "v_matrix.h"
+#include "v_quat.h"
+
+// Affine 3x4 transform: rotation/scale in columns 0-2, translation in
+// column 3. The bottom row is implicitly (0, 0, 0, 1), so there is no w.
+typedef struct {
+  fix16_t m[3][4];
+} mat34_t;
+
+void mat34_from_mat4(mat34_t *out, const mat4_t *m); // drops the bottom row
+void mat34_mul(mat34_t *out, const mat34_t *a, const mat34_t *b); // out = a * b, out may not alias
+
+// Placement of an object: rotated by rot (see rotation_from_euler) or q,
+// scaled by scale, then moved to pos. No matrix products.
+void mat34_compose(mat34_t *out, vec3_t rot, fix16_t scale, vec3_t pos);
+void mat34_from_quat(mat34_t *out, quat_t q, fix16_t scale, vec3_t pos);
+
+vec3_t mat34_transform(const mat34_t *m, vec3_t v);   // full transform, for points
+vec3_t mat34_rotate(const mat34_t *m, vec3_t v);      // 3x3 part only, for directions
+vec3_t mat34_untransform(const mat34_t *m, vec3_t v); // inverse of a rotation + translation m
+
+// Per-vertex clip flags. Past the projection limit sx/sy would leave the
+// Q16.16 range, those vertices are flagged by side and their sx/sy are not
+// usable; the caller clips their faces in view space.
+#define OUTCODE_NEAR   0x01 // z < near, sx/sy were projected as if z were near
+#define OUTCODE_LEFT   0x02 // sx < cx - PROJECT_LIMIT
+#define OUTCODE_RIGHT  0x04 // sx > cx + PROJECT_LIMIT
+#define OUTCODE_TOP    0x08 // sy < cy - PROJECT_LIMIT
+#define OUTCODE_BOTTOM 0x10 // sy > cy + PROJECT_LIMIT
+#define PROJECT_LIMIT  16384 // pixels from the centre, far outside any guard band
+
+// Pinhole projection: sx = x * focal / z + cx
+typedef struct {
+  fix16_t focal;
+  fix16_t cx, cy;
+  fix16_t near;
+} projection_t;
+
+// Caller-owned structure-of-arrays output, each array holds count entries
+typedef struct {
+  fix16_t *x, *y, *z;   // view space
+  fix16_t *sx, *sy;     // screen space, Q16.16 pixels
+  uint8_t *outcode;
+} vertex_soa_t;
+
+// Transforms count vertices by m and projects them with one divide per
+// vertex. Returns the OR of all outcodes, so 0 means nothing was clamped.
+uint8_t transform_project(const mat34_t *m, const projection_t *proj,
+                          const vec3_t *in, int count, const vertex_soa_t *out);
+
+// Same for in[list[0..count-1]] only, results land at the same indices
+uint8_t transform_project_list(const mat34_t *m, const projection_t *proj, const vec3_t *in,
+                               const uint16_t *list, int count, const vertex_soa_t *out);
+
+// View frustum in view space: left, right, top, bottom and near planes, all
+// facing inwards with unit normals. There is no far plane. inner is the same
+// volume shrunk by a pixel on screen, anything inside it projects on screen
+// even after rounding.
+#define FRUSTUM_PLANES 5
+
+typedef struct {
+  plane_t outer[FRUSTUM_PLANES];
+  plane_t inner[FRUSTUM_PLANES];
+} frustum_t;
+
+typedef enum {
+  CULL_OUTSIDE,  // nothing of the volume is visible
+  CULL_PARTIAL,  // may cross a screen edge or the near plane
+  CULL_INSIDE    // every point projects on screen with z >= near
+} cull_t;
+
+// Frustum of proj over a width x height pixel viewport
+void frustum_from_projection(frustum_t *f, const projection_t *proj, int width, int height);
+
+// Sphere given by its centre in view space
+cull_t frustum_test_sphere(const frustum_t *f, vec3_t center, fix16_t radius);
+
+// Object space box [min, max] placed in view space by the rigid transform m,
+// tighter than the sphere for long thin meshes
+cull_t frustum_test_box(const frustum_t *f, const mat34_t *m, vec3_t min, vec3_t max);
+
+// The frustum as seen from the space that the rigid transform m places in
+// view space, so many boxes there can be tested without transforming each
+void frustum_to_object(frustum_t *out, const frustum_t *f, const mat34_t *m);
+
+// Box [min, max] aligned with the frustum's own axes
+cull_t frustum_test_aabb(const frustum_t *f, vec3_t min, vec3_t max);
+
+#endif
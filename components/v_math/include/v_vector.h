@@ -15,6 +15,12 @@ typedef struct{
   fix16_t x, y, z;
 }vec3_t;
 
+// Plane n.p + d = 0, n is unit length. Points with n.p + d > 0 are in front
+typedef struct{
+  vec3_t n;
+  fix16_t d;
+}plane_t;
+
 vec3_t vec3_add(vec3_t a, vec3_t b);
 vec3_t vec3_sub(vec3_t a, vec3_t b);
 vec3_t vec3_mul(vec3_t v, fix16_t scalar);
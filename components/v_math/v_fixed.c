@@ -1,4 +1,5 @@
 #include "v_fixed.h"
+#include <stdbool.h>
 
 // Sine Lookup Table (0 to 255 representing 0 to 360 deg)
 static const fix16_t SIN_LUT[256] = {
@@ -31,3 +32,173 @@ fix16_t v_cos(fix16_t theta)
 {
   return SIN_LUT[(theta + 64) & 0xFF];
 }
+
+// Linear between neighbouring entries, within 1e-4 of the true sine
+fix16_t v_sin_fx(fix16_t theta)
+{
+  int i = (theta >> 16) & 0xFF;
+  fix16_t a = SIN_LUT[i], b = SIN_LUT[(i + 1) & 0xFF];
+  return f16_add(a, f16_mul(f16_sub(b, a), theta & 0xFFFF));
+}
+
+fix16_t v_cos_fx(fix16_t theta)
+{
+  return v_sin_fx(f16_add(theta, INT_TO_F16(64)));
+}
+
+// tan over the first quarter turn, the rest follows by symmetry
+static const fix16_t TAN_LUT[64] = {
+    0, 1609, 3220, 4834, 6455, 8083, 9721, 11372, 13036, 14717, 16416, 18136, 19880, 21650, 23449, 25280,
+    27146, 29050, 30996, 32988, 35030, 37126, 39281, 41500, 43790, 46156, 48605, 51145, 53784, 56532, 59398, 62395,
+    65536, 68835, 72308, 75974, 79856, 83977, 88365, 93054, 98082, 103493, 109340, 115687, 122609, 130198, 138564, 147847,
+    158218, 169896, 183161, 198380, 216043, 236817, 261634, 291845, 329472, 377693, 441808, 531352, 665398, 888450, 1334016, 2669641
+};
+
+fix16_t v_tan(fix16_t theta)
+{
+  int t = theta & 0x7F; // period of half a turn
+  if(t < 64)
+    return TAN_LUT[t];
+  if(t == 64)
+    return INT32_MAX;
+  return -TAN_LUT[128 - t];
+}
+
+// 1/m for m in [0.5, 1) in 128 bins, Q1.15, seeds for the reciprocal
+static const uint16_t RECIP_LUT[128] = {
+    65281, 64777, 64281, 63792, 63310, 62836, 62369, 61909, 61455, 61008, 60568, 60133, 59705, 59283, 58867, 58457,
+    58053, 57654, 57260, 56872, 56489, 56111, 55738, 55370, 55007, 54649, 54295, 53946, 53601, 53261, 52925, 52593,
+    52265, 51942, 51622, 51306, 50995, 50686, 50382, 50081, 49784, 49490, 49200, 48913, 48630, 48349, 48072, 47798,
+    47528, 47260, 46995, 46733, 46474, 46218, 45965, 45714, 45467, 45222, 44979, 44739, 44502, 44267, 44035, 43805,
+    43577, 43352, 43129, 42908, 42690, 42474, 42260, 42048, 41838, 41631, 41425, 41222, 41020, 40820, 40623, 40427,
+    40233, 40041, 39851, 39662, 39476, 39291, 39108, 38926, 38746, 38568, 38392, 38217, 38044, 37872, 37702, 37533,
+    37366, 37200, 37036, 36873, 36712, 36552, 36393, 36236, 36080, 35926, 35772, 35620, 35470, 35320, 35172, 35026,
+    34880, 34735, 34592, 34450, 34309, 34169, 34031, 33893, 33757, 33622, 33487, 33354, 33222, 33091, 32961, 32832
+};
+
+// 1/sqrt(m) for m in [0.25, 1) in 192 bins, Q1.15
+static const uint16_t RSQRT_LUT[192] = {
+    65282, 64782, 64293, 63815, 63347, 62890, 62442, 62004, 61575, 61155, 60743, 60339, 59943, 59555, 59175, 58802,
+    58435, 58076, 57722, 57376, 57035, 56701, 56372, 56049, 55731, 55419, 55112, 54810, 54513, 54221, 53933, 53650,
+    53371, 53097, 52827, 52561, 52298, 52040, 51786, 51535, 51288, 51044, 50804, 50567, 50333, 50103, 49876, 49652,
+    49430, 49212, 48997, 48784, 48574, 48367, 48163, 47961, 47761, 47564, 47370, 47178, 46988, 46800, 46615, 46432,
+    46251, 46072, 45895, 45720, 45547, 45376, 45207, 45040, 44875, 44712, 44550, 44390, 44232, 44075, 43920, 43767,
+    43615, 43465, 43316, 43169, 43024, 42880, 42737, 42596, 42456, 42317, 42180, 42044, 41910, 41776, 41644, 41514,
+    41384, 41256, 41129, 41003, 40878, 40754, 40632, 40510, 40390, 40270, 40152, 40035, 39919, 39803, 39689, 39576,
+    39464, 39352, 39242, 39133, 39024, 38916, 38810, 38704, 38599, 38494, 38391, 38289, 38187, 38086, 37986, 37887,
+    37788, 37690, 37593, 37497, 37401, 37307, 37213, 37119, 37027, 36935, 36843, 36753, 36663, 36573, 36485, 36397,
+    36309, 36222, 36136, 36051, 35966, 35882, 35798, 35715, 35632, 35550, 35469, 35388, 35307, 35228, 35148, 35070,
+    34991, 34914, 34837, 34760, 34684, 34608, 34533, 34458, 34384, 34310, 34237, 34164, 34092, 34020, 33949, 33878,
+    33807, 33737, 33668, 33599, 33530, 33461, 33393, 33326, 33259, 33192, 33126, 33060, 32994, 32929, 32864, 32800
+};
+
+// m is Q0.32 with the top bit set, returns 1/m in Q2.30.
+// The seed is good to 2^-9, each Newton step y = y * (2 - m * y) doubles that.
+static uint32_t recip_q30(uint32_t m)
+{
+  uint32_t y = (uint32_t)RECIP_LUT[(m >> 24) - 128] << 15;
+  for(int i = 0; i < 2; i++)
+  {
+    uint32_t e = (uint32_t)(((uint64_t)m * y) >> 32);
+    y = (uint32_t)(((uint64_t)y * ((2u << 30) - e)) >> 30);
+  }
+  return y;
+}
+
+// m is Q0.32 in [0.25, 1), returns 1/sqrt(m) in Q2.30.
+// Newton step y = y * (3 - m * y^2) / 2, from a 2^-9 seed.
+static uint32_t rsqrt_q30(uint32_t m)
+{
+  uint32_t y = (uint32_t)RSQRT_LUT[(m >> 24) - 64] << 15;
+  for(int i = 0; i < 2; i++)
+  {
+    uint32_t y2 = (uint32_t)(((uint64_t)y * y) >> 30);
+    uint32_t e = (uint32_t)(((uint64_t)m * y2) >> 32);
+    y = (uint32_t)(((uint64_t)y * ((3u << 30) - e)) >> 31);
+  }
+  return y;
+}
+
+static fix16_t saturate(bool negative)
+{
+  return negative ? INT32_MIN : INT32_MAX;
+}
+
+fix16_t f16_div(fix16_t a, fix16_t b)
+{
+  bool negative = (a < 0) != (b < 0);
+  if(b == 0)
+    return saturate(a < 0);
+
+  uint32_t ua = a < 0 ? 0u - (uint32_t)a : (uint32_t)a;
+  uint32_t ub = b < 0 ? 0u - (uint32_t)b : (uint32_t)b;
+
+  // ub = m * 2^(32 - n), so ua / ub in Q16.16 is ua * (1/m) >> (46 - n)
+  int n = __builtin_clz(ub);
+  uint64_t q = ((uint64_t)ua * recip_q30(ub << n)) >> (46 - n);
+  if(q > 0xFFFFFFFFu)
+    return saturate(negative);
+
+  // The estimate is a few counts off at most, step it to the exact floor
+  uint64_t num = (uint64_t)ua << F16_SHIFT;
+  while(q * ub > num)
+    q--;
+  while((q + 1) * ub <= num)
+    q++;
+
+  if(q > (negative ? 0x80000000u : 0x7FFFFFFFu))
+    return saturate(negative);
+  return negative ? (fix16_t)(0u - (uint32_t)q) : (fix16_t)q;
+}
+
+fix16_t f16_recip(fix16_t x)
+{
+  return f16_div(F16_ONE, x);
+}
+
+uint64_t v_recip(uint32_t x, int bits)
+{
+  // x = m * 2^(n - 32) with m in [0.5, 1), so 2^bits / x = (1/m) * 2^(bits + n - 32)
+  int n = __builtin_clz(x);
+  int shift = 62 - bits - n;
+  uint64_t r = recip_q30(x << n);
+  return shift >= 0 ? r >> shift : r << -shift;
+}
+
+fix16_t f16_sqrt(fix16_t x)
+{
+  if(x <= 0)
+    return 0;
+
+  // Even normalisation shift so the square root halves it exactly
+  uint32_t u = (uint32_t)x;
+  int n = __builtin_clz(u) & ~1;
+  uint32_t m = u << n;
+  uint32_t s = (uint32_t)(((uint64_t)m * rsqrt_q30(m)) >> 32); // sqrt(m), Q2.30
+  uint64_t r = s >> (6 + n / 2);
+
+  uint64_t t = (uint64_t)u << F16_SHIFT;
+  while(r * r > t)
+    r--;
+  while((r + 1) * (r + 1) <= t)
+    r++;
+  return (fix16_t)r;
+}
+
+fix16_t f16_rsqrt(fix16_t x)
+{
+  if(x <= 0)
+    return INT32_MAX;
+
+  uint32_t u = (uint32_t)x;
+  int n = __builtin_clz(u) & ~1;
+  uint64_t r = rsqrt_q30(u << n) >> (22 - n / 2);
+
+  // floor(2^24 / sqrt(u)) is the largest r with r^2 * u <= 2^48
+  const uint64_t one = 1ull << 48;
+  while(r * r * u > one)
+    r--;
+  while((r + 1) * (r + 1) * u <= one)
+    r++;
+  return (fix16_t)r;
+}
@@ -17,7 +17,7 @@ mat4_t mat4_translate(fix16_t tx, fix16_t ty, fix16_t tz)
   mat4_t m = mat4_identity();
   m.m[0][3] = tx;
   m.m[1][3] = ty;
-  m.m[2][3] = tx;
+  m.m[2][3] = tz;
   return m;
 }
 
@@ -57,16 +57,65 @@ mat4_t mat4_rotate_y(fix16_t angle)
   return m;
 }
 
+void rotation_from_euler(fix16_t (*m)[4], vec3_t rot, fix16_t scale)
+{
+  fix16_t cx = v_cos(rot.x), sx = v_sin(rot.x);
+  fix16_t cy = v_cos(rot.y), sy = v_sin(rot.y);
+
+  // Ry * Rx
+  fix16_t sysx = f16_mul(sy, sx), cysx = f16_mul(cy, sx);
+  m[0][0] = cy;  m[0][1] = sysx; m[0][2] = f16_mul(sy, cx);
+  m[1][0] = 0;   m[1][1] = cx;   m[1][2] = -sx;
+  m[2][0] = -sy; m[2][1] = cysx; m[2][2] = f16_mul(cy, cx);
+
+  // * Rz mixes the first two columns
+  if(rot.z & 0xFF)
+  {
+    fix16_t cz = v_cos(rot.z), sz = v_sin(rot.z);
+    for(int r = 0; r < 3; r++)
+    {
+      fix16_t a = m[r][0], b = m[r][1];
+      m[r][0] = f16_add(f16_mul(a, cz), f16_mul(b, sz));
+      m[r][1] = f16_add(f16_mul(a, -sz), f16_mul(b, cz));
+    }
+  }
+
+  if(scale != F16_ONE)
+  {
+    for(int r = 0; r < 3; r++)
+    {
+      for(int c = 0; c < 3; c++)
+        m[r][c] = f16_mul(m[r][c], scale);
+    }
+  }
+}
+
+mat4_t mat4_rotate_euler(vec3_t rot)
+{
+  mat4_t m = mat4_identity();
+  rotation_from_euler(m.m, rot, F16_ONE);
+  return m;
+}
+
+void mat4_compose(mat4_t *out, vec3_t rot, fix16_t scale, vec3_t pos)
+{
+  rotation_from_euler(out->m, rot, scale);
+  out->m[0][3] = pos.x;
+  out->m[1][3] = pos.y;
+  out->m[2][3] = pos.z;
+  out->m[3][0] = 0;
+  out->m[3][1] = 0;
+  out->m[3][2] = 0;
+  out->m[3][3] = F16_ONE;
+}
 
 mat4_t mat4_perspective(fix16_t fov, fix16_t aspect, fix16_t near, fix16_t far)
 {
   mat4_t m;
   memset(&m, 0, sizeof(m));
-  // Scale factor based fov
+  // cot(fov / 2), the focal length in units of half the viewport height
+  fix16_t fov_scale = f16_recip(v_tan(fov / 2));
 
-  // Need to implement tan for this instead of sin
-  fix16_t fov_scale = f16_div(F16_ONE, v_sin(f16_div(fov, INT_TO_F16(2))));
-  
   m.m[0][0] = f16_div(fov_scale, aspect);
   m.m[1][1] = fov_scale;
   m.m[2][2] = f16_div(far, f16_sub(far, near));
@@ -77,33 +126,38 @@ mat4_t mat4_perspective(fix16_t fov, fix16_t aspect, fix16_t near, fix16_t far)
   return m;
 }
 
-mat4_t mat4_mul(mat4_t a, mat4_t b)
+void mat4_mul_into(mat4_t *out, const mat4_t *a, const mat4_t *b)
 {
-  mat4_t m;
   for(int r = 0; r < 4; r++)
   {
     for(int c = 0; c < 4; c++)
     {
-      m.m[r][c] = f16_add(
-                f16_add(f16_mul(a.m[r][0], b.m[0][c]), f16_mul(a.m[r][1], b.m[1][c])),
-                f16_add(f16_mul(a.m[r][2], b.m[2][c]), f16_mul(a.m[r][3], b.m[3][c]))
+      out->m[r][c] = f16_add(
+                f16_add(f16_mul(a->m[r][0], b->m[0][c]), f16_mul(a->m[r][1], b->m[1][c])),
+                f16_add(f16_mul(a->m[r][2], b->m[2][c]), f16_mul(a->m[r][3], b->m[3][c]))
             );
     }
   }
+}
+
+mat4_t mat4_mul(mat4_t a, mat4_t b)
+{
+  mat4_t m;
+  mat4_mul_into(&m, &a, &b);
   return m;
 }
 
-vec3_t mat4_mul_vec3(mat4_t m, vec3_t v) 
+vec3_t mat4_transform(const mat4_t *m, vec3_t v)
 {
     vec3_t res;
-    res.x = f16_add(f16_add(f16_mul(m.m[0][0], v.x), f16_mul(m.m[0][1], v.y)), f16_add(f16_mul(m.m[0][2], v.z), m.m[0][3]));
-    res.y = f16_add(f16_add(f16_mul(m.m[1][0], v.x), f16_mul(m.m[1][1], v.y)), f16_add(f16_mul(m.m[1][2], v.z), m.m[1][3]));
-    res.z = f16_add(f16_add(f16_mul(m.m[2][0], v.x), f16_mul(m.m[2][1], v.y)), f16_add(f16_mul(m.m[2][2], v.z), m.m[2][3]));
-    
+    res.x = f16_add(f16_add(f16_mul(m->m[0][0], v.x), f16_mul(m->m[0][1], v.y)), f16_add(f16_mul(m->m[0][2], v.z), m->m[0][3]));
+    res.y = f16_add(f16_add(f16_mul(m->m[1][0], v.x), f16_mul(m->m[1][1], v.y)), f16_add(f16_mul(m->m[1][2], v.z), m->m[1][3]));
+    res.z = f16_add(f16_add(f16_mul(m->m[2][0], v.x), f16_mul(m->m[2][1], v.y)), f16_add(f16_mul(m->m[2][2], v.z), m->m[2][3]));
+
     // Perspective Divide (The W component)
-    fix16_t w = f16_add(f16_add(f16_mul(m.m[3][0], v.x), f16_mul(m.m[3][1], v.y)), f16_add(f16_mul(m.m[3][2], v.z), m.m[3][3]));
+    fix16_t w = f16_add(f16_add(f16_mul(m->m[3][0], v.x), f16_mul(m->m[3][1], v.y)), f16_add(f16_mul(m->m[3][2], v.z), m->m[3][3]));
 
-    if (w != 0 && w != F16_ONE) 
+    if (w != 0 && w != F16_ONE)
     {
         res.x = f16_div(res.x, w);
         res.y = f16_div(res.y, w);
@@ -111,3 +165,8 @@ vec3_t mat4_mul_vec3(mat4_t m, vec3_t v)
     }
     return res;
 }
+
+vec3_t mat4_mul_vec3(mat4_t m, vec3_t v)
+{
+  return mat4_transform(&m, v);
+}
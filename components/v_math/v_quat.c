@@ -0,0 +1,130 @@
+#include "v_quat.h"
+
+quat_t quat_identity(void)
+{
+  return (quat_t){ F16_ONE, 0, 0, 0 };
+}
+
+quat_t quat_from_axis_angle(vec3_t axis, fix16_t angle)
+{
+  fix16_t half = angle / 2;
+  fix16_t s = v_sin_fx(half);
+  return (quat_t){ v_cos_fx(half), f16_mul(axis.x, s), f16_mul(axis.y, s), f16_mul(axis.z, s) };
+}
+
+quat_t quat_from_euler(vec3_t rot)
+{
+  quat_t qy = quat_from_axis_angle((vec3_t){ 0, F16_ONE, 0 }, INT_TO_F16(rot.y));
+  quat_t qx = quat_from_axis_angle((vec3_t){ F16_ONE, 0, 0 }, INT_TO_F16(rot.x));
+  quat_t qz = quat_from_axis_angle((vec3_t){ 0, 0, F16_ONE }, INT_TO_F16(rot.z));
+  return quat_mul(quat_mul(qy, qx), qz);
+}
+
+quat_t quat_mul(quat_t a, quat_t b)
+{
+  quat_t q;
+  q.w = f16_sub(f16_sub(f16_mul(a.w, b.w), f16_mul(a.x, b.x)), f16_add(f16_mul(a.y, b.y), f16_mul(a.z, b.z)));
+  q.x = f16_add(f16_add(f16_mul(a.w, b.x), f16_mul(a.x, b.w)), f16_sub(f16_mul(a.y, b.z), f16_mul(a.z, b.y)));
+  q.y = f16_add(f16_sub(f16_mul(a.w, b.y), f16_mul(a.x, b.z)), f16_add(f16_mul(a.y, b.w), f16_mul(a.z, b.x)));
+  q.z = f16_add(f16_add(f16_mul(a.w, b.z), f16_mul(a.x, b.y)), f16_sub(f16_mul(a.z, b.w), f16_mul(a.y, b.x)));
+  return q;
+}
+
+static fix16_t quat_dot(quat_t a, quat_t b)
+{
+  return f16_add(f16_add(f16_mul(a.w, b.w), f16_mul(a.x, b.x)), f16_add(f16_mul(a.y, b.y), f16_mul(a.z, b.z)));
+}
+
+quat_t quat_normalize(quat_t q)
+{
+  fix16_t n = quat_dot(q, q);
+  if(n <= 0)
+    return quat_identity();
+  fix16_t r = f16_rsqrt(n);
+  return (quat_t){ f16_mul(q.w, r), f16_mul(q.x, r), f16_mul(q.y, r), f16_mul(q.z, r) };
+}
+
+quat_t quat_rotate(quat_t q, vec3_t axis, fix16_t angle)
+{
+  return quat_normalize(quat_mul(q, quat_from_axis_angle(axis, angle)));
+}
+
+// Angle in [0, 64] units whose cosine is c, c in [0, 1]: bisection over the
+// table, then a linear step between the two entries around it
+static fix16_t acos_units(fix16_t c)
+{
+  int lo = 0, hi = 64; // v_cos(lo) >= c >= v_cos(hi)
+  while(hi - lo > 1)
+  {
+    int mid = (lo + hi) / 2;
+    if(v_cos(mid) >= c)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  fix16_t a = v_cos(lo), b = v_cos(hi);
+  return f16_add(INT_TO_F16(lo), f16_div(f16_sub(a, c), f16_sub(a, b)));
+}
+
+quat_t quat_slerp(quat_t a, quat_t b, fix16_t t)
+{
+  // q and -q are the same rotation, take the one nearer a
+  fix16_t d = quat_dot(a, b);
+  if(d < 0)
+  {
+    b = (quat_t){ -b.w, -b.x, -b.y, -b.z };
+    d = -d;
+  }
+
+  // Within 4 units the table is too flat to invert and the lerp is as good
+  fix16_t wa = f16_sub(F16_ONE, t), wb = t;
+  if(d < v_cos(4))
+  {
+    fix16_t theta = acos_units(d);
+    fix16_t s = v_sin_fx(theta);
+    wa = f16_div(v_sin_fx(f16_mul(wa, theta)), s);
+    wb = f16_div(v_sin_fx(f16_mul(wb, theta)), s);
+  }
+
+  quat_t q = {
+    f16_add(f16_mul(a.w, wa), f16_mul(b.w, wb)),
+    f16_add(f16_mul(a.x, wa), f16_mul(b.x, wb)),
+    f16_add(f16_mul(a.y, wa), f16_mul(b.y, wb)),
+    f16_add(f16_mul(a.z, wa), f16_mul(b.z, wb)),
+  };
+  return quat_normalize(q);
+}
+
+void rotation_from_quat(fix16_t (*m)[4], quat_t q, fix16_t scale)
+{
+  fix16_t x2 = q.x * 2, y2 = q.y * 2, z2 = q.z * 2;
+  fix16_t xx = f16_mul(q.x, x2), yy = f16_mul(q.y, y2), zz = f16_mul(q.z, z2);
+  fix16_t xy = f16_mul(q.x, y2), xz = f16_mul(q.x, z2), yz = f16_mul(q.y, z2);
+  fix16_t wx = f16_mul(q.w, x2), wy = f16_mul(q.w, y2), wz = f16_mul(q.w, z2);
+
+  m[0][0] = f16_sub(F16_ONE, f16_add(yy, zz));
+  m[0][1] = f16_sub(xy, wz);
+  m[0][2] = f16_add(xz, wy);
+  m[1][0] = f16_add(xy, wz);
+  m[1][1] = f16_sub(F16_ONE, f16_add(xx, zz));
+  m[1][2] = f16_sub(yz, wx);
+  m[2][0] = f16_sub(xz, wy);
+  m[2][1] = f16_add(yz, wx);
+  m[2][2] = f16_sub(F16_ONE, f16_add(xx, yy));
+
+  if(scale != F16_ONE)
+  {
+    for(int r = 0; r < 3; r++)
+    {
+      for(int c = 0; c < 3; c++)
+        m[r][c] = f16_mul(m[r][c], scale);
+    }
+  }
+}
+
+mat4_t quat_to_mat4(quat_t q)
+{
+  mat4_t m = mat4_identity();
+  rotation_from_quat(m.m, q, F16_ONE);
+  return m;
+}
@@ -0,0 +1,248 @@
+#include "v_transform.h"
+#include <stddef.h>
+
+void mat34_from_mat4(mat34_t *out, const mat4_t *m)
+{
+  for(int r = 0; r < 3; r++)
+  {
+    for(int c = 0; c < 4; c++)
+      out->m[r][c] = m->m[r][c];
+  }
+}
+
+void mat34_mul(mat34_t *out, const mat34_t *a, const mat34_t *b)
+{
+  for(int r = 0; r < 3; r++)
+  {
+    for(int c = 0; c < 4; c++)
+    {
+      out->m[r][c] = f16_add(
+                f16_add(f16_mul(a->m[r][0], b->m[0][c]), f16_mul(a->m[r][1], b->m[1][c])),
+                f16_mul(a->m[r][2], b->m[2][c]));
+    }
+    out->m[r][3] = f16_add(out->m[r][3], a->m[r][3]);
+  }
+}
+
+void mat34_compose(mat34_t *out, vec3_t rot, fix16_t scale, vec3_t pos)
+{
+  rotation_from_euler(out->m, rot, scale);
+  out->m[0][3] = pos.x;
+  out->m[1][3] = pos.y;
+  out->m[2][3] = pos.z;
+}
+
+void mat34_from_quat(mat34_t *out, quat_t q, fix16_t scale, vec3_t pos)
+{
+  rotation_from_quat(out->m, q, scale);
+  out->m[0][3] = pos.x;
+  out->m[1][3] = pos.y;
+  out->m[2][3] = pos.z;
+}
+
+vec3_t mat34_transform(const mat34_t *m, vec3_t v)
+{
+  vec3_t r = mat34_rotate(m, v);
+  return (vec3_t){ f16_add(r.x, m->m[0][3]), f16_add(r.y, m->m[1][3]), f16_add(r.z, m->m[2][3]) };
+}
+
+vec3_t mat34_rotate(const mat34_t *m, vec3_t v)
+{
+  vec3_t r;
+  r.x = f16_add(f16_add(f16_mul(m->m[0][0], v.x), f16_mul(m->m[0][1], v.y)), f16_mul(m->m[0][2], v.z));
+  r.y = f16_add(f16_add(f16_mul(m->m[1][0], v.x), f16_mul(m->m[1][1], v.y)), f16_mul(m->m[1][2], v.z));
+  r.z = f16_add(f16_add(f16_mul(m->m[2][0], v.x), f16_mul(m->m[2][1], v.y)), f16_mul(m->m[2][2], v.z));
+  return r;
+}
+
+vec3_t mat34_untransform(const mat34_t *m, vec3_t v)
+{
+  // R^T * (v - t), the transpose stands in for the inverse of a rotation
+  fix16_t x = f16_sub(v.x, m->m[0][3]);
+  fix16_t y = f16_sub(v.y, m->m[1][3]);
+  fix16_t z = f16_sub(v.z, m->m[2][3]);
+  vec3_t r;
+  r.x = f16_add(f16_add(f16_mul(m->m[0][0], x), f16_mul(m->m[1][0], y)), f16_mul(m->m[2][0], z));
+  r.y = f16_add(f16_add(f16_mul(m->m[0][1], x), f16_mul(m->m[1][1], y)), f16_mul(m->m[2][1], z));
+  r.z = f16_add(f16_add(f16_mul(m->m[0][2], x), f16_mul(m->m[1][2], y)), f16_mul(m->m[2][2], z));
+  return r;
+}
+
+// list == NULL walks in[0..count-1], the branch is loop invariant
+static inline uint8_t project_vertices(const mat34_t *m, const projection_t *proj, const vec3_t *in,
+                                       const uint16_t *list, int count, const vertex_soa_t *out)
+{
+  // Locals so the compiler keeps the matrix in registers instead of
+  // reloading it after every store through the (possibly aliasing) outputs
+  const fix16_t m00 = m->m[0][0], m01 = m->m[0][1], m02 = m->m[0][2], m03 = m->m[0][3];
+  const fix16_t m10 = m->m[1][0], m11 = m->m[1][1], m12 = m->m[1][2], m13 = m->m[1][3];
+  const fix16_t m20 = m->m[2][0], m21 = m->m[2][1], m22 = m->m[2][2], m23 = m->m[2][3];
+  const fix16_t focal = proj->focal;
+  const fix16_t cx = proj->cx;
+  const fix16_t cy = proj->cy;
+  const fix16_t near = proj->near;
+
+  fix16_t *ox = out->x, *oy = out->y, *oz = out->z;
+  fix16_t *osx = out->sx, *osy = out->sy;
+  uint8_t *oc = out->outcode;
+  uint8_t any = 0;
+
+  for(int n = 0; n < count; n++)
+  {
+    int i = list ? list[n] : n;
+    fix16_t vx = in[i].x, vy = in[i].y, vz = in[i].z;
+    fix16_t x = f16_add(f16_add(f16_mul(m00, vx), f16_mul(m01, vy)), f16_add(f16_mul(m02, vz), m03));
+    fix16_t y = f16_add(f16_add(f16_mul(m10, vx), f16_mul(m11, vy)), f16_add(f16_mul(m12, vz), m13));
+    fix16_t z = f16_add(f16_add(f16_mul(m20, vx), f16_mul(m21, vy)), f16_add(f16_mul(m22, vz), m23));
+
+    // Behind the near plane the screen position is taken at near, the caller
+    // clips those faces in view space where z is still exact
+    uint8_t code = z < near ? OUTCODE_NEAR : 0;
+
+    // focal / z once, shared by both screen axes
+    fix16_t scale = f16_div(focal, code ? near : z);
+    int64_t px = ((int64_t)x * scale) >> F16_SHIFT;
+    int64_t py = ((int64_t)y * scale) >> F16_SHIFT;
+    // One unsigned compare per axis for |p| > limit, the sign picks the side
+    const int64_t limit = (int64_t)PROJECT_LIMIT << F16_SHIFT;
+    if((uint64_t)(px + limit) > (uint64_t)(2 * limit))
+      code |= px < 0 ? OUTCODE_LEFT : OUTCODE_RIGHT;
+    if((uint64_t)(py + limit) > (uint64_t)(2 * limit))
+      code |= py < 0 ? OUTCODE_TOP : OUTCODE_BOTTOM;
+    any |= code;
+
+    ox[i] = x;
+    oy[i] = y;
+    oz[i] = z;
+    osx[i] = (fix16_t)px + cx;
+    osy[i] = (fix16_t)py + cy;
+    oc[i] = code;
+  }
+  return any;
+}
+
+uint8_t transform_project(const mat34_t *m, const projection_t *proj,
+                          const vec3_t *in, int count, const vertex_soa_t *out)
+{
+  return project_vertices(m, proj, in, NULL, count, out);
+}
+
+uint8_t transform_project_list(const mat34_t *m, const projection_t *proj, const vec3_t *in,
+                               const uint16_t *list, int count, const vertex_soa_t *out)
+{
+  return project_vertices(m, proj, in, list, count, out);
+}
+
+static plane_t frustum_plane(fix16_t nx, fix16_t ny, fix16_t nz, fix16_t d)
+{
+  return (plane_t){ vec3_normalize((vec3_t){ nx, ny, nz }), d };
+}
+
+// Side planes pass through the eye: sx >= x0 is focal * x + (cx - x0) * z >= 0
+static void frustum_build(plane_t *p, const projection_t *proj, fix16_t x0, fix16_t y0,
+                          fix16_t x1, fix16_t y1, fix16_t near)
+{
+  p[0] = frustum_plane(proj->focal, 0, f16_sub(proj->cx, x0), 0);
+  p[1] = frustum_plane(-proj->focal, 0, f16_sub(x1, proj->cx), 0);
+  p[2] = frustum_plane(0, proj->focal, f16_sub(proj->cy, y0), 0);
+  p[3] = frustum_plane(0, -proj->focal, f16_sub(y1, proj->cy), 0);
+  p[4] = (plane_t){ { 0, 0, F16_ONE }, -near };
+}
+
+void frustum_from_projection(frustum_t *f, const projection_t *proj, int width, int height)
+{
+  fix16_t w = INT_TO_F16(width), h = INT_TO_F16(height);
+  frustum_build(f->outer, proj, 0, 0, w, h, proj->near);
+  // A pixel of slack covers the truncation in the projection and the Q12.4 snap
+  frustum_build(f->inner, proj, F16_ONE, F16_ONE, f16_sub(w, F16_ONE), f16_sub(h, F16_ONE),
+                f16_add(proj->near, F16_ONE >> 8));
+}
+
+cull_t frustum_test_sphere(const frustum_t *f, vec3_t center, fix16_t radius)
+{
+  cull_t result = CULL_INSIDE;
+  for(int i = 0; i < FRUSTUM_PLANES; i++)
+  {
+    if(f16_add(vec3_dot(f->outer[i].n, center), f->outer[i].d) < -radius)
+      return CULL_OUTSIDE;
+    if(f16_add(vec3_dot(f->inner[i].n, center), f->inner[i].d) < radius)
+      result = CULL_PARTIAL;
+  }
+  return result;
+}
+
+// Projected half-size of the box on n, the sum of |n . axis| * half extent
+static fix16_t box_extent(const mat34_t *m, vec3_t n, vec3_t half)
+{
+  fix16_t r = 0;
+  for(int c = 0; c < 3; c++)
+  {
+    fix16_t a = f16_add(f16_add(f16_mul(n.x, m->m[0][c]), f16_mul(n.y, m->m[1][c])), f16_mul(n.z, m->m[2][c]));
+    fix16_t e = c == 0 ? half.x : (c == 1 ? half.y : half.z);
+    r = f16_add(r, f16_mul(a < 0 ? -a : a, e));
+  }
+  return r;
+}
+
+cull_t frustum_test_box(const frustum_t *f, const mat34_t *m, vec3_t min, vec3_t max)
+{
+  vec3_t half = { (max.x - min.x) / 2, (max.y - min.y) / 2, (max.z - min.z) / 2 };
+  vec3_t mid = { min.x + half.x, min.y + half.y, min.z + half.z };
+  vec3_t center = mat34_transform(m, mid);
+
+  cull_t result = CULL_INSIDE;
+  for(int i = 0; i < FRUSTUM_PLANES; i++)
+  {
+    const plane_t *o = &f->outer[i], *in = &f->inner[i];
+    if(f16_add(vec3_dot(o->n, center), o->d) < -box_extent(m, o->n, half))
+      return CULL_OUTSIDE;
+    if(result == CULL_INSIDE && f16_add(vec3_dot(in->n, center), in->d) < box_extent(m, in->n, half))
+      result = CULL_PARTIAL;
+  }
+  return result;
+}
+
+// n . (R p + t) + d == (R^T n) . p + (n . t + d)
+static plane_t plane_to_object(const plane_t *p, const mat34_t *m)
+{
+  vec3_t t = { m->m[0][3], m->m[1][3], m->m[2][3] };
+  vec3_t n = p->n;
+  plane_t r;
+  r.n.x = f16_add(f16_add(f16_mul(m->m[0][0], n.x), f16_mul(m->m[1][0], n.y)), f16_mul(m->m[2][0], n.z));
+  r.n.y = f16_add(f16_add(f16_mul(m->m[0][1], n.x), f16_mul(m->m[1][1], n.y)), f16_mul(m->m[2][1], n.z));
+  r.n.z = f16_add(f16_add(f16_mul(m->m[0][2], n.x), f16_mul(m->m[1][2], n.y)), f16_mul(m->m[2][2], n.z));
+  r.d = f16_add(vec3_dot(n, t), p->d);
+  return r;
+}
+
+void frustum_to_object(frustum_t *out, const frustum_t *f, const mat34_t *m)
+{
+  for(int i = 0; i < FRUSTUM_PLANES; i++)
+  {
+    out->outer[i] = plane_to_object(&f->outer[i], m);
+    out->inner[i] = plane_to_object(&f->inner[i], m);
+  }
+}
+
+static fix16_t aabb_extent(vec3_t n, vec3_t half)
+{
+  return f16_add(f16_add(f16_mul(n.x < 0 ? -n.x : n.x, half.x), f16_mul(n.y < 0 ? -n.y : n.y, half.y)),
+                 f16_mul(n.z < 0 ? -n.z : n.z, half.z));
+}
+
+cull_t frustum_test_aabb(const frustum_t *f, vec3_t min, vec3_t max)
+{
+  vec3_t half = { (max.x - min.x) / 2, (max.y - min.y) / 2, (max.z - min.z) / 2 };
+  vec3_t mid = { min.x + half.x, min.y + half.y, min.z + half.z };
+
+  cull_t result = CULL_INSIDE;
+  for(int i = 0; i < FRUSTUM_PLANES; i++)
+  {
+    const plane_t *o = &f->outer[i], *in = &f->inner[i];
+    if(f16_add(vec3_dot(o->n, mid), o->d) < -aabb_extent(o->n, half))
+      return CULL_OUTSIDE;
+    if(result == CULL_INSIDE && f16_add(vec3_dot(in->n, mid), in->d) < aabb_extent(in->n, half))
+      result = CULL_PARTIAL;
+  }
+  return result;
+}
@@ -1,5 +1,4 @@
 #include "v_vector.h"
-#include <math.h>
 
 vec3_t vec3_add(vec3_t a, vec3_t b) {
     return (vec3_t){ a.x + b.x, a.y + b.y, a.z + b.z };
@@ -33,17 +32,39 @@ fix16_t vec3_dot(vec3_t a, vec3_t b) {
     );
 }
 
+// Shifts v so its largest component lands in [0.5, 1), where the squared
+// terms neither overflow nor lose precision. Returns the shift applied.
+static int vec3_prescale(vec3_t *v)
+{
+    uint32_t ax = v->x < 0 ? 0u - (uint32_t)v->x : (uint32_t)v->x;
+    uint32_t ay = v->y < 0 ? 0u - (uint32_t)v->y : (uint32_t)v->y;
+    uint32_t az = v->z < 0 ? 0u - (uint32_t)v->z : (uint32_t)v->z;
+    int shift = 16 - __builtin_clz(ax | ay | az);
+    if (shift > 0) {
+        v->x >>= shift;
+        v->y >>= shift;
+        v->z >>= shift;
+    } else if (shift < 0) {
+        v->x = (fix16_t)((uint32_t)v->x << -shift);
+        v->y = (fix16_t)((uint32_t)v->y << -shift);
+        v->z = (fix16_t)((uint32_t)v->z << -shift);
+    }
+    return shift;
+}
+
 fix16_t vec3_length(vec3_t v) {
-    float x = F16_TO_FLT(v.x);
-    float y = F16_TO_FLT(v.y);
-    float z = F16_TO_FLT(v.z);
-    return FLT_TO_F16(sqrtf(x*x + y*y + z*z));
+    if ((v.x | v.y | v.z) == 0) return 0;
+    int shift = vec3_prescale(&v);
+    fix16_t len = f16_sqrt(vec3_dot(v, v));
+    if (shift < 0) return len >> -shift;
+    if (len > (INT32_MAX >> shift)) return INT32_MAX;
+    return len << shift;
 }
 
 vec3_t vec3_normalize(vec3_t v) {
-    fix16_t len = vec3_length(v);
-    if (len == 0) return v;
-    return vec3_div(v, len);
+    if ((v.x | v.y | v.z) == 0) return v;
+    vec3_prescale(&v);
+    return vec3_mul(v, f16_rsqrt(vec3_dot(v, v)));
 }
 
 vec3_t vec3_cross(vec3_t a, vec3_t b) {
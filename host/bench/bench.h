@@ -0,0 +1,63 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "v_render.h"
+
+// Tiny host benchmark harness. Each bench_* entry point prints one line per
+// measurement: name, iterations, total time and cost per item. It returns
+// false when one of its checks failed, which fails the run.
+
+int64_t bench_now_ns(void);
+
+void bench_report(const char *name, long items, int64_t ns, const char *unit);
+
+// Deterministic xorshift so runs are comparable across machines
+uint32_t bench_rand(void);
+int bench_rand_range(int lo, int hi); // inclusive
+
+fix16_t bench_to_f16(double v); // rounded to nearest
+double bench_to_double(fix16_t v);
+
+// Prints one PASS/FAIL line for an accuracy check and returns whether it passed
+bool bench_check(const char *name, double error, double limit);
+
+// Unit sphere of stacks rings by slices segments, outward winding, built
+// into pos (2 + (stacks - 1) * slices) and tri (2 * slices * (stacks - 1))
+mesh_t bench_make_sphere(vec3_t *pos, uint16_t (*tri)[3], int stacks, int slices);
+
+// Turns each model a random amount about y then x and translates it to a
+// point drawn per axis from [lo, hi]
+void bench_place_models(mat34_t *models, int count, vec3_t lo, vec3_t hi);
+
+// Times frames frames, each cleared and begun with render_begin_frame before
+// draw(ctx, frame) fills it, and reports them under label (none when NULL).
+// Returns the render stats summed over the frames, and the time in *ns
+// unless ns is NULL.
+render_stats_t bench_draw_frames(const char *label, int frames, void (*draw)(void *ctx, int frame), void *ctx,
+                                 int64_t *ns);
+
+// Keeps the optimizer from discarding benchmark results
+extern volatile uint32_t bench_sink;
+
+bool bench_raster(void);
+bool bench_math(void);
+bool bench_fixed(void);
+bool bench_accuracy(void);
+bool bench_game(void);
+bool bench_cull(void);
+bool bench_wire(void);
+bool bench_entity(void);
+bool bench_grid(void);
+bool bench_display(void);
+bool bench_dirty(void);
+bool bench_palette(void);
+bool bench_shade(void);
+bool bench_texture(void);
+bool bench_lod(void);
+bool bench_cache(void);
+bool bench_camera(void);
+bool bench_rotation(void);
+
+#endif
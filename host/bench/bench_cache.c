@@ -0,0 +1,139 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_primitives.h"
+#include "v_render.h"
+
+// Transform cache on a mostly static field of cubes and pyramids: the model
+// matrices are built the way game_draw builds them, and every frame a few
+// objects move. The same frames are drawn without the cache, with it, with
+// the camera moving (so nothing can hit), with the objects placed by
+// quaternion and with far more objects than the cache holds.
+
+#define CACHE_OBJECTS 96
+
+typedef struct {
+  vec3_t pos, rot;
+  quat_t orient; // all zero when placed by rot
+  const mesh_t *mesh;
+} object_t;
+
+static object_t objects[CACHE_OBJECTS];
+
+static void place_objects(void)
+{
+  for (int i = 0; i < CACHE_OBJECTS; i++)
+  {
+    objects[i].pos = (vec3_t){ bench_rand_range(-INT_TO_F16(12), INT_TO_F16(12)),
+                               bench_rand_range(-INT_TO_F16(12), INT_TO_F16(12)),
+                               bench_rand_range(INT_TO_F16(8), INT_TO_F16(30)) };
+    objects[i].rot = (vec3_t){ bench_rand_range(0, 255), bench_rand_range(0, 255), 0 };
+    objects[i].orient = (quat_t){ 0, 0, 0, 0 };
+    objects[i].mesh = i & 1 ? &MESH_PYRAMID : &MESH_CUBE;
+  }
+}
+
+#if V_RENDER_CACHE_BYTES
+static void orient_objects(void)
+{
+  for (int i = 0; i < CACHE_OBJECTS; i++)
+    objects[i].orient = quat_from_euler(objects[i].rot);
+}
+#endif
+
+static void build_model(const object_t *o, fix16_t camera_z, mat34_t *model)
+{
+  vec3_t pos = { o->pos.x, o->pos.y, f16_add(o->pos.z, camera_z) };
+  if (o->orient.w | o->orient.x | o->orient.y | o->orient.z)
+    mat34_from_quat(model, o->orient, F16_ONE, pos);
+  else
+    mat34_compose(model, o->rot, F16_ONE, pos);
+}
+
+typedef struct {
+  const render_view_t *view;
+  int count, moving;
+  fix16_t camera_step;
+  bool cached;
+} scene_t;
+
+static void draw_scene(void *ctx, int frame)
+{
+  const scene_t *scene = ctx;
+  mat34_t world_to_view = {{
+    { F16_ONE, 0, 0, 0 },
+    { 0, F16_ONE, 0, 0 },
+    { 0, 0, F16_ONE, scene->camera_step * (frame + 1) },
+  }};
+#if V_RENDER_CACHE_BYTES
+  if (scene->cached)
+    render_cache_begin(scene->view, &world_to_view);
+#endif
+
+  for (int i = 0; i < scene->count; i++)
+  {
+    object_t *o = &objects[i % CACHE_OBJECTS];
+    if (i < scene->moving && (o->orient.w | o->orient.x | o->orient.y | o->orient.z))
+      o->orient = quat_rotate(o->orient, (vec3_t){ 0, F16_ONE, 0 }, F16_ONE);
+    else if (i < scene->moving)
+      o->rot.y = (o->rot.y + 1) & 255;
+#if V_RENDER_CACHE_BYTES
+    if (scene->cached &&
+        render_cache_replay(scene->view, (uint32_t)i + 1, o->mesh, o->pos, o->rot, o->orient, V_CYAN))
+      continue;
+#endif
+    mat34_t model;
+    build_model(o, world_to_view.m[2][3], &model);
+    render_mesh(scene->view, o->mesh, &model, V_CYAN);
+  }
+}
+
+// moving objects turn a step per frame, count of them draw; camera_step
+// moves the camera every frame
+static void run(const char *label, const render_view_t *view, int count, int moving, fix16_t camera_step,
+                bool cached, int frames)
+{
+  scene_t scene = { view, count, moving, camera_step, cached };
+#if V_RENDER_CACHE_BYTES
+  render_cache_clear();
+#endif
+  render_stats_t total = bench_draw_frames(label, frames, draw_scene, &scene, NULL);
+  printf("  %.1f faces, %.1f verts transformed, %.1f hits, %.1f misses, %.1f evictions per frame\n",
+         (double)total.faces_drawn / frames, (double)total.verts_transformed / frames,
+         (double)total.cache_hits / frames, (double)total.cache_misses / frames,
+         (double)total.cache_evictions / frames);
+}
+
+bool bench_cache(void)
+{
+  const int frames = 2000;
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t view;
+  render_view_init(&view, &proj, NULL);
+
+  place_objects();
+#if V_RENDER_CACHE_BYTES
+  run("24 objects, 2 moving, uncached", &view, 24, 2, 0, false, frames);
+  run("24 objects, 2 moving, cached", &view, 24, 2, 0, true, frames);
+  run("24 objects, camera moving, cached", &view, 24, 0, F16_ONE / 256, true, frames);
+  run("96 objects, 2 moving, uncached", &view, 96, 2, 0, false, frames);
+  run("96 objects, 2 moving, cached", &view, 96, 2, 0, true, frames);
+  orient_objects();
+  run("24 by quaternion, 2 moving, uncached", &view, 24, 2, 0, false, frames);
+  run("24 by quaternion, 2 moving, cached", &view, 24, 2, 0, true, frames);
+#else
+  run("24 objects, 2 moving", &view, 24, 2, 0, false, frames);
+  printf("transform cache compiled out (V_RENDER_CACHE_BYTES 0)\n");
+#endif
+  return true;
+}
@@ -0,0 +1,191 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "v_camera.h"
+#include "v_config.h"
+#include "v_matrix.h"
+#include "v_transform.h"
+
+// Checks of the camera maths against double precision, then the cost of
+// taking vertices to the screen through separate model and view transforms
+// against one model-view matrix built per entity.
+
+#define CAMERA_VERTS    64
+#define CAMERA_ENTITIES 64
+
+static vec3_t verts[CAMERA_VERTS];
+static fix16_t out_x[CAMERA_VERTS], out_y[CAMERA_VERTS], out_z[CAMERA_VERTS];
+static fix16_t out_sx[CAMERA_VERTS], out_sy[CAMERA_VERTS];
+static uint8_t out_code[CAMERA_VERTS];
+static mat34_t models[CAMERA_ENTITIES];
+
+static vec3_t rand_point(int range)
+{
+  return (vec3_t){ bench_rand_range(-INT_TO_F16(range), INT_TO_F16(range)),
+                   bench_rand_range(-INT_TO_F16(range), INT_TO_F16(range)),
+                   bench_rand_range(-INT_TO_F16(range), INT_TO_F16(range)) };
+}
+
+static bool check_math(void)
+{
+  bool pass = true;
+
+  // mat4_translate moves each axis by its own amount
+  mat4_t t = mat4_translate(INT_TO_F16(1), INT_TO_F16(2), INT_TO_F16(3));
+  vec3_t p = mat4_transform(&t, (vec3_t){ F16_ONE / 2, 0, -F16_ONE });
+  double err = fabs(bench_to_double(p.x) - 1.5) + fabs(bench_to_double(p.y) - 2) + fabs(bench_to_double(p.z) - 2);
+  pass &= bench_check("mat4_translate", err, 0);
+
+  // Relative error of the table up to 80 degrees, past that tan runs off to infinity
+  err = 0;
+  for (int a = -56; a <= 56; a++)
+  {
+    double want = tan(a * 2 * M_PI / 256);
+    double got = bench_to_double(v_tan(a));
+    err = fmax(err, fabs(got - want) / fmax(fabs(want), 1));
+  }
+  pass &= bench_check("v_tan, |angle| <= 56", err, 1.0 / 32768);
+  pass &= bench_check("v_tan, quarter turn saturates", v_tan(64) == INT32_MAX && v_tan(-64) == INT32_MAX ? 0 : 1,
+                      0);
+
+  // A point on the top edge of the field of view lands on the top edge of clip space
+  err = 0;
+  for (int fov = 16; fov <= 96; fov += 8)
+  {
+    mat4_t proj = mat4_perspective(fov, INT_TO_F16(V_DISPLAY_WIDTH) / V_DISPLAY_HEIGHT, F16_ONE / 2, INT_TO_F16(100));
+    double z = 10, y = z * tan(fov * M_PI / 256);
+    vec3_t c = mat4_transform(&proj, (vec3_t){ 0, (fix16_t)lround(y * 65536), INT_TO_F16(10) });
+    err = fmax(err, fabs(bench_to_double(c.y) - 1));
+  }
+  pass &= bench_check("mat4_perspective, edge of the fov", err, 1.0 / 256);
+
+  err = 0;
+  for (int fov = 16; fov <= 96; fov += 8)
+  {
+    camera_t cam;
+    camera_init(&cam, (vec3_t){ 0, 0, 0 }, fov, F16_ONE / 2);
+    projection_t proj;
+    camera_projection(&cam, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT, &proj);
+    double want = V_DISPLAY_HEIGHT / 2.0 / tan(fov * M_PI / 256);
+    err = fmax(err, fabs(bench_to_double(proj.focal) - want) / want);
+  }
+  pass &= bench_check("camera_projection focal, relative", err, 1.0 / 4096);
+
+  // Looking at a target puts it dead ahead (error relative to its distance),
+  // with up towards the top of the screen, and the view stays rigid
+  double ahead = 0, roll = 0, axes = 0, round_trip = 0;
+  for (int i = 0; i < 1000; i++)
+  {
+    camera_t cam;
+    camera_init(&cam, rand_point(20), 40, F16_ONE / 2);
+    vec3_t target = rand_point(20);
+    vec3_t up = { bench_rand_range(-F16_ONE / 4, F16_ONE / 4), -F16_ONE, bench_rand_range(-F16_ONE / 4, F16_ONE / 4) };
+    vec3_t dir = vec3_sub(target, cam.pos);
+    if (vec3_length(dir) < F16_ONE)
+      continue;
+    camera_look_at(&cam, target, up);
+
+    mat34_t view;
+    camera_view(&cam, &view);
+    vec3_t v = mat34_transform(&view, target);
+    double dist = bench_to_double(vec3_length(dir));
+    ahead = fmax(ahead, (fabs(bench_to_double(v.x)) + fabs(bench_to_double(v.y)) +
+                         fabs(bench_to_double(v.z) - dist)) / dist);
+    // up has no sideways component on screen and does not point down it
+    vec3_t above = mat34_rotate(&view, up);
+    roll = fmax(roll, fmax(fabs(bench_to_double(above.x)), bench_to_double(above.y)));
+
+    axes = fmax(axes, fabs(bench_to_double(vec3_dot(cam.right, cam.down))) +
+                          fabs(bench_to_double(vec3_dot(cam.down, cam.forward))) +
+                          fabs(bench_to_double(vec3_length(cam.down)) - 1));
+
+    vec3_t w = rand_point(20);
+    vec3_t back = mat34_untransform(&view, mat34_transform(&view, w));
+    round_trip = fmax(round_trip, fabs(bench_to_double(back.x - w.x)) + fabs(bench_to_double(back.y - w.y)) +
+                                      fabs(bench_to_double(back.z - w.z)));
+  }
+  pass &= bench_check("camera_look_at, target on the axis", ahead, 1.0 / 2048);
+  pass &= bench_check("camera_look_at, up stays up", roll, 1.0 / 4096);
+  pass &= bench_check("camera_look_at, orthonormal axes", axes, 1.0 / 4096);
+  pass &= bench_check("camera_view, round trip within 35", round_trip, 1.0 / 64);
+  return pass;
+}
+
+bool bench_camera(void)
+{
+  bool pass = check_math();
+  printf("camera checks: %s\n", pass ? "PASS" : "FAIL");
+
+  for (int i = 0; i < CAMERA_VERTS; i++)
+    verts[i] = rand_point(1);
+  for (int i = 0; i < CAMERA_ENTITIES; i++)
+  {
+    mat4_t r = mat4_mul(mat4_rotate_y(bench_rand_range(0, 255)), mat4_rotate_x(bench_rand_range(0, 255)));
+    mat34_from_mat4(&models[i], &r);
+    models[i].m[0][3] = bench_rand_range(-INT_TO_F16(8), INT_TO_F16(8));
+    models[i].m[1][3] = bench_rand_range(-INT_TO_F16(8), INT_TO_F16(8));
+    models[i].m[2][3] = bench_rand_range(INT_TO_F16(4), INT_TO_F16(20));
+  }
+
+  camera_t cam;
+  camera_init(&cam, (vec3_t){ INT_TO_F16(2), INT_TO_F16(-1), INT_TO_F16(-6) }, 40, F16_ONE / 2);
+  camera_look_at(&cam, (vec3_t){ 0, 0, INT_TO_F16(12) }, (vec3_t){ 0, -F16_ONE, 0 });
+  projection_t proj;
+  camera_projection(&cam, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT, &proj);
+  mat34_t view;
+  camera_view(&cam, &view);
+  vertex_soa_t out = { out_x, out_y, out_z, out_sx, out_sy, out_code };
+
+  const int rounds = 2000;
+  uint32_t acc = 0;
+
+  // Every vertex to world space, then to view space
+  static vec3_t world[CAMERA_VERTS];
+  int64_t t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int e = 0; e < CAMERA_ENTITIES; e++)
+    {
+      for (int i = 0; i < CAMERA_VERTS; i++)
+        world[i] = mat34_transform(&models[e], verts[i]);
+      acc += transform_project(&view, &proj, world, CAMERA_VERTS, &out);
+      acc += out_sx[e & (CAMERA_VERTS - 1)];
+    }
+  }
+  bench_report("model, then view per vertex", (long)rounds * CAMERA_ENTITIES * CAMERA_VERTS,
+               bench_now_ns() - t0, "vert");
+
+  // One model-view product per entity, one transform per vertex
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int e = 0; e < CAMERA_ENTITIES; e++)
+    {
+      mat34_t model_view;
+      mat34_mul(&model_view, &view, &models[e]);
+      acc += transform_project(&model_view, &proj, verts, CAMERA_VERTS, &out);
+      acc += out_sx[e & (CAMERA_VERTS - 1)];
+    }
+  }
+  bench_report("model-view per entity", (long)rounds * CAMERA_ENTITIES * CAMERA_VERTS, bench_now_ns() - t0,
+               "vert");
+
+  // The same with the camera at the origin, as a floor
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int e = 0; e < CAMERA_ENTITIES; e++)
+    {
+      acc += transform_project(&models[e], &proj, verts, CAMERA_VERTS, &out);
+      acc += out_sx[e & (CAMERA_VERTS - 1)];
+    }
+  }
+  bench_report("model only (no camera)", (long)rounds * CAMERA_ENTITIES * CAMERA_VERTS, bench_now_ns() - t0,
+               "vert");
+
+  bench_sink = acc;
+  return pass;
+}
@@ -0,0 +1,165 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_display.h"
+#include "v_graphics.h"
+#include "v_host.h"
+#include "v_primitives.h"
+#include "v_render.h"
+
+// A field of cubes around and behind the camera, most of them off screen.
+// The same scene is drawn with the bounds and with them stripped, which
+// leaves render_mesh nothing to cull with.
+
+#define CULL_ENTITIES 200
+
+static mat34_t models[CULL_ENTITIES];
+
+typedef struct {
+  const render_view_t *view;
+  const mesh_t *mesh;
+} scene_t;
+
+static void draw_scene(void *ctx, int frame)
+{
+  const scene_t *scene = ctx;
+  (void)frame;
+  for (int i = 0; i < CULL_ENTITIES; i++)
+    render_mesh(scene->view, scene->mesh, &models[i], V_CYAN);
+}
+
+static void run(const char *label, const render_view_t *view, const mesh_t *mesh, int frames)
+{
+  scene_t scene = { view, mesh };
+  render_stats_t s = bench_draw_frames(label, frames, draw_scene, &scene, NULL);
+  printf("  %lu entities drawn, %lu culled, %lu verts transformed, %lu faces drawn\n",
+         (unsigned long)s.entities_drawn / frames, (unsigned long)s.entities_culled / frames,
+         (unsigned long)s.verts_transformed / frames, (unsigned long)s.faces_drawn / frames);
+}
+
+// Panel contents after presenting one frame of the scene
+static void capture(const render_view_t *view, const mesh_t *mesh, uint16_t *out)
+{
+  scene_t scene = { view, mesh };
+  gfx_dirty_invalidate();
+  bench_draw_frames(NULL, 1, draw_scene, &scene, NULL);
+  display_present();
+  host_display_flush();
+  memcpy(out, host_display_frame(), V_BUFFER_SIZE * sizeof(uint16_t));
+}
+
+static uint16_t frame_culled[V_BUFFER_SIZE];
+static uint16_t frame_plain[V_BUFFER_SIZE];
+
+// Back faces of meshes without planes come from cross products, which must
+// keep their sign on faces far larger than the 30 unit cube. Each quad is
+// drawn with both windings under a translation, and the faces render_mesh
+// keeps are compared with the side of the eye worked out in doubles.
+typedef struct {
+  const char *name;
+  double corner[4][3]; // object space, around the quad
+  double at[3];        // translation into view space
+} big_quad_t;
+
+static const big_quad_t big_quads[] = {
+  { "30x30 quad at depth 40", { { -15, -15, 0 }, { 15, -15, 0 }, { 15, 15, 0 }, { -15, 15, 0 } }, { 0, 0, 40 } },
+  { "floor 300 wide", { { -150, 0, 0.6 }, { 150, 0, 0.6 }, { 150, 0, 60 }, { -150, 0, 60 } }, { 0, 1, 0 } },
+  { "floor 1000 wide", { { -500, 0, 0.6 }, { 500, 0, 0.6 }, { 500, 0, 60 }, { -500, 0, 60 } }, { 0, 1, 0 } },
+  { "wall 1000 square", { { -500, -500, 0 }, { 500, -500, 0 }, { 500, 500, 0 }, { -500, 500, 0 } }, { 0, 0, 600 } },
+};
+
+static bool check_big_faces(const render_view_t *view)
+{
+  static const uint8_t windings[2][2][3] = { { { 0, 1, 2 }, { 0, 2, 3 } }, { { 0, 2, 1 }, { 0, 3, 2 } } };
+  bool pass = true;
+
+  for (size_t q = 0; q < sizeof(big_quads) / sizeof(big_quads[0]); q++)
+  {
+    const big_quad_t *bq = &big_quads[q];
+    vec3_t verts[4];
+    for (int v = 0; v < 4; v++)
+      verts[v] = (vec3_t){ bench_to_f16(bq->corner[v][0]), bench_to_f16(bq->corner[v][1]),
+                           bench_to_f16(bq->corner[v][2]) };
+    mat34_t model = {{
+      { F16_ONE, 0, 0, bench_to_f16(bq->at[0]) },
+      { 0, F16_ONE, 0, bench_to_f16(bq->at[1]) },
+      { 0, 0, F16_ONE, bench_to_f16(bq->at[2]) },
+    }};
+
+    int wrong = 0;
+    for (int w = 0; w < 2; w++)
+    {
+      mesh_t mesh = { .vertices = verts, .num_vertices = 4, .faces = windings[w], .num_faces = 2 };
+      int front = 0;
+      for (int f = 0; f < 2; f++)
+      {
+        const double *a = bq->corner[windings[w][f][0]];
+        const double *b = bq->corner[windings[w][f][1]];
+        const double *c = bq->corner[windings[w][f][2]];
+        double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        double eye[3] = { -bq->at[0] - a[0], -bq->at[1] - a[1], -bq->at[2] - a[2] };
+        front += n[0] * eye[0] + n[1] * eye[1] + n[2] * eye[2] > 0;
+      }
+
+      render_begin_frame();
+      render_mesh(view, &mesh, &model, V_CYAN);
+      int kept = 2 - (int)render_get_stats().faces_culled;
+      wrong += kept != front;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "back faces, %s", bq->name);
+    pass &= bench_check(name, wrong, 0);
+  }
+  return pass;
+}
+
+bool bench_cull(void)
+{
+  const int frames = 2000;
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t view;
+  render_view_init(&view, &proj, NULL);
+
+  mesh_t unbounded = MESH_CUBE;
+  unbounded.radius = 0;
+
+  bool pass = check_big_faces(&view);
+
+  bench_place_models(models, CULL_ENTITIES, (vec3_t){ -INT_TO_F16(20), -INT_TO_F16(20), -INT_TO_F16(10) },
+                     (vec3_t){ INT_TO_F16(20), INT_TO_F16(20), INT_TO_F16(40) });
+  run("200 cubes, frustum culled", &view, &MESH_CUBE, frames);
+  run("200 cubes, no bounds", &view, &unbounded, frames);
+
+  // Culling must not change a single pixel
+#if V_RENDER_STRIPS
+  uint32_t drops = gfx_dropped_commands();
+#endif
+  capture(&view, &MESH_CUBE, frame_culled);
+#if V_RENDER_STRIPS
+  uint32_t drops_culled = gfx_dropped_commands() - drops;
+#endif
+  capture(&view, &unbounded, frame_plain);
+  int diff = 0;
+  for (int i = 0; i < V_BUFFER_SIZE; i++)
+    diff += frame_culled[i] != frame_plain[i];
+  printf("culled vs unculled frame: %d pixels differ\n", diff);
+#if V_RENDER_STRIPS
+  // Off-screen triangles still take display list slots when nothing culls
+  // them, so the unculled frame can lose primitives and differ
+  printf("display list drops: %lu culled, %lu unculled\n", (unsigned long)drops_culled,
+         (unsigned long)(gfx_dropped_commands() - drops - drops_culled));
+#endif
+  return pass;
+}
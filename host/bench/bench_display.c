@@ -0,0 +1,85 @@
+#include "bench.h"
+#include <stdio.h>
+#include "v_display.h"
+#include "v_graphics.h"
+#include "v_config.h"
+#include "v_host.h"
+#include "v_engine.h"
+#include "v_entity.h"
+#include "game.h"
+
+// Frame pacing with the simulated SPI bus: blocking display_draw() against
+// display_present(), which lets the next frame render while this one streams.
+
+#define DRAW_COST_NS 4000000 // Stand-in for on-device update + draw time
+
+static void fake_frame_work(void)
+{
+  entity_snapshot();
+  void_lander.on_update(ENGINE_TICK_DT);
+  void_lander.on_draw(RENDER_SOLID);
+
+  int64_t until = bench_now_ns() + DRAW_COST_NS;
+  while (bench_now_ns() < until) { }
+}
+
+bool bench_display(void)
+{
+  const int frames = 60;
+
+  host_display_set_latency(8000000000LL / V_SPI_SPEED_HZ);
+
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    fake_frame_work();
+    display_draw();
+  }
+  bench_report("display_draw (blocking)", frames, bench_now_ns() - t0, "frame");
+
+  t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    fake_frame_work();
+    display_present();
+  }
+  display_wait_vsync();
+  bench_report("display_present (double-buffered)", frames, bench_now_ns() - t0, "frame");
+
+  host_display_set_latency(0);
+  host_display_flush();
+  return true;
+}
+
+bool bench_dirty(void)
+{
+  const int frames = 300;
+  uint64_t bytes = 0;
+  uint32_t rects = 0;
+
+  for (int i = 0; i < frames; i++)
+  {
+    entity_snapshot();
+    void_lander.on_update(ENGINE_TICK_DT);
+    void_lander.on_draw(RENDER_SOLID);
+    display_present();
+    bytes += display_get_stats()->bytes;
+    rects += display_get_stats()->rects;
+  }
+  display_wait_vsync();
+  printf("%-36s %10.0f bytes/frame %6.2f rects/frame\n", "dirty rects", (double)bytes / frames, (double)rects / frames);
+
+  bytes = 0;
+  for (int i = 0; i < frames; i++)
+  {
+    entity_snapshot();
+    void_lander.on_update(ENGINE_TICK_DT);
+    void_lander.on_draw(RENDER_SOLID);
+    gfx_dirty_invalidate();
+    display_present();
+    bytes += display_get_stats()->bytes;
+  }
+  display_wait_vsync();
+  printf("%-36s %10.0f bytes/frame\n", "full frame", (double)bytes / frames);
+  return true;
+}
@@ -0,0 +1,153 @@
+#include "bench.h"
+
+#include <stdio.h>
+
+#include "v_colors.h"
+#include "v_entity.h"
+#include "v_primitives.h"
+#include "v_transform.h"
+#include "game.h"
+
+// Per-frame entity iteration as the live count grows: an update pass that
+// moves every entity and a draw walk that builds every model matrix, the
+// part of game_draw before render_mesh. The store is churned first so the
+// live entities sit in recycled slots. The old layout, an array of structs
+// with an active flag scanned up to capacity, runs the same passes.
+
+typedef struct {
+  vec3_t pos;
+  vec3_t rot;
+  const mesh_t *mesh;
+  uint16_t color;
+  bool active;
+} flagged_entity_t;
+
+static flagged_entity_t flagged[V_MAX_ENTITIES];
+
+static void model_matrix(mat34_t *model, vec3_t pos, vec3_t rot)
+{
+  mat34_compose(model, rot, F16_ONE, pos);
+}
+
+static void fill_store(int count)
+{
+  static entity_id_t ids[V_MAX_ENTITIES];
+
+  // Fill up, then free a random half and refill, so the live set is not
+  // just the first count slots in order
+  entity_clear();
+  for (int i = 0; i < V_MAX_ENTITIES; i++)
+    ids[i] = entity_create(&MESH_CUBE, (vec3_t){0, 0, 0}, V_CYAN);
+  for (int i = 0; i < V_MAX_ENTITIES; i++)
+  {
+    if (bench_rand() & 1)
+      entity_destroy(ids[i]);
+  }
+  while (entities.count < count)
+    entity_create(&MESH_CUBE, (vec3_t){0, 0, 0}, V_CYAN);
+  while (entities.count > count)
+    entity_destroy(entities.id[bench_rand_range(0, entities.count - 1)]);
+}
+
+static void fill_flagged(int count)
+{
+  for (int i = 0; i < V_MAX_ENTITIES; i++)
+    flagged[i] = (flagged_entity_t){ .mesh = &MESH_CUBE, .color = V_CYAN, .active = false };
+  for (int live = 0; live < count;)
+  {
+    int i = bench_rand_range(0, V_MAX_ENTITIES - 1);
+    if (!flagged[i].active)
+    {
+      flagged[i].active = true;
+      live++;
+    }
+  }
+}
+
+static void run_count(int count, int frames)
+{
+  char label[64];
+  fix16_t step = FLT_TO_F16(0.01f);
+  uint32_t acc = 0;
+
+  fill_store(count);
+  int64_t t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    for (int i = 0; i < entities.count; i++)
+    {
+      entities.pos[i].z = f16_add(entities.pos[i].z, step);
+      entities.rot[i].y = (entities.rot[i].y + 1) & 0xFF;
+    }
+  }
+  snprintf(label, sizeof(label), "%3d store update", count);
+  bench_report(label, (long)frames * count, bench_now_ns() - t0, "entity");
+
+  t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    for (int i = 0; i < entities.count; i++)
+    {
+      mat34_t model;
+      model_matrix(&model, entities.pos[i], entities.rot[i]);
+      acc += (uint32_t)model.m[0][0] + entities.color[i];
+    }
+  }
+  snprintf(label, sizeof(label), "%3d store draw walk", count);
+  bench_report(label, (long)frames * count, bench_now_ns() - t0, "entity");
+
+  fill_flagged(count);
+  t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    for (int i = 0; i < V_MAX_ENTITIES; i++)
+    {
+      if (!flagged[i].active)
+        continue;
+      flagged[i].pos.z = f16_add(flagged[i].pos.z, step);
+      flagged[i].rot.y = (flagged[i].rot.y + 1) & 0xFF;
+    }
+  }
+  snprintf(label, sizeof(label), "%3d flagged array update", count);
+  bench_report(label, (long)frames * count, bench_now_ns() - t0, "entity");
+
+  t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    for (int i = 0; i < V_MAX_ENTITIES; i++)
+    {
+      if (!flagged[i].active)
+        continue;
+      mat34_t model;
+      model_matrix(&model, flagged[i].pos, flagged[i].rot);
+      acc += (uint32_t)model.m[0][0] + flagged[i].color;
+    }
+  }
+  snprintf(label, sizeof(label), "%3d flagged array draw walk", count);
+  bench_report(label, (long)frames * count, bench_now_ns() - t0, "entity");
+
+  bench_sink = acc + (uint32_t)entities.pos[0].z + (uint32_t)flagged[0].pos.z;
+}
+
+bool bench_entity(void)
+{
+  static const int counts[] = { 10, 32, 128, V_MAX_ENTITIES };
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    run_count(counts[i], 20000);
+
+  // Create and destroy pairs on a full-minus-one store
+  fill_store(V_MAX_ENTITIES - 1);
+  const int churn = 1000000;
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < churn; i++)
+  {
+    entity_id_t id = entity_create(&MESH_CUBE, (vec3_t){0, 0, 0}, V_CYAN);
+    entity_destroy(entities.id[(unsigned)i % (unsigned)entities.count]);
+    bench_sink = id;
+  }
+  bench_report("create + destroy", churn, bench_now_ns() - t0, "pair");
+
+  // Leave the game's entities behind for the cases that run after this one
+  void_lander.on_load();
+  return true;
+}
@@ -0,0 +1,156 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "v_fixed.h"
+#include "v_vector.h"
+
+#define SAMPLE_COUNT 4096
+
+// The routines the Newton-Raphson kernels replaced
+static fix16_t ref_div(fix16_t a, fix16_t b)
+{
+  return (fix16_t)(((int64_t)a * F16_ONE) / b);
+}
+
+static fix16_t ref_length(vec3_t v)
+{
+  float x = F16_TO_FLT(v.x);
+  float y = F16_TO_FLT(v.y);
+  float z = F16_TO_FLT(v.z);
+  return FLT_TO_F16(sqrtf(x*x + y*y + z*z));
+}
+
+static vec3_t ref_normalize(vec3_t v)
+{
+  fix16_t len = ref_length(v);
+  if (len == 0) return v;
+  return (vec3_t){ ref_div(v.x, len), ref_div(v.y, len), ref_div(v.z, len) };
+}
+
+// Exact floor(sqrt(x)) and floor(1 / sqrt(x)) in Q16.16 for the sweep
+static fix16_t exact_sqrt(fix16_t x)
+{
+  uint64_t t = (uint64_t)x << 16;
+  uint64_t r = (uint64_t)sqrt((double)t);
+  while (r * r > t) r--;
+  while ((r + 1) * (r + 1) <= t) r++;
+  return (fix16_t)r;
+}
+
+static fix16_t exact_rsqrt(fix16_t x)
+{
+  uint64_t u = (uint64_t)x;
+  uint64_t r = (uint64_t)(16777216.0 / sqrt((double)u));
+  while (r * r * u > (1ull << 48)) r--;
+  while ((r + 1) * (r + 1) * u <= (1ull << 48)) r++;
+  return (fix16_t)r;
+}
+
+static fix16_t num[SAMPLE_COUNT];
+static fix16_t den[SAMPLE_COUNT];
+static vec3_t vecs[SAMPLE_COUNT];
+
+// Spread inputs over many magnitudes, the kernels normalise by leading zeros
+static fix16_t rand_fix(void)
+{
+  int shift = bench_rand_range(0, 30);
+  return (fix16_t)((bench_rand() >> 1) >> shift) | 1;
+}
+
+bool bench_fixed(void)
+{
+  for (int i = 0; i < SAMPLE_COUNT; i++)
+  {
+    num[i] = bench_rand_range(-INT_TO_F16(200), INT_TO_F16(200));
+    den[i] = bench_rand_range(INT_TO_F16(1) / 2, INT_TO_F16(64));
+    vecs[i].x = bench_rand_range(-INT_TO_F16(8), INT_TO_F16(8));
+    vecs[i].y = bench_rand_range(-INT_TO_F16(8), INT_TO_F16(8));
+    vecs[i].z = bench_rand_range(-INT_TO_F16(8), INT_TO_F16(8)) | 1;
+  }
+
+  const int rounds = 500;
+  const long items = (long)rounds * SAMPLE_COUNT;
+  uint32_t acc = 0;
+  int64_t t0;
+
+#define RUN(label, expr)                                        \
+  t0 = bench_now_ns();                                          \
+  for (int r = 0; r < rounds; r++)                              \
+    for (int i = 0; i < SAMPLE_COUNT; i++)                      \
+      acc += (uint32_t)(expr);                                  \
+  bench_report(label, items, bench_now_ns() - t0, "op");
+
+  RUN("div (int64 divide)", ref_div(num[i], den[i]));
+  RUN("f16_div", f16_div(num[i], den[i]));
+  RUN("recip (int64 divide)", ref_div(F16_ONE, den[i]));
+  RUN("f16_recip", f16_recip(den[i]));
+  RUN("sqrt (float sqrtf)", FLT_TO_F16(sqrtf(F16_TO_FLT(den[i]))));
+  RUN("f16_sqrt", f16_sqrt(den[i]));
+  RUN("rsqrt (float 1/sqrtf)", FLT_TO_F16(1.0f / sqrtf(F16_TO_FLT(den[i]))));
+  RUN("f16_rsqrt", f16_rsqrt(den[i]));
+  RUN("vec3_length (float)", ref_length(vecs[i]));
+  RUN("vec3_length", vec3_length(vecs[i]));
+  RUN("vec3_normalize (float + divide)", ref_normalize(vecs[i]).z);
+  RUN("vec3_normalize", vec3_normalize(vecs[i]).z);
+#undef RUN
+
+  // How far the fixed-point normals drift from the float path, in ulp
+  int worst = 0;
+  for (int i = 0; i < SAMPLE_COUNT; i++)
+  {
+    vec3_t a = ref_normalize(vecs[i]);
+    vec3_t b = vec3_normalize(vecs[i]);
+    int d = abs(a.x - b.x) + abs(a.y - b.y) + abs(a.z - b.z);
+    if (d > worst) worst = d;
+  }
+  printf("vec3_normalize vs float: max %d ulp summed over xyz\n", worst);
+
+  bench_sink = acc;
+  return true;
+}
+
+// Every positive input for recip, sqrt and rsqrt, plus random quotients.
+// Slow, run it on its own: void_bench accuracy
+bool bench_accuracy(void)
+{
+  long bad_recip = 0, bad_sqrt = 0, bad_rsqrt = 0, bad_div = 0;
+  int64_t t0 = bench_now_ns();
+
+  for (uint32_t u = 1; u <= 0x7FFFFFFFu; u++)
+  {
+    fix16_t x = (fix16_t)u;
+    // 1/x only fits for x >= 2 counts, below that it must saturate
+    fix16_t want = u >= 3 ? ref_div(F16_ONE, x) : INT32_MAX;
+    fix16_t want_neg = u >= 3 ? -want : INT32_MIN;
+    if (f16_recip(x) != want || f16_recip(-x) != want_neg)
+      bad_recip++;
+    if (f16_sqrt(x) != exact_sqrt(x))
+      bad_sqrt++;
+    if (f16_rsqrt(x) != exact_rsqrt(x))
+      bad_rsqrt++;
+  }
+
+  const long pairs = 1L << 26;
+  for (long i = 0; i < pairs; i++)
+  {
+    fix16_t a = rand_fix();
+    fix16_t b = rand_fix();
+    if (bench_rand() & 1) a = -a;
+    if (bench_rand() & 1) b = -b;
+    int64_t q = ((int64_t)a * F16_ONE) / b;
+    if (q > INT32_MAX || q < INT32_MIN)
+      continue;
+    if (f16_div(a, b) != (fix16_t)q)
+      bad_div++;
+  }
+
+  printf("f16_recip: %ld mismatches over all non-zero inputs\n", bad_recip);
+  printf("f16_sqrt:  %ld mismatches over all positive inputs\n", bad_sqrt);
+  printf("f16_rsqrt: %ld mismatches over all positive inputs\n", bad_rsqrt);
+  printf("f16_div:   %ld mismatches over %ld random pairs\n", bad_div, pairs);
+  bench_report("accuracy sweep", 0x7FFFFFFFL, bench_now_ns() - t0, "input");
+  return true;
+}
@@ -0,0 +1,40 @@
+#include "bench.h"
+#include "v_engine.h"
+#include "v_entity.h"
+#include "v_render.h"
+#include "game.h"
+
+#include <stdio.h>
+
+bool bench_game(void)
+{
+  const int frames = 5000;
+  render_stats_t total = {0};
+
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    entity_snapshot();
+    void_lander.on_update(ENGINE_TICK_DT);
+    render_begin_frame();
+    void_lander.on_draw(RENDER_SOLID);
+
+    render_stats_t s = render_get_stats();
+    total.entities_drawn += s.entities_drawn;
+    total.entities_culled += s.entities_culled;
+    total.faces_drawn += s.faces_drawn;
+    total.faces_clipped += s.faces_clipped;
+    total.faces_culled += s.faces_culled;
+    total.verts_transformed += s.verts_transformed;
+    total.verts_skipped += s.verts_skipped;
+  }
+  bench_report("game_update + game_draw", frames, bench_now_ns() - t0, "frame");
+
+  printf("per frame: %.1f entities drawn, %.1f culled\n",
+         (double)total.entities_drawn / frames, (double)total.entities_culled / frames);
+  printf("per frame: %.1f faces drawn (%.1f near clipped), %.1f culled, %.1f verts transformed, %.1f skipped\n",
+         (double)total.faces_drawn / frames, (double)total.faces_clipped / frames,
+         (double)total.faces_culled / frames,
+         (double)total.verts_transformed / frames, (double)total.verts_skipped / frames);
+  return true;
+}
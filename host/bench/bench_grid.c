@@ -0,0 +1,212 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "v_camera.h"
+#include "v_config.h"
+#include "v_entity.h"
+#include "v_grid.h"
+#include "game.h"
+
+// 1k to 10k items scattered through a 64 unit cube, indexed by a 16^3 grid
+// of 4 unit cells. Each query runs against the grid and against a linear
+// scan of every item, and the two must agree: exactly for radius queries,
+// and for the frustum the grid has to return a superset of what the
+// per-item sphere test keeps. The game-sized case times the entity store's
+// own sync and frustum query on the game's entities against the per-entity
+// sphere test game_draw ran before the grid.
+
+#define GRID_MAX_ITEMS 10000
+#define GRID_DIM       16
+#define GRID_SHIFT     18 // 4.0 units
+
+static grid_t grid;
+static uint16_t heads[GRID_DIM * GRID_DIM * GRID_DIM];
+static grid_item_t items[GRID_MAX_ITEMS];
+static vec3_t pos[GRID_MAX_ITEMS];
+static vec3_t vel[GRID_MAX_ITEMS];
+static fix16_t extent[GRID_MAX_ITEMS];
+static uint16_t out[GRID_MAX_ITEMS];
+static uint8_t seen[GRID_MAX_ITEMS];
+
+static fix16_t rand_coord(void)
+{
+  return bench_rand_range(-INT_TO_F16(32), INT_TO_F16(32) - 1);
+}
+
+static void populate(int count)
+{
+  vec3_t origin = { -INT_TO_F16(32), -INT_TO_F16(32), -INT_TO_F16(32) };
+  grid_init(&grid, origin, GRID_SHIFT, GRID_DIM, GRID_DIM, GRID_DIM, F16_ONE, heads, items, GRID_MAX_ITEMS);
+  for (int i = 0; i < count; i++)
+  {
+    pos[i] = (vec3_t){ rand_coord(), rand_coord(), rand_coord() };
+    vel[i] = (vec3_t){ bench_rand_range(-F16_ONE / 8, F16_ONE / 8), bench_rand_range(-F16_ONE / 8, F16_ONE / 8),
+                       bench_rand_range(-F16_ONE / 8, F16_ONE / 8) };
+    extent[i] = bench_rand_range(F16_ONE / 4, F16_ONE);
+    grid_insert(&grid, i, pos[i], extent[i]);
+  }
+}
+
+static int linear_radius(int count, vec3_t c, fix16_t r)
+{
+  int64_t r2 = (int64_t)r * r;
+  int n = 0;
+  for (int i = 0; i < count; i++)
+  {
+    int64_t dx = pos[i].x - c.x, dy = pos[i].y - c.y, dz = pos[i].z - c.z;
+    if (dx * dx + dy * dy + dz * dz <= r2)
+      out[n++] = (uint16_t)i;
+  }
+  return n;
+}
+
+static int linear_frustum(int count, const frustum_t *f, const mat34_t *view)
+{
+  int n = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (frustum_test_sphere(f, mat34_transform(view, pos[i]), extent[i]) != CULL_OUTSIDE)
+      out[n++] = (uint16_t)i;
+  }
+  return n;
+}
+
+static void run_count(int count)
+{
+  char label[64];
+  const int queries = 2000;
+  const fix16_t radius = INT_TO_F16(3);
+
+  populate(count);
+
+  // Neighbour queries around random points
+  vec3_t centers[64];
+  for (int q = 0; q < 64; q++)
+    centers[q] = (vec3_t){ rand_coord(), rand_coord(), rand_coord() };
+
+  long found_grid = 0, found_linear = 0;
+  int64_t t0 = bench_now_ns();
+  for (int q = 0; q < queries; q++)
+    found_grid += grid_query_radius(&grid, centers[q & 63], radius, out, GRID_MAX_ITEMS);
+  snprintf(label, sizeof(label), "%5d radius 3, grid", count);
+  bench_report(label, queries, bench_now_ns() - t0, "query");
+
+  t0 = bench_now_ns();
+  for (int q = 0; q < queries; q++)
+    found_linear += linear_radius(count, centers[q & 63], radius);
+  snprintf(label, sizeof(label), "%5d radius 3, linear", count);
+  bench_report(label, queries, bench_now_ns() - t0, "query");
+  if (found_grid != found_linear)
+    printf("  MISMATCH: grid found %ld, linear %ld\n", found_grid, found_linear);
+
+  // Camera in the middle of the cube looking down +z, turning about y
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  frustum_t frustum;
+  frustum_from_projection(&frustum, &proj, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT);
+
+  mat34_t views[16];
+  for (int v = 0; v < 16; v++)
+  {
+    mat4_t r = mat4_rotate_y(v * 16);
+    mat34_from_mat4(&views[v], &r);
+  }
+
+  const int frustum_queries = 200;
+  long candidates = 0, visible = 0, missed = 0;
+  t0 = bench_now_ns();
+  for (int q = 0; q < frustum_queries; q++)
+    candidates += grid_query_frustum(&grid, &frustum, &views[q & 15], out, GRID_MAX_ITEMS);
+  snprintf(label, sizeof(label), "%5d frustum, grid", count);
+  bench_report(label, frustum_queries, bench_now_ns() - t0, "query");
+
+  t0 = bench_now_ns();
+  for (int q = 0; q < frustum_queries; q++)
+    visible += linear_frustum(count, &frustum, &views[q & 15]);
+  snprintf(label, sizeof(label), "%5d frustum, linear", count);
+  bench_report(label, frustum_queries, bench_now_ns() - t0, "query");
+
+  for (int v = 0; v < 16; v++)
+  {
+    memset(seen, 0, sizeof(seen));
+    int n = grid_query_frustum(&grid, &frustum, &views[v], out, GRID_MAX_ITEMS);
+    for (int k = 0; k < n; k++)
+      seen[out[k]] = 1;
+    n = linear_frustum(count, &frustum, &views[v]);
+    for (int k = 0; k < n; k++)
+      missed += !seen[out[k]];
+  }
+  printf("  %.1f grid candidates for %.1f visible per query, %ld visible items missed\n",
+         (double)candidates / frustum_queries, (double)visible / frustum_queries, missed);
+
+  // Everything drifts a little each frame, only cell crossings relink
+  const int frames = 100;
+  t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      pos[i] = vec3_add(pos[i], vel[i]);
+      grid_move(&grid, i, pos[i]);
+    }
+  }
+  snprintf(label, sizeof(label), "%5d move all", count);
+  bench_report(label, (long)frames * count, bench_now_ns() - t0, "item");
+}
+
+static void run_game_sized(void)
+{
+  void_lander.on_load();
+
+  camera_t cam;
+  projection_t proj;
+  frustum_t frustum;
+  mat34_t view;
+  camera_init(&cam, (vec3_t){0, 0, INT_TO_F16(-6)}, 40, FLT_TO_F16(0.5f));
+  camera_projection(&cam, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT, &proj);
+  frustum_from_projection(&frustum, &proj, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT);
+  camera_view(&cam, &view);
+
+  char label[64];
+  const int frames = 200000;
+  long drawn_grid = 0, drawn_linear = 0;
+  int64_t t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    entity_sync_grid();
+    drawn_grid += entity_query_frustum(&frustum, &view, out, V_MAX_ENTITIES);
+  }
+  snprintf(label, sizeof(label), "%5d entities, sync + query", entities.count);
+  bench_report(label, frames, bench_now_ns() - t0, "frame");
+
+  t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    for (int i = 0; i < entities.count; i++)
+    {
+      const mesh_t *mesh = entities.mesh[i];
+      fix16_t r = f16_add(mesh->radius, vec3_length(mesh->center));
+      drawn_linear += frustum_test_sphere(&frustum, mat34_transform(&view, entities.pos[i]), r) != CULL_OUTSIDE;
+    }
+  }
+  snprintf(label, sizeof(label), "%5d entities, linear", entities.count);
+  bench_report(label, frames, bench_now_ns() - t0, "frame");
+  if (drawn_grid < drawn_linear)
+    printf("  MISSED: grid kept %ld, linear %ld\n", drawn_grid, drawn_linear);
+}
+
+bool bench_grid(void)
+{
+  run_game_sized();
+
+  static const int counts[] = { 1000, 2000, 5000, 10000 };
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    run_count(counts[i]);
+  return true;
+}
@@ -0,0 +1,112 @@
+#include "bench.h"
+
+#include <stdio.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_render.h"
+
+// Spheres strewn from just in front of the camera to far away, drawn at full
+// detail and through a chain of coarser tessellations picked by depth. The
+// second half swings one sphere back and forth across a switch distance to
+// count how often the level flips with and without hysteresis.
+
+#define LOD_SPHERES 48
+#define LOD_LEVELS  3
+#define LOD_MAX_VERTS 256
+#define LOD_MAX_FACES 512
+
+static vec3_t positions[LOD_LEVELS][LOD_MAX_VERTS];
+static uint16_t faces[LOD_LEVELS][LOD_MAX_FACES][3];
+static mesh_t levels[LOD_LEVELS];
+static mat34_t models[LOD_SPHERES];
+static uint8_t level_state[LOD_SPHERES];
+
+static void place_spheres(void)
+{
+  for (int i = 0; i < LOD_SPHERES; i++)
+  {
+    fix16_t z = bench_rand_range(INT_TO_F16(3), INT_TO_F16(40));
+    models[i] = (mat34_t){{
+      { F16_ONE, 0, 0, f16_mul(bench_rand_range(-F16_ONE / 2, F16_ONE / 2), z) },
+      { 0, F16_ONE, 0, f16_mul(bench_rand_range(-F16_ONE / 2, F16_ONE / 2), z) },
+      { 0, 0, F16_ONE, z },
+    }};
+  }
+}
+
+typedef struct {
+  const render_view_t *view;
+  const mesh_lod_t *lod;
+} scene_t;
+
+static void draw_scene(void *ctx, int frame)
+{
+  const scene_t *scene = ctx;
+  (void)frame;
+  for (int i = 0; i < LOD_SPHERES; i++)
+  {
+    if (scene->lod)
+      render_mesh_lod(scene->view, scene->lod, &level_state[i], &models[i], V_CYAN);
+    else
+      render_mesh(scene->view, &levels[0], &models[i], V_CYAN);
+  }
+}
+
+static void run(const char *label, const render_view_t *view, const mesh_lod_t *lod, int frames)
+{
+  scene_t scene = { view, lod };
+  render_stats_t st = bench_draw_frames(label, frames, draw_scene, &scene, NULL);
+  printf("  %.1f faces drawn, %.1f saved by %.1f coarse entities per frame\n", (double)st.faces_drawn / frames,
+         (double)st.lod_faces_saved / frames, (double)st.lod_coarse / frames);
+}
+
+// Level changes of one sphere whose depth wobbles around switch_z[1]
+static void run_flicker(mesh_lod_t *lod, fix16_t hysteresis)
+{
+  const int steps = 10000;
+  lod->hysteresis = hysteresis;
+  uint8_t level = 0;
+  int changes = 0;
+  for (int i = 0; i < steps; i++)
+  {
+    fix16_t wobble = bench_rand_range(-F16_ONE / 4, F16_ONE / 4);
+    int prev = level;
+    level = (uint8_t)mesh_lod_select(lod, level, lod->switch_z[1] + wobble);
+    changes += level != prev;
+  }
+  printf("depth within +-0.25 of a switch, hysteresis %.2f: %d level changes in %d frames\n",
+         hysteresis / 65536.0, changes, steps);
+}
+
+bool bench_lod(void)
+{
+  static const int sizes[LOD_LEVELS][2] = { { 14, 18 }, { 8, 10 }, { 5, 6 } };
+  const int frames = 2000;
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t view;
+  render_view_init(&view, &proj, NULL);
+
+  // Each level takes over where the sphere is about 24 and 12 pixels in radius
+  mesh_lod_t lod = { .num_levels = LOD_LEVELS, .switch_z = { 0, INT_TO_F16(6), INT_TO_F16(12) },
+                     .hysteresis = F16_ONE / 2 };
+  for (int l = 0; l < LOD_LEVELS; l++)
+  {
+    levels[l] = bench_make_sphere(positions[l], faces[l], sizes[l][0], sizes[l][1]);
+    lod.levels[l] = &levels[l];
+  }
+
+  place_spheres();
+  run("48 spheres, full detail", &view, NULL, frames);
+  run("48 spheres, LOD chain", &view, &lod, frames);
+
+  run_flicker(&lod, 0);
+  run_flicker(&lod, F16_ONE / 2);
+  return true;
+}
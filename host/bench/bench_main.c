@@ -0,0 +1,232 @@
+#define _XOPEN_SOURCE 600 // clock_gettime, and M_PI from math.h
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_engine.h"
+#include "v_graphics.h"
+#include "game.h"
+
+volatile uint32_t bench_sink = 0;
+
+static uint32_t rand_state = 0x12345678;
+
+typedef struct {
+  const char *name;
+  bool (*run)(void);
+  int explicit_only; // too slow for the default run, name it to run it
+} bench_case_t;
+
+static const bench_case_t cases[] = {
+  { "raster", bench_raster },
+  { "math",   bench_math },
+  { "fixed",  bench_fixed },
+  { "accuracy", bench_accuracy, 1 },
+  { "game",   bench_game },
+  { "cull",   bench_cull },
+  { "wire",   bench_wire },
+  { "entity", bench_entity },
+  { "grid",   bench_grid },
+  { "display", bench_display },
+  { "dirty",  bench_dirty },
+  { "palette", bench_palette },
+  { "shade",  bench_shade },
+  { "texture", bench_texture },
+  { "lod",    bench_lod },
+  { "cache",  bench_cache },
+  { "camera", bench_camera },
+  { "rotation", bench_rotation },
+};
+
+int64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void bench_report(const char *name, long items, int64_t ns, const char *unit)
+{
+  double per = items ? (double)ns / items : 0.0;
+  double rate = ns ? items * 1e9 / ns : 0.0;
+  printf("%-36s %10ld %-10s %10.3f ms %10.2f ns/%s %12.0f %s/s\n",
+         name, items, unit, ns / 1e6, per, unit, rate, unit);
+}
+
+uint32_t bench_rand(void)
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+int bench_rand_range(int lo, int hi)
+{
+  return lo + (int)(bench_rand() % (uint32_t)(hi - lo + 1));
+}
+
+fix16_t bench_to_f16(double v)
+{
+  return (fix16_t)lround(v * 65536.0);
+}
+
+double bench_to_double(fix16_t v)
+{
+  return v / 65536.0;
+}
+
+bool bench_check(const char *name, double error, double limit)
+{
+  bool pass = error <= limit;
+  printf("check %-40s max error %.6f (limit %.6f): %s\n", name, error, limit, pass ? "PASS" : "FAIL");
+  return pass;
+}
+
+mesh_t bench_make_sphere(vec3_t *pos, uint16_t (*tri)[3], int stacks, int slices)
+{
+  int n = 0;
+  pos[n++] = (vec3_t){ 0, -F16_ONE, 0 };
+  for (int s = 1; s < stacks; s++)
+  {
+    double lat = M_PI * s / stacks - M_PI / 2;
+    for (int k = 0; k < slices; k++)
+    {
+      double lon = 2 * M_PI * k / slices;
+      pos[n++] = (vec3_t){ bench_to_f16(cos(lat) * cos(lon)), bench_to_f16(sin(lat)),
+                           bench_to_f16(cos(lat) * sin(lon)) };
+    }
+  }
+  pos[n++] = (vec3_t){ 0, F16_ONE, 0 };
+  int top = n - 1;
+
+  int f = 0;
+  for (int s = 0; s < stacks; s++)
+  {
+    for (int k = 0; k < slices; k++)
+    {
+      int k1 = (k + 1) % slices;
+      int a = 1 + (s - 1) * slices + k, b = 1 + (s - 1) * slices + k1;
+      int c = 1 + s * slices + k, d = 1 + s * slices + k1;
+      if (s == 0)
+      {
+        tri[f][0] = 0; tri[f][1] = (uint16_t)c; tri[f][2] = (uint16_t)d; f++;
+      }
+      else if (s == stacks - 1)
+      {
+        tri[f][0] = (uint16_t)a; tri[f][1] = (uint16_t)top; tri[f][2] = (uint16_t)b; f++;
+      }
+      else
+      {
+        tri[f][0] = (uint16_t)a; tri[f][1] = (uint16_t)c; tri[f][2] = (uint16_t)d; f++;
+        tri[f][0] = (uint16_t)a; tri[f][1] = (uint16_t)d; tri[f][2] = (uint16_t)b; f++;
+      }
+    }
+  }
+
+  return (mesh_t){
+    .vertices = pos,
+    .num_vertices = n,
+    .faces = tri,
+    .num_faces = f,
+    .wide_indices = true,
+    .center = { 0, 0, 0 },
+    .radius = F16_ONE + F16_ONE / 64,
+  };
+}
+
+void bench_place_models(mat34_t *models, int count, vec3_t lo, vec3_t hi)
+{
+  for (int i = 0; i < count; i++)
+  {
+    // Angles are 256 to the turn
+    mat4_t ry = mat4_rotate_y(bench_rand_range(0, 255));
+    mat4_t rx = mat4_rotate_x(bench_rand_range(0, 255));
+    mat4_t rot;
+    mat4_mul_into(&rot, &ry, &rx);
+
+    mat34_from_mat4(&models[i], &rot);
+    models[i].m[0][3] = bench_rand_range(lo.x, hi.x);
+    models[i].m[1][3] = bench_rand_range(lo.y, hi.y);
+    models[i].m[2][3] = bench_rand_range(lo.z, hi.z);
+  }
+}
+
+static void add_stats(render_stats_t *total, const render_stats_t *s)
+{
+  total->entities_drawn += s->entities_drawn;
+  total->entities_culled += s->entities_culled;
+  total->faces_drawn += s->faces_drawn;
+  total->faces_clipped += s->faces_clipped;
+  total->edges_drawn += s->edges_drawn;
+  total->faces_culled += s->faces_culled;
+  total->verts_transformed += s->verts_transformed;
+  total->verts_skipped += s->verts_skipped;
+  total->lod_coarse += s->lod_coarse;
+  total->lod_faces_saved += s->lod_faces_saved;
+  total->cache_hits += s->cache_hits;
+  total->cache_misses += s->cache_misses;
+  total->cache_evictions += s->cache_evictions;
+}
+
+render_stats_t bench_draw_frames(const char *label, int frames, void (*draw)(void *ctx, int frame), void *ctx,
+                                 int64_t *ns)
+{
+  render_stats_t total = {0};
+  int64_t t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    gfx_clear(V_BLACK);
+#if V_DEPTH_BUFFER
+    gfx_depth_clear();
+#endif
+    render_begin_frame();
+    draw(ctx, f);
+    render_stats_t s = render_get_stats();
+    add_stats(&total, &s);
+  }
+  int64_t t = bench_now_ns() - t0;
+  if (label)
+    bench_report(label, frames, t, "frame");
+  if (ns)
+    *ns = t;
+  return total;
+}
+
+int main(int argc, char **argv)
+{
+  // The display backend owns the framebuffer, bring the engine up once
+  engine_init(&void_lander);
+
+  int ran = 0, failed = 0;
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+  {
+    int selected = argc < 2 && !cases[i].explicit_only;
+    for (int a = 1; a < argc; a++)
+      if (!strcmp(argv[a], cases[i].name)) selected = 1;
+
+    if (!selected) continue;
+
+    printf("== %s\n", cases[i].name);
+    rand_state = 0x12345678;
+    failed += !cases[i].run();
+    ran++;
+  }
+
+  if (!ran)
+  {
+    fprintf(stderr, "usage: %s [case...]\ncases:", argv[0]);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+      fprintf(stderr, " %s", cases[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+  }
+  if (failed)
+    printf("%d case%s FAILED\n", failed, failed == 1 ? "" : "s");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+#include "v_matrix.h"
+#include "v_transform.h"
+
+#define VERT_COUNT 1024
+
+static vec3_t verts[VERT_COUNT];
+
+static fix16_t out_x[VERT_COUNT], out_y[VERT_COUNT], out_z[VERT_COUNT];
+static fix16_t out_sx[VERT_COUNT], out_sy[VERT_COUNT];
+static uint8_t out_code[VERT_COUNT];
+
+bool bench_math(void)
+{
+  for (int i = 0; i < VERT_COUNT; i++)
+  {
+    verts[i].x = bench_rand_range(-INT_TO_F16(4), INT_TO_F16(4));
+    verts[i].y = bench_rand_range(-INT_TO_F16(4), INT_TO_F16(4));
+    verts[i].z = bench_rand_range(-INT_TO_F16(4), INT_TO_F16(4));
+  }
+
+  const int rounds = 2000;
+  mat4_t m = mat4_mul(mat4_rotate_y(37), mat4_rotate_x(11));
+
+  int64_t t0 = bench_now_ns();
+  uint32_t acc = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < VERT_COUNT; i++)
+    {
+      vec3_t p = mat4_mul_vec3(m, verts[i]);
+      acc += p.x ^ p.y ^ p.z;
+    }
+  }
+  bench_report("mat4_mul_vec3", (long)rounds * VERT_COUNT, bench_now_ns() - t0, "vert");
+
+  // The per-vertex path game_draw used: by-value mat4, translate, two divides
+  fix16_t fov = INT_TO_F16(150);
+  fix16_t near = FLT_TO_F16(0.5f);
+  vec3_t pos = { INT_TO_F16(1), 0, INT_TO_F16(6) };
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < VERT_COUNT; i++)
+    {
+      vec3_t p = vec3_add(mat4_mul_vec3(m, verts[i]), pos);
+      if (p.z < near)
+        p.z = near;
+      out_x[i] = f16_add(f16_mul(p.x, f16_div(fov, p.z)), INT_TO_F16(80));
+      out_y[i] = f16_add(f16_mul(p.y, f16_div(fov, p.z)), INT_TO_F16(64));
+    }
+    acc += out_x[r & (VERT_COUNT - 1)];
+  }
+  bench_report("project (per vertex)", (long)rounds * VERT_COUNT, bench_now_ns() - t0, "vert");
+
+  mat34_t m34;
+  mat34_from_mat4(&m34, &m);
+  m34.m[0][3] = pos.x;
+  m34.m[1][3] = pos.y;
+  m34.m[2][3] = pos.z;
+  projection_t proj = { fov, INT_TO_F16(80), INT_TO_F16(64), near };
+  vertex_soa_t out = { out_x, out_y, out_z, out_sx, out_sy, out_code };
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    acc += transform_project(&m34, &proj, verts, VERT_COUNT, &out);
+    acc += out_sx[r & (VERT_COUNT - 1)];
+  }
+  bench_report("transform_project (batch)", (long)rounds * VERT_COUNT, bench_now_ns() - t0, "vert");
+
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds * 64; r++)
+  {
+    m = mat4_mul(m, mat4_rotate_z(r));
+    acc += m.m[0][0];
+  }
+  bench_report("mat4_mul", (long)rounds * 64, bench_now_ns() - t0, "mul");
+
+  bench_sink = acc;
+  return true;
+}
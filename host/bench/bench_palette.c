@@ -0,0 +1,64 @@
+#include "bench.h"
+#include "v_display.h"
+#include "v_graphics.h"
+#include "v_host.h"
+
+#include <stdio.h>
+
+// Fill rate into the framebuffer and the cost of getting a whole frame out
+// of it. Run it once built with V_INDEXED_COLOR 0 and once with 1: indexed
+// pixels are one byte with no swap, and pay for that with the palette
+// expansion inside display_present. The host panel model's own copy is in
+// both present numbers.
+
+#if !V_RENDER_STRIPS
+
+bool bench_palette(void)
+{
+  const fix16_t w = INT_TO_F16(V_DISPLAY_WIDTH), h = INT_TO_F16(V_DISPLAY_HEIGHT);
+  const int frames = 1000;
+
+  printf("%-36s %10ld bytes\n", V_INDEXED_COLOR ? "framebuffer, indexed" : "framebuffer, rgb565",
+         (long)(V_BUFFER_SIZE * sizeof(gfx_pixel_t)));
+
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+    gfx_fill_rect(0, 0, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT, (uint16_t)(i | 1));
+  bench_report("fill rate rect", (long)frames * V_BUFFER_SIZE, bench_now_ns() - t0, "px");
+
+  t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    gfx_fill_triangle_fx(0, 0, w, 0, 0, h, (uint16_t)(i | 1));
+    gfx_fill_triangle_fx(w, 0, w, h, 0, h, (uint16_t)(i | 1));
+  }
+  bench_report("fill rate triangles", (long)frames * V_BUFFER_SIZE, bench_now_ns() - t0, "px");
+
+  t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+    gfx_clear((uint16_t)i);
+  bench_report("gfx_clear", frames, bench_now_ns() - t0, "frame");
+
+  // Instant transport, so this is the CPU side of sending a full frame
+  host_display_set_latency(0);
+  t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    gfx_dirty_invalidate();
+    display_present();
+  }
+  display_wait_vsync();
+  bench_report("display_present full frame", frames, bench_now_ns() - t0, "frame");
+  host_display_flush();
+  return true;
+}
+
+#else
+
+bool bench_palette(void)
+{
+  printf("palette bench needs the framebuffer path (V_RENDER_STRIPS 0)\n");
+  return true;
+}
+
+#endif
@@ -0,0 +1,412 @@
+#include "bench.h"
+#include "v_graphics.h"
+#include "v_colors.h"
+#include "v_render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !V_RENDER_STRIPS
+
+#define TRI_COUNT 4096
+
+extern gfx_pixel_t *v_frameBuffer;
+
+typedef struct {
+  int x[3], y[3];
+} bench_tri_t;
+
+static bench_tri_t tris[TRI_COUNT];
+
+static void ref_swap(int *a, int *b)
+{
+  int t = *a;
+  *a = *b;
+  *b = t;
+}
+
+// The float scanline routine gfx_fill_triangle used before the fixed-point
+// rasterizer, kept here as the reference for coverage and speed.
+static void ref_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color)
+{
+  if (y1 > y2) { ref_swap(&x1, &x2); ref_swap(&y1, &y2); }
+  if (y1 > y3) { ref_swap(&x1, &x3); ref_swap(&y1, &y3); }
+  if (y2 > y3) { ref_swap(&x2, &x3); ref_swap(&y2, &y3); }
+
+  int total_height = y3 - y1;
+  if (total_height == 0) return;
+
+  int i_start = (y1 < 0) ? -y1 : 0;
+  int i_end   = (y1 + total_height > V_DISPLAY_HEIGHT) ? V_DISPLAY_HEIGHT - y1 : total_height;
+
+  for(int i = i_start; i < i_end; i++)
+  {
+    int second_half = i > y2 - y1 || y2 == y1;
+    int segment_height = second_half ? y3 - y2 : y2 - y1;
+    if (segment_height == 0)
+      continue;
+
+    float alpha = (float)i / total_height;
+    float beta = (float)(i - (second_half ? y2 - y1 : 0)) / segment_height;
+
+    int A_x = x1 + (x3 - x1) * alpha;
+    int B_x = second_half ? x2 + (x3 - x2) * beta : x1 + (x2 - x1) * beta;
+
+    if (A_x > B_x) ref_swap(&A_x, &B_x);
+    if (A_x < 0) A_x = 0;
+    if (B_x >= V_DISPLAY_WIDTH) B_x = V_DISPLAY_WIDTH - 1;
+
+    for(int j = A_x; j <= B_x; j++)
+      gfx_draw_pixel(j, y1 + i, color);
+  }
+}
+
+// Exact coverage: pixel centres tested against the edges in 64-bit integer
+// maths (Q.4, like the rasterizer's vertex snap), left/top edges inclusive.
+static void exact_fill_triangle(int x1, int y1, int x2, int y2, int x3, int y3, uint16_t color)
+{
+  int64_t X[3] = { x1 * 16 + 8, x2 * 16 + 8, x3 * 16 + 8 };
+  int64_t Y[3] = { y1 * 16 + 8, y2 * 16 + 8, y3 * 16 + 8 };
+
+  // Sort by y
+  for (int a = 0; a < 2; a++)
+    for (int b = 0; b < 2 - a; b++)
+      if (Y[b] > Y[b + 1])
+      {
+        int64_t t = Y[b]; Y[b] = Y[b + 1]; Y[b + 1] = t;
+        t = X[b]; X[b] = X[b + 1]; X[b + 1] = t;
+      }
+
+  if (Y[0] == Y[2]) return;
+
+  for (int py = 0; py < V_DISPLAY_HEIGHT; py++)
+  {
+    int64_t yc = py * 16 + 8;
+    if (yc < Y[0] || yc >= Y[2]) continue;
+
+    // Long edge 0-2 against the short edge covering this row, as x = num / den
+    int s0 = yc < Y[1] ? 0 : 1;
+    int64_t ln = X[0] * (Y[2] - Y[0]) + (yc - Y[0]) * (X[2] - X[0]), ld = Y[2] - Y[0];
+    int64_t sn = X[s0] * (Y[s0 + 1] - Y[s0]) + (yc - Y[s0]) * (X[s0 + 1] - X[s0]), sd = Y[s0 + 1] - Y[s0];
+
+    for (int px = 0; px < V_DISPLAY_WIDTH; px++)
+    {
+      int64_t xc = px * 16 + 8;
+      // xc >= l and xc < r, with l/r the smaller/larger of the two crossings
+      int l_is_long = ln * sd < sn * ld;
+      int64_t lnum = l_is_long ? ln : sn, lden = l_is_long ? ld : sd;
+      int64_t rnum = l_is_long ? sn : ln, rden = l_is_long ? sd : ld;
+      if (xc * lden >= lnum && xc * rden < rnum)
+        gfx_draw_pixel(px, py, color);
+    }
+  }
+}
+
+// Centres spread over the screen plus margin pixels on every side
+static void make_tris_around(int max_size, int margin)
+{
+  for (int i = 0; i < TRI_COUNT; i++)
+  {
+    int cx = bench_rand_range(-margin, V_DISPLAY_WIDTH - 1 + margin);
+    int cy = bench_rand_range(-margin, V_DISPLAY_HEIGHT - 1 + margin);
+    for (int v = 0; v < 3; v++)
+    {
+      tris[i].x[v] = cx + bench_rand_range(-max_size, max_size);
+      tris[i].y[v] = cy + bench_rand_range(-max_size, max_size);
+    }
+  }
+}
+
+static void make_tris(int max_size)
+{
+  make_tris_around(max_size, 0);
+}
+
+typedef void (*fill_fn)(int, int, int, int, int, int, uint16_t);
+
+static void run_fill(const char *name, fill_fn fill, int rounds)
+{
+  int64_t t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < TRI_COUNT; i++)
+      fill(tris[i].x[0], tris[i].y[0], tris[i].x[1], tris[i].y[1],
+           tris[i].x[2], tris[i].y[2], (uint16_t)(i | 1));
+  int64_t t1 = bench_now_ns();
+
+  bench_report(name, (long)rounds * TRI_COUNT, t1 - t0, "tri");
+}
+
+// Pixels where two rasterizers disagree, over pixels either one covered.
+// Returns the fraction that differ.
+static double compare_n(const char *name, fill_fn reference, int count)
+{
+  static gfx_pixel_t ref[V_BUFFER_SIZE];
+  long covered = 0, differ = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    const bench_tri_t *t = &tris[i];
+
+    gfx_clear(V_BLACK);
+    reference(t->x[0], t->y[0], t->x[1], t->y[1], t->x[2], t->y[2], V_WHITE);
+    memcpy(ref, v_frameBuffer, sizeof(ref));
+
+    gfx_clear(V_BLACK);
+    gfx_fill_triangle(t->x[0], t->y[0], t->x[1], t->y[1], t->x[2], t->y[2], V_WHITE);
+
+    for (int p = 0; p < V_BUFFER_SIZE; p++)
+    {
+      if (ref[p] | v_frameBuffer[p]) covered++;
+      if (ref[p] != v_frameBuffer[p]) differ++;
+    }
+  }
+
+  printf("%-36s %10ld px covered %8ld differ (%.2f%%)\n",
+         name, covered, differ, covered ? 100.0 * differ / covered : 0.0);
+  return covered ? (double)differ / covered : 0.0;
+}
+
+static double compare(const char *name, fill_fn reference)
+{
+  return compare_n(name, reference, TRI_COUNT);
+}
+
+// The float reference is only informative, exact coverage must match
+static bool run_size(const char *label, int max_size, int rounds)
+{
+  char name[64];
+  make_tris(max_size);
+
+  snprintf(name, sizeof(name), "ref float %s", label);
+  run_fill(name, ref_fill_triangle, rounds);
+  snprintf(name, sizeof(name), "gfx_fill_triangle %s", label);
+  run_fill(name, gfx_fill_triangle, rounds);
+  snprintf(name, sizeof(name), "coverage vs ref %s", label);
+  compare(name, ref_fill_triangle);
+  snprintf(name, sizeof(name), "coverage vs exact %s", label);
+  double differ = compare(name, exact_fill_triangle);
+  snprintf(name, sizeof(name), "exact coverage %s", label);
+  return bench_check(name, differ, 0);
+}
+
+// Floor quad at y = 1 from z = 0.6 to 60, drawn by render_mesh, against a
+// ray cast through every pixel centre. Returns the fraction of covered
+// pixels that differ; only pixels along the edges may.
+static double floor_coverage(int half_width)
+{
+  const double focal = 150, z0 = 0.6, z1 = 60;
+  vec3_t verts[4] = {
+    { -INT_TO_F16(half_width), 0, FLT_TO_F16(z0) }, { INT_TO_F16(half_width), 0, FLT_TO_F16(z0) },
+    { INT_TO_F16(half_width), 0, INT_TO_F16(z1) }, { -INT_TO_F16(half_width), 0, INT_TO_F16(z1) },
+  };
+  static const uint8_t faces[4][3] = { { 0, 1, 2 }, { 0, 2, 3 }, { 0, 2, 1 }, { 0, 3, 2 } }; // both windings
+  mesh_t floor = { .vertices = verts, .num_vertices = 4, .faces = faces, .num_faces = 4 };
+  mat34_t model = {{ { F16_ONE, 0, 0, 0 }, { 0, F16_ONE, 0, F16_ONE }, { 0, 0, F16_ONE, 0 } }};
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t view;
+  render_view_init(&view, &proj, NULL);
+
+  gfx_clear(V_BLACK);
+  render_begin_frame();
+  render_mesh(&view, &floor, &model, V_WHITE);
+
+  long covered = 0, differ = 0;
+  for (int py = 0; py < V_DISPLAY_HEIGHT; py++)
+  {
+    for (int px = 0; px < V_DISPLAY_WIDTH; px++)
+    {
+      // The ray through the pixel centre meets y = 1 at depth z
+      double dy = (py + 0.5 - V_DISPLAY_HEIGHT / 2) / focal;
+      double z = dy > 0 ? 1 / dy : 0;
+      double x = (px + 0.5 - V_DISPLAY_WIDTH / 2) / focal * z;
+      bool want = z >= z0 && z <= z1 && x >= -half_width && x <= half_width;
+      bool got = v_frameBuffer[py * V_DISPLAY_WIDTH + px] != V_BLACK;
+      covered += want || got;
+      differ += want != got;
+    }
+  }
+  return covered ? (double)differ / covered : 0.0;
+}
+
+// Triangles reaching past the guard band get cut into polygons, the new
+// vertices are rounded to 1/16 pixel so a few edge pixels may move: up to
+// one covered pixel in 10000 may differ there, none anywhere else
+static bool run_offscreen(void)
+{
+  bool pass = true;
+  make_tris_around(40, 40);
+  run_fill("gfx_fill_triangle crossing edges", gfx_fill_triangle, 20);
+  double differ = compare("coverage vs exact crossing edges", exact_fill_triangle);
+  pass &= bench_check("exact coverage crossing edges", differ, 0);
+
+  make_tris_around(6000, 0);
+  run_fill("gfx_fill_triangle past guard band", gfx_fill_triangle, 2);
+  differ = compare_n("coverage vs exact past guard band", exact_fill_triangle, 256);
+  pass &= bench_check("exact coverage past guard band", differ, 1e-4);
+
+  // Floors running from just in front of the camera out to depth 60. The
+  // near corners of the wide ones project far past the Q16.16 range, and
+  // render_mesh must clip them in view space before the guard band does.
+  static const int half_widths[] = { 2, 100, 250, 1000, 8000 };
+  for (size_t w = 0; w < sizeof(half_widths) / sizeof(half_widths[0]); w++)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "floor %d wide from depth 0.6", half_widths[w] * 2);
+    pass &= bench_check(name, floor_coverage(half_widths[w]), 1e-3);
+  }
+  return pass;
+}
+
+typedef struct {
+  int x0, y0, x1, y1;
+} bench_line_t;
+
+static bench_line_t lines[TRI_COUNT];
+
+// The Bresenham gfx_draw_line used before lines were clipped up front: every
+// pixel went through a bounds check
+static void ref_draw_line(int x0, int y0, int x1, int y1, uint16_t color)
+{
+  int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy, e2;
+
+  while (1)
+  {
+    gfx_draw_pixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1) break;
+    e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+typedef void (*line_fn)(int, int, int, int, uint16_t);
+
+static void make_lines(int margin)
+{
+  for (int i = 0; i < TRI_COUNT; i++)
+  {
+    lines[i].x0 = bench_rand_range(-margin, V_DISPLAY_WIDTH - 1 + margin);
+    lines[i].y0 = bench_rand_range(-margin, V_DISPLAY_HEIGHT - 1 + margin);
+    lines[i].x1 = bench_rand_range(-margin, V_DISPLAY_WIDTH - 1 + margin);
+    lines[i].y1 = bench_rand_range(-margin, V_DISPLAY_HEIGHT - 1 + margin);
+  }
+}
+
+static void run_lines(const char *label, int margin, int rounds)
+{
+  char name[64];
+  make_lines(margin);
+
+  line_fn fns[2] = { ref_draw_line, gfx_draw_line };
+  const char *names[2] = { "ref checked lines", "gfx_draw_line" };
+  for (int f = 0; f < 2; f++)
+  {
+    int64_t t0 = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+      for (int i = 0; i < TRI_COUNT; i++)
+        fns[f](lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, (uint16_t)(i | 1));
+    snprintf(name, sizeof(name), "%s %s", names[f], label);
+    bench_report(name, (long)rounds * TRI_COUNT, bench_now_ns() - t0, "line");
+  }
+
+  // Clipped endpoints are rounded, lines cut by an edge may shift a pixel
+  static gfx_pixel_t ref[V_BUFFER_SIZE];
+  long covered = 0, differ = 0;
+  for (int i = 0; i < 512; i++)
+  {
+    gfx_clear(V_BLACK);
+    ref_draw_line(lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, V_WHITE);
+    memcpy(ref, v_frameBuffer, sizeof(ref));
+    gfx_clear(V_BLACK);
+    gfx_draw_line(lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, V_WHITE);
+    for (int p = 0; p < V_BUFFER_SIZE; p++)
+    {
+      if (ref[p] | v_frameBuffer[p]) covered++;
+      if (ref[p] != v_frameBuffer[p]) differ++;
+    }
+  }
+  snprintf(name, sizeof(name), "lines vs ref %s", label);
+  printf("%-36s %10ld px covered %8ld differ (%.2f%%)\n",
+         name, covered, differ, covered ? 100.0 * differ / covered : 0.0);
+}
+
+typedef void (*quad_fn)(fix16_t z, uint16_t color);
+
+static void quad_plain(fix16_t z, uint16_t color)
+{
+  const fix16_t w = INT_TO_F16(V_DISPLAY_WIDTH), h = INT_TO_F16(V_DISPLAY_HEIGHT);
+  (void)z;
+  gfx_fill_triangle_fx(0, 0, w, 0, 0, h, color);
+  gfx_fill_triangle_fx(w, 0, w, h, 0, h, color);
+}
+
+#if V_DEPTH_BUFFER
+static void quad_depth(fix16_t z, uint16_t color)
+{
+  const fix16_t w = INT_TO_F16(V_DISPLAY_WIDTH), h = INT_TO_F16(V_DISPLAY_HEIGHT);
+  gfx_fill_triangle_depth(0, 0, z, w, 0, z, 0, h, z, color);
+  gfx_fill_triangle_depth(w, 0, z, w, h, z, 0, h, z, color);
+}
+#endif
+
+// Full-screen quads, so every triangle setup is amortised over 10k pixels
+static void run_fillrate(const char *name, quad_fn quad, fix16_t z0, fix16_t dz)
+{
+  const int frames = 400;
+  fix16_t z = z0;
+
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++, z += dz)
+    quad(z, (uint16_t)(i | 1));
+  bench_report(name, (long)frames * V_BUFFER_SIZE, bench_now_ns() - t0, "px");
+}
+
+bool bench_raster(void)
+{
+  run_fillrate("fill rate flat", quad_plain, 0, 0);
+#if V_DEPTH_BUFFER
+  gfx_depth_clear();
+  run_fillrate("fill rate depth, all pass", quad_depth, INT_TO_F16(8), -FLT_TO_F16(0.01f));
+  run_fillrate("fill rate depth, all fail", quad_depth, INT_TO_F16(8), FLT_TO_F16(0.01f));
+
+  int64_t t = bench_now_ns();
+  for (int i = 0; i < 2000; i++)
+    gfx_depth_clear();
+  bench_report("gfx_depth_clear", 2000, bench_now_ns() - t, "frame");
+#endif
+
+  gfx_clear(V_BLACK);
+  bool pass = run_size("small (8px)", 4, 50);
+  pass &= run_size("medium (32px)", 16, 20);
+  pass &= run_size("large (128px)", 64, 4);
+  pass &= run_offscreen();
+
+  run_lines("on screen", 0, 20);
+  run_lines("crossing edges", 100, 20);
+  run_lines("far off screen", 4000, 20);
+
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < 2000; i++)
+    gfx_clear((uint16_t)i);
+  bench_report("gfx_clear", 2000, bench_now_ns() - t0, "frame");
+  return pass;
+}
+
+#else
+
+bool bench_raster(void)
+{
+  printf("raster bench needs the framebuffer path (V_RENDER_STRIPS 0)\n");
+  return true;
+}
+
+#endif
@@ -0,0 +1,244 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "v_matrix.h"
+#include "v_quat.h"
+#include "v_transform.h"
+
+// Entity placement matrices: three rotation matrices chained with mat4_mul
+// against the fused Euler builder and a quaternion. The checks compare them
+// with each other and with double precision, the timings report the
+// multiplies each way costs per entity.
+
+#define ROT_ENTITIES 256
+
+static vec3_t rots[ROT_ENTITIES];
+static vec3_t positions[ROT_ENTITIES];
+static quat_t quats[ROT_ENTITIES];
+static mat34_t models[ROT_ENTITIES];
+
+static void chained(mat34_t *out, vec3_t rot, vec3_t pos)
+{
+  mat4_t rot_y = mat4_rotate_y(rot.y);
+  mat4_t rot_x = mat4_rotate_x(rot.x);
+  mat4_t rot_z = mat4_rotate_z(rot.z);
+  mat4_t yx, m;
+  mat4_mul_into(&yx, &rot_y, &rot_x);
+  mat4_mul_into(&m, &yx, &rot_z);
+  mat34_from_mat4(out, &m);
+  out->m[0][3] = pos.x;
+  out->m[1][3] = pos.y;
+  out->m[2][3] = pos.z;
+}
+
+static double max_diff(const mat34_t *a, const mat34_t *b)
+{
+  double d = 0;
+  for (int r = 0; r < 3; r++)
+  {
+    for (int c = 0; c < 3; c++)
+      d = fmax(d, fabs(bench_to_double(a->m[r][c]) - bench_to_double(b->m[r][c])));
+  }
+  return d;
+}
+
+static quat_t rand_quat(void)
+{
+  quat_t q = { bench_rand_range(-F16_ONE, F16_ONE), bench_rand_range(-F16_ONE, F16_ONE),
+               bench_rand_range(-F16_ONE, F16_ONE), bench_rand_range(-F16_ONE, F16_ONE) };
+  return quat_normalize(q);
+}
+
+// Double precision slerp of a and b, the short way round
+static void ref_slerp(quat_t a, quat_t b, double t, double out[4])
+{
+  double qa[4] = { bench_to_double(a.w), bench_to_double(a.x), bench_to_double(a.y), bench_to_double(a.z) };
+  double qb[4] = { bench_to_double(b.w), bench_to_double(b.x), bench_to_double(b.y), bench_to_double(b.z) };
+  double d = 0;
+  for (int i = 0; i < 4; i++)
+    d += qa[i] * qb[i];
+  if (d < 0)
+  {
+    for (int i = 0; i < 4; i++)
+      qb[i] = -qb[i];
+    d = -d;
+  }
+  double theta = acos(fmin(d, 1)), s = sin(theta);
+  double wa = s > 1e-9 ? sin((1 - t) * theta) / s : 1 - t;
+  double wb = s > 1e-9 ? sin(t * theta) / s : t;
+  double n = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    out[i] = wa * qa[i] + wb * qb[i];
+    n += out[i] * out[i];
+  }
+  for (int i = 0; i < 4; i++)
+    out[i] /= sqrt(n);
+}
+
+static bool check_rotations(void)
+{
+  bool pass = true;
+
+  // The fused builder rounds like the chain it replaces, so it is exact
+  long mismatches = 0, total = 0;
+  for (int y = 0; y < 256; y++)
+  {
+    for (int x = 0; x < 256; x++)
+    {
+      vec3_t rot = { x, y, (x * 7 + y) & 3 ? 0 : bench_rand_range(0, 255) };
+      mat34_t a, b;
+      chained(&a, rot, (vec3_t){ 0, 0, 0 });
+      mat34_compose(&b, rot, F16_ONE, (vec3_t){ 0, 0, 0 });
+      mismatches += max_diff(&a, &b) != 0;
+      total++;
+    }
+  }
+  printf("check mat34_compose against the mat4_mul chain: %ld of %ld differ: %s\n", mismatches, total,
+         mismatches ? "FAIL" : "PASS");
+  pass &= !mismatches;
+
+  double err = 0;
+  for (int i = 0; i < 10000; i++)
+  {
+    vec3_t rot = { bench_rand_range(0, 255), bench_rand_range(0, 255), bench_rand_range(0, 255) };
+    mat34_t a, b;
+    mat34_compose(&a, rot, F16_ONE, (vec3_t){ 0, 0, 0 });
+    mat34_from_quat(&b, quat_from_euler(rot), F16_ONE, (vec3_t){ 0, 0, 0 });
+    err = fmax(err, max_diff(&a, &b));
+  }
+  // Half angles fall between table entries, v_sin_fx interpolates those
+  pass &= bench_check("quat_from_euler against mat34_compose", err, 1.0 / 512);
+
+  // A minute of spinning at 60 ticks a second, 200 angle units per second.
+  // Rounding in the table's small angles makes the turn rate a little off
+  // but steady; the norm must not wander.
+  quat_t q = quat_identity();
+  fix16_t step = INT_TO_F16(200) / 60;
+  const int ticks = 3600;
+  for (int i = 0; i < ticks; i++)
+    q = quat_rotate(q, (vec3_t){ 0, F16_ONE, 0 }, step);
+  double want = 2 * M_PI * bench_to_double(step) * ticks / 256;
+  double got = 2 * atan2(bench_to_double(q.y), bench_to_double(q.w));
+  double drift = fabs(remainder(got - want, 2 * M_PI)) / want;
+  double norm = fabs(bench_to_double(q.w) * bench_to_double(q.w) + bench_to_double(q.y) * bench_to_double(q.y) - 1);
+  pass &= bench_check("quat_rotate, 3600 steps, relative rate", drift, 1.0 / 1024);
+  pass &= bench_check("quat_rotate, 3600 steps, norm", norm, 1.0 / 4096);
+
+  err = 0;
+  for (int i = 0; i < 10000; i++)
+  {
+    quat_t a = rand_quat(), b = rand_quat();
+    fix16_t t = bench_rand_range(0, F16_ONE);
+    quat_t s = quat_slerp(a, b, t);
+    double ref[4];
+    ref_slerp(a, b, bench_to_double(t), ref);
+    // q and -q are the same rotation
+    double e0 = fabs(bench_to_double(s.w) - ref[0]) + fabs(bench_to_double(s.x) - ref[1]) +
+                fabs(bench_to_double(s.y) - ref[2]) + fabs(bench_to_double(s.z) - ref[3]);
+    double e1 = fabs(bench_to_double(s.w) + ref[0]) + fabs(bench_to_double(s.x) + ref[1]) +
+                fabs(bench_to_double(s.y) + ref[2]) + fabs(bench_to_double(s.z) + ref[3]);
+    err = fmax(err, fmin(e0, e1));
+  }
+  pass &= bench_check("quat_slerp against double", err, 1.0 / 512);
+  return pass;
+}
+
+bool bench_rotation(void)
+{
+  bool pass = check_rotations();
+  printf("rotation checks: %s\n", pass ? "PASS" : "FAIL");
+
+  for (int i = 0; i < ROT_ENTITIES; i++)
+  {
+    rots[i] = (vec3_t){ bench_rand_range(0, 255), bench_rand_range(0, 255), bench_rand_range(0, 255) };
+    positions[i] = (vec3_t){ bench_rand_range(-INT_TO_F16(8), INT_TO_F16(8)), 0, INT_TO_F16(10) };
+    quats[i] = quat_from_euler(rots[i]);
+  }
+
+  const int rounds = 4000;
+  const long items = (long)rounds * ROT_ENTITIES;
+  uint32_t acc = 0;
+
+  int64_t t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+      chained(&models[i], rots[i], positions[i]);
+    acc += models[r & (ROT_ENTITIES - 1)].m[0][0];
+  }
+  bench_report("y, x, z chained: 128 multiplies", items, bench_now_ns() - t0, "entity");
+
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+      mat34_compose(&models[i], rots[i], F16_ONE, positions[i]);
+    acc += models[r & (ROT_ENTITIES - 1)].m[0][0];
+  }
+  bench_report("y, x, z fused: 12 multiplies", items, bench_now_ns() - t0, "entity");
+
+  // What game_draw did for y and x only
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+    {
+      vec3_t rot = { rots[i].x, rots[i].y, 0 };
+      mat4_t rot_y = mat4_rotate_y(rot.y);
+      mat4_t rot_x = mat4_rotate_x(rot.x);
+      mat4_t m;
+      mat4_mul_into(&m, &rot_y, &rot_x);
+      mat34_from_mat4(&models[i], &m);
+      models[i].m[0][3] = positions[i].x;
+      models[i].m[1][3] = positions[i].y;
+      models[i].m[2][3] = positions[i].z;
+    }
+    acc += models[r & (ROT_ENTITIES - 1)].m[0][0];
+  }
+  bench_report("y, x chained: 64 multiplies", items, bench_now_ns() - t0, "entity");
+
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+      mat34_compose(&models[i], (vec3_t){ rots[i].x, rots[i].y, 0 }, F16_ONE, positions[i]);
+    acc += models[r & (ROT_ENTITIES - 1)].m[0][0];
+  }
+  bench_report("y, x fused: 4 multiplies", items, bench_now_ns() - t0, "entity");
+
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+      mat34_from_quat(&models[i], quats[i], F16_ONE, positions[i]);
+    acc += models[r & (ROT_ENTITIES - 1)].m[0][0];
+  }
+  bench_report("quaternion to matrix: 9 multiplies", items, bench_now_ns() - t0, "entity");
+
+  // A tick's turn of each entity, then the frame's interpolation
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+      quats[i] = quat_rotate(quats[i], (vec3_t){ 0, F16_ONE, 0 }, INT_TO_F16(3));
+    acc += quats[r & (ROT_ENTITIES - 1)].w;
+  }
+  bench_report("quat_rotate: 29 multiplies, rsqrt", items, bench_now_ns() - t0, "entity");
+
+  quat_t turn = quat_from_axis_angle((vec3_t){ 0, F16_ONE, 0 }, INT_TO_F16(3));
+  t0 = bench_now_ns();
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int i = 0; i < ROT_ENTITIES; i++)
+      mat34_from_quat(&models[i], quat_slerp(quats[i], quat_mul(quats[i], turn), F16_HALF), F16_ONE, positions[i]);
+    acc += models[r & (ROT_ENTITIES - 1)].m[0][0];
+  }
+  bench_report("slerp a tick and to matrix", items, bench_now_ns() - t0, "entity");
+
+  bench_sink = acc;
+  return pass;
+}
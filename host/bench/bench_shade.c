@@ -0,0 +1,160 @@
+#include "bench.h"
+
+#include <stdio.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_graphics.h"
+#include "v_render.h"
+
+// Face-lit against vertex-lit spheres. Flat shading pays a normal rotation
+// and an RGB565 unpack/repack per visible face (plus a normalize when the
+// mesh has no planes); Gouraud pays a light call per visible vertex and an
+// interpolated ramp lookup per pixel. A UV sphere has about two faces per
+// vertex, so the per-face work is what the vertex path saves. The raster
+// lines isolate the span cost of the two fills on the same triangles.
+
+#define SHADE_SPHERES 12
+#define SHADE_MAX_VERTS 256
+#define SHADE_MAX_FACES 512
+
+static vec3_t positions[SHADE_MAX_VERTS];
+static vec3_t normals[SHADE_MAX_VERTS];
+static uint16_t faces[SHADE_MAX_FACES][3];
+static plane_t planes[SHADE_MAX_FACES];
+static mat34_t models[SHADE_SPHERES];
+
+static fix16_t light_intensity(fix16_t normal_z)
+{
+  fix16_t i = (normal_z < 0 ? -normal_z : normal_z) + F16_ONE / 4;
+  return i > F16_ONE ? F16_ONE : i;
+}
+
+// Same lighting as the game, colour maths per face
+static uint16_t shade_face(uint16_t color, vec3_t normal)
+{
+#if V_INDEXED_COLOR
+  return V_RAMP_SHADE(color, (light_intensity(normal.z) * (V_RAMP_SHADES - 1) + F16_HALF) >> 16);
+#else
+  int intensity = light_intensity(normal.z);
+  int r = (((color >> 11) & 0x1F) * intensity) >> 16;
+  int g = (((color >> 5) & 0x3F) * intensity) >> 16;
+  int b = ((color & 0x1F) * intensity) >> 16;
+  return (uint16_t)((r << 11) | (g << 5) | b);
+#endif
+}
+
+static fix16_t light_vertex(vec3_t normal)
+{
+  return light_intensity(normal.z);
+}
+
+// The bench sphere with vertex normals, and face planes for the flat path
+static mesh_t make_sphere(int stacks, int slices)
+{
+  mesh_t mesh = bench_make_sphere(positions, faces, stacks, slices);
+  int n = mesh.num_vertices, f = mesh.num_faces;
+
+  for (int i = 0; i < n; i++)
+    normals[i] = vec3_normalize(positions[i]);
+
+  for (int i = 0; i < f; i++)
+  {
+    vec3_t p0 = positions[faces[i][0]];
+    vec3_t e1 = vec3_sub(positions[faces[i][1]], p0), e2 = vec3_sub(positions[faces[i][2]], p0);
+    planes[i].n = vec3_normalize(vec3_cross(e1, e2));
+    planes[i].d = -vec3_dot(planes[i].n, p0);
+  }
+
+  return mesh;
+}
+
+// Random turns, on a fixed grid so the spheres never overlap
+static void place_spheres(void)
+{
+  const vec3_t origin = { 0, 0, 0 };
+  bench_place_models(models, SHADE_SPHERES, origin, origin);
+  for (int i = 0; i < SHADE_SPHERES; i++)
+  {
+    models[i].m[0][3] = INT_TO_F16((i % 3) - 1) * 2;
+    models[i].m[1][3] = INT_TO_F16((i / 3) % 4) * 2 - INT_TO_F16(3);
+    models[i].m[2][3] = INT_TO_F16(7 + (i & 1));
+  }
+}
+
+typedef struct {
+  const render_view_t *view;
+  const mesh_t *mesh;
+} scene_t;
+
+static void draw_scene(void *ctx, int frame)
+{
+  const scene_t *scene = ctx;
+  (void)frame;
+  for (int i = 0; i < SHADE_SPHERES; i++)
+    render_mesh(scene->view, scene->mesh, &models[i], i & 1 ? V_CYAN : V_YELLOW);
+}
+
+static void run(const char *label, const render_view_t *view, const mesh_t *mesh, int frames)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "%4d faces, %s", mesh->num_faces, label);
+  scene_t scene = { view, mesh };
+  int64_t ns;
+  render_stats_t st = bench_draw_frames(name, frames, draw_scene, &scene, &ns);
+  printf("  %.1f faces and %.1f vertices per frame, %.1f ns per face\n", (double)st.faces_drawn / frames,
+         (double)st.verts_transformed / frames, (double)ns / st.faces_drawn);
+}
+
+// Just the fills: the same screen-filling pair of triangles, flat and shaded
+static void run_raster(int frames)
+{
+  const fix16_t w = INT_TO_F16(V_DISPLAY_WIDTH), h = INT_TO_F16(V_DISPLAY_HEIGHT);
+
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    gfx_fill_triangle_fx(0, 0, w, 0, 0, h, V_CYAN);
+    gfx_fill_triangle_fx(w, 0, w, h, 0, h, V_CYAN);
+  }
+  bench_report("fill flat", (long)frames * V_BUFFER_SIZE, bench_now_ns() - t0, "px");
+
+  t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    gfx_fill_triangle_shaded(0, 0, F16_ONE, w, 0, F16_ONE / 2, 0, h, F16_ONE / 4, V_CYAN);
+    gfx_fill_triangle_shaded(w, 0, F16_ONE / 2, w, h, 0, 0, h, F16_ONE / 4, V_CYAN);
+  }
+  bench_report("fill shaded", (long)frames * V_BUFFER_SIZE, bench_now_ns() - t0, "px");
+}
+
+bool bench_shade(void)
+{
+  static const int sizes[][2] = { { 6, 8 }, { 10, 12 }, { 14, 18 } };
+  const int frames = 2000;
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t face_lit, vertex_lit;
+  render_view_init(&face_lit, &proj, shade_face);
+  render_view_init(&vertex_lit, &proj, shade_face);
+  vertex_lit.light = light_vertex;
+
+  place_spheres();
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    mesh_t sphere = make_sphere(sizes[s][0], sizes[s][1]);
+    run("face-lit", &face_lit, &sphere, frames);
+    sphere.planes = planes;
+    run("face-lit, planes", &face_lit, &sphere, frames);
+    sphere.normals = normals;
+    run("vertex-lit", &vertex_lit, &sphere, frames);
+  }
+
+  run_raster(frames / 2);
+  return true;
+}
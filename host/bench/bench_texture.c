@@ -0,0 +1,332 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_display.h"
+#include "v_graphics.h"
+#include "v_host.h"
+#include "v_primitives.h"
+#include "v_render.h"
+
+// Textured against flat fill rate, for bare triangles and for cubes through
+// render_mesh, and a golden check of the perspective correction. Every texel of the check textures has its own colour, so the
+// presented frame says which texel each pixel sampled; that is compared with
+// an exact double precision mapping at the pixel centre. Linear steps between
+// the reciprocals drift a little inside each V_TEXTURE_SUBSPAN run, so a
+// pixel may land on the neighbouring texel but never further.
+
+#define TEX_LOG2 6
+#define TEX_SIZE (1 << TEX_LOG2)
+#define PAL_LOG2 4
+#define PAL_SIZE (1 << PAL_LOG2)
+
+#define BACKGROUND 0xFFFF // No texel colour below
+
+static uint16_t texels16[TEX_SIZE * TEX_SIZE];
+static uint8_t texels8[PAL_SIZE * PAL_SIZE];
+static uint16_t colors8[PAL_SIZE * PAL_SIZE];
+
+// Texel (u, v) is colour v * size + u, with the palettized one offset so the
+// two textures never share a colour
+static void make_textures(void)
+{
+  for (int i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+    texels16[i] = (uint16_t)i;
+  for (int i = 0; i < PAL_SIZE * PAL_SIZE; i++)
+  {
+    texels8[i] = (uint8_t)i;
+    colors8[i] = (uint16_t)(0x8000 | i);
+  }
+}
+
+#if !V_INDEXED_COLOR
+// Quad in camera space with texel coordinates at its corners, drawn as two
+// triangles after projection with focal length FOCAL
+#define FOCAL 150.0
+
+typedef struct {
+  const char *name;
+  double p[4][3];
+  double uv[4][2];
+} quad_t;
+
+static const quad_t quads[] = {
+  { "floor", { { -4, 2, 1 }, { 4, 2, 1 }, { 4, 2, 12 }, { -4, 2, 12 } }, { { 0, 0 }, { 1, 0 }, { 1, 4 }, { 0, 4 } } },
+  { "wall", { { -1, -1.5, 1.2 }, { 3, -1.5, 6 }, { 3, 1.5, 6 }, { -1, 1.5, 1.2 } }, { { 0, 0 }, { 3, 0 }, { 3, 1 }, { 0, 1 } } },
+  { "tilted", { { -1.5, -1, 2 }, { 1.5, -1.2, 3 }, { 1.7, 1.4, 5 }, { -1.2, 1, 3.5 } }, { { 0.5, 0.25 }, { 2, 0 }, { 2.25, 2 }, { 0, 1.5 } } },
+  { "facing", { { -1, -1, 3 }, { 1, -1, 3 }, { 1, 1, 3 }, { -1, 1, 3 } }, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } },
+};
+
+static gfx_tex_vertex_t project(const quad_t *q, int k, int size)
+{
+  double z = q->p[k][2];
+  return (gfx_tex_vertex_t){
+    .x = bench_to_f16(q->p[k][0] * FOCAL / z + V_DISPLAY_WIDTH / 2),
+    .y = bench_to_f16(q->p[k][1] * FOCAL / z + V_DISPLAY_HEIGHT / 2),
+    .z = bench_to_f16(z),
+    .u = bench_to_f16(q->uv[k][0] * size),
+    .v = bench_to_f16(q->uv[k][1] * size),
+  };
+}
+
+static void draw_quad(const quad_t *q, const gfx_texture_t *tex)
+{
+  int size = 1 << tex->width_log2;
+  gfx_tex_vertex_t v[4];
+  for (int k = 0; k < 4; k++)
+    v[k] = project(q, k, size);
+  gfx_tex_vertex_t t1[3] = { v[0], v[1], v[2] }, t2[3] = { v[0], v[2], v[3] };
+  gfx_fill_triangle_textured(t1, tex);
+  gfx_fill_triangle_textured(t2, tex);
+}
+
+static double f16_to_double(fix16_t v)
+{
+  return v / 65536.0;
+}
+
+// Exact texel under the centre of pixel (px, py), or false outside tri
+static bool reference_texel(const gfx_tex_vertex_t tri[3], int px, int py, int size, int *u, int *v)
+{
+  double x[3], y[3], w[3];
+  for (int k = 0; k < 3; k++)
+  {
+    x[k] = f16_to_double(tri[k].x);
+    y[k] = f16_to_double(tri[k].y);
+    w[k] = 1.0 / f16_to_double(tri[k].z);
+  }
+  double cx = px + 0.5, cy = py + 0.5;
+  double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  double b1 = ((cx - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (cy - y[0])) / area;
+  double b2 = ((x[1] - x[0]) * (cy - y[0]) - (cx - x[0]) * (y[1] - y[0])) / area;
+  double b0 = 1 - b1 - b2;
+  if (b0 < 0 || b1 < 0 || b2 < 0)
+    return false;
+
+  double iw = b0 * w[0] + b1 * w[1] + b2 * w[2];
+  double uw = b0 * w[0] * f16_to_double(tri[0].u) + b1 * w[1] * f16_to_double(tri[1].u) +
+              b2 * w[2] * f16_to_double(tri[2].u);
+  double vw = b0 * w[0] * f16_to_double(tri[0].v) + b1 * w[1] * f16_to_double(tri[1].v) +
+              b2 * w[2] * f16_to_double(tri[2].v);
+  *u = (int)floor(uw / iw) & (size - 1);
+  *v = (int)floor(vw / iw) & (size - 1);
+  return true;
+}
+
+// Distance between two texel coordinates the short way round the wrap
+static int wrap_dist(int a, int b, int size)
+{
+  int d = a > b ? a - b : b - a;
+  return d < size - d ? d : size - d;
+}
+
+static uint16_t frame[V_BUFFER_SIZE];
+
+// Draws the quad alone, presents it and checks every covered pixel
+static bool golden(const quad_t *q, const gfx_texture_t *tex, const char *label)
+{
+  int size = 1 << tex->width_log2;
+  uint16_t base = tex->colors ? 0x8000 : 0;
+
+  gfx_dirty_invalidate();
+  gfx_clear(BACKGROUND);
+#if V_DEPTH_BUFFER
+  gfx_depth_clear();
+#endif
+  draw_quad(q, tex);
+  display_present();
+  host_display_flush();
+  memcpy(frame, host_display_frame(), sizeof(frame));
+
+  gfx_tex_vertex_t v[4];
+  for (int k = 0; k < 4; k++)
+    v[k] = project(q, k, size);
+  gfx_tex_vertex_t tris[2][3] = { { v[0], v[1], v[2] }, { v[0], v[2], v[3] } };
+
+  long pixels = 0, off = 0;
+  int worst = 0;
+  for (int y = 0; y < V_DISPLAY_HEIGHT; y++)
+  {
+    for (int x = 0; x < V_DISPLAY_WIDTH; x++)
+    {
+      uint16_t c = frame[y * V_DISPLAY_WIDTH + x];
+      int ru, rv;
+      if (c == BACKGROUND)
+        continue;
+      // Edge pixels follow the rasterizer's fill rule, not the exact test
+      if (!reference_texel(tris[0], x, y, size, &ru, &rv) && !reference_texel(tris[1], x, y, size, &ru, &rv))
+        continue;
+      int texel = c - base;
+      int du = wrap_dist(texel & (size - 1), ru, size), dv = wrap_dist(texel >> tex->width_log2, rv, size);
+      int err = du > dv ? du : dv;
+      pixels++;
+      off += err != 0;
+      if (err > worst)
+        worst = err;
+    }
+  }
+
+  bool pass = pixels > 0 && worst <= 1;
+  printf("golden %-7s %-8s %6ld px, %5.2f%% off by a texel, max error %d: %s\n", q->name, label, pixels,
+         pixels ? 100.0 * off / pixels : 0.0, worst, pass ? "PASS" : "FAIL");
+  return pass;
+}
+#endif
+
+static void run_fill(const char *label, const gfx_texture_t *tex, int frames)
+{
+  const fix16_t w = INT_TO_F16(V_DISPLAY_WIDTH), h = INT_TO_F16(V_DISPLAY_HEIGHT);
+  int64_t t0 = bench_now_ns();
+  for (int i = 0; i < frames; i++)
+  {
+    if (!tex)
+    {
+      gfx_fill_triangle_fx(0, 0, w, 0, 0, h, V_CYAN);
+      gfx_fill_triangle_fx(w, 0, w, h, 0, h, V_CYAN);
+      continue;
+    }
+#if V_DEPTH_BUFFER
+    gfx_depth_clear();
+#endif
+    // Screen-filling quad leaning away from the camera, wrapping twice
+    fix16_t s = INT_TO_F16(2 << tex->width_log2);
+    gfx_tex_vertex_t a = { 0, 0, INT_TO_F16(4), 0, 0 }, b = { w, 0, INT_TO_F16(4), s, 0 };
+    gfx_tex_vertex_t c = { w, h, INT_TO_F16(1), s, s }, d = { 0, h, INT_TO_F16(1), 0, s };
+    gfx_tex_vertex_t t1[3] = { a, b, c }, t2[3] = { a, c, d };
+    gfx_fill_triangle_textured(t1, tex);
+    gfx_fill_triangle_textured(t2, tex);
+  }
+  bench_report(label, (long)frames * V_BUFFER_SIZE, bench_now_ns() - t0, "px");
+}
+
+// MESH_CUBE with its vertices split per side, each side mapped to the whole
+// texture. The face list pairs up into quads (a, b, c), (a, c, d).
+#define CUBES 24
+
+static vec3_t cube_verts[24];
+static fix16_t cube_uvs[24][2];
+static uint8_t cube_faces[12][3];
+static mat34_t models[CUBES];
+
+static mesh_t make_cube(void)
+{
+  static const fix16_t corner_uv[4][2] = { { 0, 0 }, { F16_ONE, 0 }, { F16_ONE, F16_ONE }, { 0, F16_ONE } };
+  for (int side = 0; side < 6; side++)
+  {
+    int quad[4], first[3], second[3];
+    mesh_face(&MESH_CUBE, side * 2, first);
+    mesh_face(&MESH_CUBE, side * 2 + 1, second);
+    quad[0] = first[0]; quad[1] = first[1]; quad[2] = first[2]; quad[3] = second[2];
+    for (int k = 0; k < 4; k++)
+    {
+      cube_verts[side * 4 + k] = mesh_vertex(&MESH_CUBE, quad[k]);
+      cube_uvs[side * 4 + k][0] = corner_uv[k][0];
+      cube_uvs[side * 4 + k][1] = corner_uv[k][1];
+    }
+    static const int tris[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int k = 0; k < 6; k++)
+      cube_faces[side * 2 + k / 3][k % 3] = (uint8_t)(side * 4 + tris[k]);
+  }
+
+  mesh_t cube = MESH_CUBE;
+  cube.vertices = cube_verts;
+  cube.num_vertices = 24;
+  cube.faces = cube_faces;
+  cube.edges = NULL;
+  cube.num_edges = 0;
+  cube.face_edges = NULL;
+  cube.uvs = cube_uvs;
+  return cube;
+}
+
+// Spread out in front of the camera, the nearest ones cut by the near plane
+static void place_cubes(void)
+{
+  for (int i = 0; i < CUBES; i++)
+  {
+    mat4_t ry = mat4_rotate_y(bench_rand_range(0, INT_TO_F16(256)));
+    mat4_t rx = mat4_rotate_x(bench_rand_range(0, INT_TO_F16(256)));
+    mat4_t rot;
+    mat4_mul_into(&rot, &ry, &rx);
+
+    mat34_from_mat4(&models[i], &rot);
+    models[i].m[0][3] = bench_rand_range(-INT_TO_F16(4), INT_TO_F16(4));
+    models[i].m[1][3] = bench_rand_range(-INT_TO_F16(3), INT_TO_F16(3));
+    models[i].m[2][3] = bench_rand_range(INT_TO_F16(1), INT_TO_F16(12));
+  }
+}
+
+static void run_cubes(const char *label, const render_view_t *view, const mesh_t *mesh, int frames)
+{
+  uint32_t pixels = 0;
+  int64_t t0 = bench_now_ns();
+  for (int f = 0; f < frames; f++)
+  {
+    gfx_clear(V_BLACK);
+#if V_DEPTH_BUFFER
+    gfx_depth_clear();
+#endif
+    render_begin_frame();
+#if V_PROFILE
+    uint32_t p0 = gfx_pixels_rasterized();
+#endif
+    for (int i = 0; i < CUBES; i++)
+      render_mesh(view, mesh, &models[i], V_CYAN);
+#if V_PROFILE
+    pixels += gfx_pixels_rasterized() - p0;
+#endif
+  }
+  bench_report(label, frames, bench_now_ns() - t0, "frame");
+  render_stats_t st = render_get_stats();
+  printf("  %lu faces drawn", (unsigned long)st.faces_drawn);
+  if (pixels)
+    printf(", %.1f px per frame", (double)pixels / frames);
+  printf("\n");
+}
+
+bool bench_texture(void)
+{
+  const int frames = 1000;
+  make_textures();
+  gfx_texture_t tex16 = { texels16, NULL, TEX_LOG2, TEX_LOG2 };
+  gfx_texture_t tex8 = { texels8, colors8, PAL_LOG2, PAL_LOG2 };
+
+  run_fill("fill flat", NULL, frames);
+  run_fill("fill textured 16-bit", &tex16, frames);
+  run_fill("fill textured palettized", &tex8, frames);
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t view;
+  render_view_init(&view, &proj, NULL);
+
+  place_cubes();
+  mesh_t cube = make_cube();
+  run_cubes("24 cubes, flat", &view, &cube, frames);
+  cube.texture = &tex16;
+  run_cubes("24 cubes, textured 16-bit", &view, &cube, frames);
+  cube.texture = &tex8;
+  run_cubes("24 cubes, textured palettized", &view, &cube, frames);
+
+#if V_INDEXED_COLOR
+  printf("golden checks skipped: the indexed panel output cannot name texels\n");
+  return true;
+#else
+  int failed = 0;
+  for (size_t i = 0; i < sizeof(quads) / sizeof(quads[0]); i++)
+  {
+    failed += !golden(&quads[i], &tex16, "16-bit");
+    failed += !golden(&quads[i], &tex8, "8-bit");
+  }
+  printf("golden checks: %s\n", failed ? "FAIL" : "PASS");
+  return !failed;
+#endif
+}
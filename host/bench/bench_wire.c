@@ -0,0 +1,73 @@
+#include "bench.h"
+
+#include <stdio.h>
+
+#include "v_colors.h"
+#include "v_config.h"
+#include "v_primitives.h"
+#include "v_render.h"
+
+// A field of spinning cubes and pyramids in front of the camera, drawn in
+// each render mode. The per-edge cost is what the wireframe pays per line;
+// the cubes without face edges draw every edge, hidden ones included.
+
+#define WIRE_ENTITIES 60
+
+static mat34_t models[WIRE_ENTITIES];
+
+typedef struct {
+  const render_view_t *view;
+  const mesh_t *cube;
+} scene_t;
+
+static void draw_scene(void *ctx, int frame)
+{
+  const scene_t *scene = ctx;
+  (void)frame;
+  for (int i = 0; i < WIRE_ENTITIES; i++)
+    render_mesh(scene->view, i & 1 ? &MESH_PYRAMID : scene->cube, &models[i], V_CYAN);
+}
+
+static void run(const char *label, render_view_t *view, render_mode_t mode, const mesh_t *cube, int frames)
+{
+  view->mode = mode;
+
+  scene_t scene = { view, cube };
+  int64_t ns;
+  long edges = (long)bench_draw_frames(label, frames, draw_scene, &scene, &ns).edges_drawn;
+
+  // Over faces the frame time is mostly fill, so lines/s only means
+  // something for the bare wireframe
+  if (mode == RENDER_WIRE)
+  {
+    printf("  %.1f edges per frame, %.2f M lines/s\n", (double)edges / frames,
+           (double)edges * 1000.0 / (double)ns);
+  }
+  else if (edges)
+    printf("  %.1f edges per frame\n", (double)edges / frames);
+}
+
+bool bench_wire(void)
+{
+  const int frames = 3000;
+
+  projection_t proj = {
+    .focal = INT_TO_F16(150),
+    .cx = INT_TO_F16(V_DISPLAY_WIDTH / 2),
+    .cy = INT_TO_F16(V_DISPLAY_HEIGHT / 2),
+    .near = FLT_TO_F16(0.5f),
+  };
+  render_view_t view;
+  render_view_init(&view, &proj, NULL);
+
+  mesh_t every_edge = MESH_CUBE;
+  every_edge.face_edges = NULL;
+
+  bench_place_models(models, WIRE_ENTITIES, (vec3_t){ -INT_TO_F16(6), -INT_TO_F16(8), INT_TO_F16(6) },
+                     (vec3_t){ INT_TO_F16(6), INT_TO_F16(8), INT_TO_F16(20) });
+  run("60 meshes, solid", &view, RENDER_SOLID, &MESH_CUBE, frames);
+  run("60 meshes, wire", &view, RENDER_WIRE, &MESH_CUBE, frames);
+  run("60 meshes, wire, every cube edge", &view, RENDER_WIRE, &every_edge, frames);
+  run("60 meshes, both", &view, RENDER_BOTH, &MESH_CUBE, frames);
+  return true;
+}
@@ -0,0 +1,154 @@
+// Headless runner: plays the game for a fixed number of frames on the host
+// backends. Usage: void_host [-n frames] [-o frame_%04d.ppm] [-i input_mask] [-s] [-a dir]
+//                           [-m solid|wire|both] [-p] [-r] [-t frame_us] [-e script]
+// -s simulates the SPI transfer time of V_SPI_SPEED_HZ instead of instant transfers.
+// The engine clock is simulated so every run ticks and draws the same frames:
+// time passes only by frame pacing plus -t microseconds per frame (use -t
+// with V_TARGET_FPS 0, or to play an overloaded device). -r uses the real clock.
+// -e replays a button script (see host_input_load) and reports the latency
+// from each event to the present of the first frame whose update saw it.
+// -a is where storage_map() finds the asset packs (assets.bin), default ".".
+// -p prints the last V_PROFILE_FRAMES frame profiles as CSV, needs V_PROFILE.
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "v_engine.h"
+#include "v_config.h"
+#include "v_display.h"
+#include "v_host.h"
+#include "v_profile.h"
+#include "v_timer.h"
+#include "game.h"
+
+static int64_t wall_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool parse_mode(const char *name, render_mode_t *mode)
+{
+  static const char *const names[] = { [RENDER_WIRE] = "wire", [RENDER_SOLID] = "solid", [RENDER_BOTH] = "both" };
+  for (int m = 0; m < 3; m++)
+  {
+    if (!strcmp(name, names[m]))
+    {
+      *mode = (render_mode_t)m;
+      return true;
+    }
+  }
+  return false;
+}
+
+int main(int argc, char **argv)
+{
+  int frames = 60;
+  const char *ppm = NULL;
+  uint8_t input = 0;
+  render_mode_t mode = RENDER_SOLID;
+  bool profile = false;
+  bool real_clock = false;
+  int64_t frame_us = 0;
+  const char *script = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc)
+      frames = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+      ppm = argv[++i];
+    else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+      input = (uint8_t)strtol(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "-s"))
+      host_display_set_latency(8000000000LL / V_SPI_SPEED_HZ);
+    else if (!strcmp(argv[i], "-a") && i + 1 < argc)
+      host_storage_set_dir(argv[++i]);
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc && parse_mode(argv[i + 1], &mode))
+      i++;
+    else if (!strcmp(argv[i], "-p"))
+      profile = true;
+    else if (!strcmp(argv[i], "-r"))
+      real_clock = true;
+    else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+      frame_us = atoll(argv[++i]);
+    else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+      script = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [-n frames] [-o pattern.ppm] [-i input_mask] [-s] [-a dir] [-m solid|wire|both] [-p]\n"
+              "       [-r] [-t frame_us] [-e script]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (script && !host_input_load(script))
+  {
+    fprintf(stderr, "cannot load input script %s\n", script);
+    return 1;
+  }
+
+  host_display_set_ppm(ppm);
+  host_timer_set_simulated(!real_clock);
+  engine_init(&void_lander);
+  engine_set_mode(mode);
+  host_input_set(input);
+
+  // Events queued but not yet seen by an update
+  static input_event_t pending[V_INPUT_QUEUE_SIZE];
+  int num_pending = 0, latency_count = 0;
+  int64_t latency_sum = 0, latency_max = 0;
+  const engine_stats_t *es = engine_get_stats();
+
+  int64_t start = wall_us();
+  for (int i = 0; i < frames; i++)
+  {
+    if (!real_clock)
+      host_timer_advance(frame_us);
+    num_pending += host_input_replay(timer_get_us(), pending + num_pending, V_INPUT_QUEUE_SIZE - num_pending);
+    if (num_pending > V_INPUT_QUEUE_SIZE)
+      num_pending = V_INPUT_QUEUE_SIZE;
+
+    uint32_t ticks = es->ticks;
+    engine_step();
+    if (es->ticks == ticks)
+      continue;
+
+    for (int e = 0; e < num_pending; e++)
+    {
+      int64_t latency = es->present_us - pending[e].time_us;
+      latency_sum += latency;
+      if (latency > latency_max)
+        latency_max = latency;
+      latency_count++;
+    }
+    num_pending = 0;
+  }
+  display_wait_vsync();
+  int64_t elapsed = wall_us() - start;
+
+  printf("%d frames in %.3f ms (%.1f us/frame), %lu ticks, %lu dropped, %.3f s %s\n", frames,
+         elapsed / 1000.0, frames ? (double)elapsed / frames : 0.0, (unsigned long)es->ticks,
+         (unsigned long)es->ticks_dropped, timer_get_us() / 1e6, real_clock ? "real" : "simulated");
+  if (script)
+    printf("input: %d events, latency to present %.1f us avg, %lld us max, %lu dropped\n", latency_count,
+           latency_count ? (double)latency_sum / latency_count : 0.0, (long long)latency_max,
+           (unsigned long)input_dropped_events());
+  host_display_flush();
+
+  if (profile)
+  {
+#if V_PROFILE
+    profile_dump_csv();
+#else
+    fprintf(stderr, "built with V_PROFILE 0, nothing recorded\n");
+#endif
+  }
+  return 0;
+}
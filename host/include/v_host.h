@@ -0,0 +1,38 @@
+#ifndef V_HOST_H
+#define V_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "v_input.h"
+
+// Host-only controls for the software display, input and timer backends.
+// Nothing in here exists on the ESP32 build.
+
+// Display
+void host_display_set_ppm(const char *pattern); // printf pattern taking the frame number, NULL keeps frames in memory only
+const uint16_t *host_display_frame(void);       // Last presented frame, native RGB565, V_BUFFER_SIZE pixels
+int host_display_frame_count(void);             // Number of frames that reached the panel so far
+bool host_display_write_ppm(const char *path);  // Writes the last presented frame
+void host_display_set_latency(int64_t ns_per_byte); // Simulated SPI cost, 0 makes transfers instant
+void host_display_flush(void);                  // Lands every queued transfer on the panel model
+
+// Input
+void host_input_set(uint8_t state); // Queues the edges to this level bitmask, stamped with the current time
+
+// Scripts have one event per line, "<ms> up|down|left|right|a|b press|release",
+// times in ascending order on the engine clock; # starts a comment
+bool host_input_load(const char *path);
+
+// Queues the scripted events due by now_us with their scripted times, as the
+// interrupts would have, copies up to max_out of them to out and returns how
+// many were queued
+int host_input_replay(int64_t now_us, input_event_t *out, int max_out);
+
+// Timer
+void host_timer_set_simulated(bool on); // Clock starts at 0 and moves only in timer_sleep_us and host_timer_advance
+void host_timer_advance(int64_t us);    // Moves the simulated clock forward, e.g. by a frame's pretend cost
+
+// Storage
+void host_storage_set_dir(const char *dir); // Where storage_map() looks for <name>.bin, default "."
+
+#endif
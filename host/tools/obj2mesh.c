@@ -0,0 +1,1092 @@
+// Converts Wavefront OBJ files into a binary mesh pack (see v_meshfile.h).
+// Usage: void_obj2mesh [-no-planes] [-no-edges] [-normals] [-lod N] -o assets.bin name=model.obj ...
+//
+// Per mesh: positions are quantized to int16 against the bounding box,
+// vertices that land on the same quantized position are merged, triangles
+// are reordered for vertex reuse (Forsyth's linear-speed vertex cache
+// optimisation), vertices are renumbered in first-use order so the renderer
+// walks flash sequentially, and the unique edge list and face planes are
+// extracted for the wireframe path and the backface test. The bounding box
+// and sphere go in the header for frustum culling. -normals adds smooth
+// vertex normals for Gouraud shading. -lod N adds N simplified levels of
+// every mesh as name.1 .. name.N, each with half the faces of the one
+// before, for a mesh_lod_t chain.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "v_config.h"
+#include "v_meshfile.h"
+
+#define CACHE_SIZE 32 // Simulated vertex cache for the face reordering
+
+typedef struct {
+  double (*pos)[3];
+  int num_pos, cap_pos;
+  int (*tris)[3];
+  int num_tris, cap_tris;
+} obj_t;
+
+typedef struct {
+  int16_t (*q)[3];
+  int num_verts;
+  int (*tris)[3];
+  int num_tris;
+  int (*edges)[2];
+  int num_edges;
+  int *face_edges; // [num_tris * 3], MESH_NO_EDGE for hidden sides
+  fix16_t scale[3], offset[3];
+} mesh_data_t;
+
+static void *grow(void *p, int *cap, int need, size_t elem)
+{
+  if (need <= *cap)
+    return p;
+  *cap = *cap ? *cap * 2 : 64;
+  if (*cap < need)
+    *cap = need;
+  p = realloc(p, (size_t)*cap * elem);
+  if (!p)
+  {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+// "7", "7/1", "7//3" and negative (relative) indices, returns 0-based or -1
+static int parse_index(const char *tok, int num_pos)
+{
+  int i = atoi(tok);
+  if (i < 0)
+    i = num_pos + i;
+  else
+    i = i - 1;
+  return (i >= 0 && i < num_pos) ? i : -1;
+}
+
+static int load_obj(const char *path, obj_t *obj)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+  {
+    perror(path);
+    return 0;
+  }
+
+  char line[1024];
+  int line_no = 0;
+  while (fgets(line, sizeof(line), f))
+  {
+    line_no++;
+    if (line[0] == 'v' && line[1] == ' ')
+    {
+      obj->pos = grow(obj->pos, &obj->cap_pos, obj->num_pos + 1, sizeof(*obj->pos));
+      double *p = obj->pos[obj->num_pos];
+      if (sscanf(line + 2, "%lf %lf %lf", &p[0], &p[1], &p[2]) != 3)
+      {
+        fprintf(stderr, "%s:%d: bad vertex\n", path, line_no);
+        fclose(f);
+        return 0;
+      }
+      obj->num_pos++;
+    }
+    else if (line[0] == 'f' && line[1] == ' ')
+    {
+      // Polygons become triangle fans
+      int first = -1, prev = -1;
+      for (char *tok = strtok(line + 2, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n"))
+      {
+        int i = parse_index(tok, obj->num_pos);
+        if (i < 0)
+        {
+          fprintf(stderr, "%s:%d: bad face index '%s'\n", path, line_no, tok);
+          fclose(f);
+          return 0;
+        }
+        if (first < 0)
+          first = i;
+        else if (prev >= 0)
+        {
+          obj->tris = grow(obj->tris, &obj->cap_tris, obj->num_tris + 1, sizeof(*obj->tris));
+          obj->tris[obj->num_tris][0] = first;
+          obj->tris[obj->num_tris][1] = prev;
+          obj->tris[obj->num_tris][2] = i;
+          obj->num_tris++;
+        }
+        if (first != i)
+          prev = i;
+      }
+    }
+  }
+  fclose(f);
+  return 1;
+}
+
+// Bounding box centre as offset, half extent spread over +-32767 as scale
+static void quantize(const obj_t *obj, mesh_data_t *mesh, int *remap)
+{
+  double lo[3], hi[3];
+  for (int a = 0; a < 3; a++)
+  {
+    lo[a] = obj->num_pos ? obj->pos[0][a] : 0.0;
+    hi[a] = lo[a];
+  }
+  for (int i = 0; i < obj->num_pos; i++)
+  {
+    for (int a = 0; a < 3; a++)
+    {
+      if (obj->pos[i][a] < lo[a]) lo[a] = obj->pos[i][a];
+      if (obj->pos[i][a] > hi[a]) hi[a] = obj->pos[i][a];
+    }
+  }
+
+  for (int a = 0; a < 3; a++)
+  {
+    mesh->offset[a] = (fix16_t)lround((lo[a] + hi[a]) * 0.5 * 65536.0);
+    double half = (hi[a] - lo[a]) * 0.5 * 65536.0 + 1.0;
+    mesh->scale[a] = (fix16_t)ceil(half / 32767.0);
+  }
+
+  // Merge vertices that quantize to the same point, open addressing on q
+  int cap = 1;
+  while (cap < obj->num_pos * 2)
+    cap <<= 1;
+  int *table = malloc((size_t)cap * sizeof(int));
+  for (int i = 0; i < cap; i++)
+    table[i] = -1;
+
+  mesh->q = malloc((size_t)(obj->num_pos ? obj->num_pos : 1) * sizeof(*mesh->q));
+  mesh->num_verts = 0;
+  for (int i = 0; i < obj->num_pos; i++)
+  {
+    int16_t q[3];
+    for (int a = 0; a < 3; a++)
+    {
+      long v = lround((obj->pos[i][a] * 65536.0 - mesh->offset[a]) / mesh->scale[a]);
+      q[a] = (int16_t)(v < -32767 ? -32767 : (v > 32767 ? 32767 : v));
+    }
+
+    uint32_t h = ((uint32_t)(uint16_t)q[0] * 73856093u) ^ ((uint32_t)(uint16_t)q[1] * 19349663u) ^
+                 ((uint32_t)(uint16_t)q[2] * 83492791u);
+    int slot = (int)(h & (uint32_t)(cap - 1));
+    while (table[slot] >= 0 && memcmp(mesh->q[table[slot]], q, sizeof(q)) != 0)
+      slot = (slot + 1) & (cap - 1);
+
+    if (table[slot] < 0)
+    {
+      table[slot] = mesh->num_verts;
+      memcpy(mesh->q[mesh->num_verts++], q, sizeof(q));
+    }
+    remap[i] = table[slot];
+  }
+  free(table);
+}
+
+// Forsyth vertex score: recently used vertices and vertices with few
+// remaining triangles are preferred
+static double vertex_score(int cache_pos, int remaining)
+{
+  if (remaining == 0)
+    return -1.0;
+  double score = 0.0;
+  if (cache_pos >= 0)
+  {
+    if (cache_pos < 3)
+      score = 0.75;
+    else
+      score = pow(1.0 - (double)(cache_pos - 3) / (CACHE_SIZE - 3), 1.5);
+  }
+  return score + 2.0 / sqrt((double)remaining);
+}
+
+static void reorder_triangles(mesh_data_t *mesh)
+{
+  int nv = mesh->num_verts, nt = mesh->num_tris;
+  int *remaining = calloc((size_t)nv, sizeof(int));
+  int *start = calloc((size_t)nv + 1, sizeof(int));
+  int *adj = malloc((size_t)nt * 3 * sizeof(int));
+  int *cache_pos = malloc((size_t)nv * sizeof(int));
+  double *vscore = malloc((size_t)nv * sizeof(double));
+  double *tscore = malloc((size_t)nt * sizeof(double));
+  char *emitted = calloc((size_t)nt, 1);
+  int (*out)[3] = malloc((size_t)nt * sizeof(*out));
+
+  for (int t = 0; t < nt; t++)
+    for (int k = 0; k < 3; k++)
+      remaining[mesh->tris[t][k]]++;
+  for (int v = 0; v < nv; v++)
+    start[v + 1] = start[v] + remaining[v];
+  int *fill = calloc((size_t)nv, sizeof(int));
+  for (int t = 0; t < nt; t++)
+    for (int k = 0; k < 3; k++)
+    {
+      int v = mesh->tris[t][k];
+      adj[start[v] + fill[v]++] = t;
+    }
+  free(fill);
+
+  for (int v = 0; v < nv; v++)
+  {
+    cache_pos[v] = -1;
+    vscore[v] = vertex_score(-1, remaining[v]);
+  }
+  for (int t = 0; t < nt; t++)
+    tscore[t] = vscore[mesh->tris[t][0]] + vscore[mesh->tris[t][1]] + vscore[mesh->tris[t][2]];
+
+  int cache[CACHE_SIZE + 3];
+  int cache_len = 0;
+  int best = -1;
+  int scan = 0;
+
+  for (int n = 0; n < nt; n++)
+  {
+    if (best < 0)
+    {
+      // Nothing useful in the cache, take the best of what is left
+      double best_score = -1e30;
+      for (int t = scan; t < nt; t++)
+      {
+        if (!emitted[t] && tscore[t] > best_score)
+        {
+          best_score = tscore[t];
+          best = t;
+        }
+      }
+      while (scan < nt && emitted[scan])
+        scan++;
+    }
+
+    emitted[best] = 1;
+    memcpy(out[n], mesh->tris[best], sizeof(out[n]));
+
+    // Move the triangle's vertices to the front of the LRU cache
+    int next[CACHE_SIZE + 3];
+    int next_len = 0;
+    for (int k = 0; k < 3; k++)
+    {
+      int v = mesh->tris[best][k];
+      next[next_len++] = v;
+      remaining[v]--;
+      for (int a = start[v]; a < start[v + 1]; a++)
+      {
+        if (adj[a] == best)
+        {
+          adj[a] = adj[start[v] + remaining[v]];
+          adj[start[v] + remaining[v]] = best;
+          break;
+        }
+      }
+    }
+    for (int i = 0; i < cache_len; i++)
+    {
+      int v = cache[i];
+      if (v != next[0] && v != next[1] && v != next[2])
+        next[next_len++] = v;
+    }
+    for (int i = CACHE_SIZE; i < next_len; i++)
+      cache_pos[next[i]] = -1;
+    cache_len = next_len < CACHE_SIZE ? next_len : CACHE_SIZE;
+    memcpy(cache, next, (size_t)cache_len * sizeof(int));
+
+    // Rescore everything the cache touches and pick the next triangle there
+    for (int i = 0; i < cache_len; i++)
+    {
+      cache_pos[cache[i]] = i;
+      vscore[cache[i]] = vertex_score(i, remaining[cache[i]]);
+    }
+    for (int i = CACHE_SIZE; i < next_len; i++)
+      vscore[next[i]] = vertex_score(-1, remaining[next[i]]);
+
+    best = -1;
+    double best_score = -1e30;
+    for (int i = 0; i < next_len; i++)
+    {
+      int v = next[i];
+      for (int a = start[v]; a < start[v] + remaining[v]; a++)
+      {
+        int t = adj[a];
+        int *tv = mesh->tris[t];
+        tscore[t] = vscore[tv[0]] + vscore[tv[1]] + vscore[tv[2]];
+        if (tscore[t] > best_score)
+        {
+          best_score = tscore[t];
+          best = t;
+        }
+      }
+    }
+  }
+
+  memcpy(mesh->tris, out, (size_t)nt * sizeof(*out));
+  free(out); free(emitted); free(tscore); free(vscore);
+  free(cache_pos); free(adj); free(start); free(remaining);
+}
+
+// Average cache miss ratio of a FIFO post-transform cache, for the report
+static double acmr(const mesh_data_t *mesh, int size)
+{
+  int fifo[64];
+  int len = 0, head = 0, misses = 0;
+  for (int t = 0; t < mesh->num_tris; t++)
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      int v = mesh->tris[t][k], hit = 0;
+      for (int i = 0; i < len; i++)
+        hit |= fifo[i] == v;
+      if (hit)
+        continue;
+      misses++;
+      if (len < size)
+        fifo[len++] = v;
+      else
+      {
+        fifo[head] = v;
+        head = (head + 1) % size;
+      }
+    }
+  }
+  return mesh->num_tris ? (double)misses / mesh->num_tris : 0.0;
+}
+
+// Renumbers vertices in the order the reordered triangles first touch them
+static void reorder_vertices(mesh_data_t *mesh)
+{
+  int *map = malloc((size_t)mesh->num_verts * sizeof(int));
+  for (int v = 0; v < mesh->num_verts; v++)
+    map[v] = -1;
+
+  int16_t (*q)[3] = malloc((size_t)(mesh->num_verts ? mesh->num_verts : 1) * sizeof(*q));
+  int next = 0;
+  for (int t = 0; t < mesh->num_tris; t++)
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      int v = mesh->tris[t][k];
+      if (map[v] < 0)
+      {
+        map[v] = next;
+        memcpy(q[next++], mesh->q[v], sizeof(q[0]));
+      }
+      mesh->tris[t][k] = map[v];
+    }
+  }
+
+  free(mesh->q);
+  free(map);
+  mesh->q = q;
+  mesh->num_verts = next; // drops vertices no triangle uses
+}
+
+static void dequantize(const mesh_data_t *mesh, int v, double p[3])
+{
+  for (int a = 0; a < 3; a++)
+    p[a] = (mesh->offset[a] + (double)mesh->q[v][a] * mesh->scale[a]) / 65536.0;
+}
+
+// Plane of each triangle from the positions the engine will see
+static plane_t face_plane(const mesh_data_t *mesh, int t)
+{
+  double a[3], b[3], c[3], u[3], v[3], n[3];
+  dequantize(mesh, mesh->tris[t][0], a);
+  dequantize(mesh, mesh->tris[t][1], b);
+  dequantize(mesh, mesh->tris[t][2], c);
+  for (int k = 0; k < 3; k++)
+  {
+    u[k] = b[k] - a[k];
+    v[k] = c[k] - a[k];
+  }
+  n[0] = u[1] * v[2] - u[2] * v[1];
+  n[1] = u[2] * v[0] - u[0] * v[2];
+  n[2] = u[0] * v[1] - u[1] * v[0];
+  double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  for (int k = 0; k < 3; k++)
+    n[k] /= len;
+
+  plane_t p;
+  p.n.x = (fix16_t)lround(n[0] * 65536.0);
+  p.n.y = (fix16_t)lround(n[1] * 65536.0);
+  p.n.z = (fix16_t)lround(n[2] * 65536.0);
+  p.d = (fix16_t)lround(-(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]) * 65536.0);
+  return p;
+}
+
+// Area weighted average of the face normals around each vertex. Vertices on
+// the same position are merged, so the whole mesh comes out smooth.
+static void vertex_normals(const mesh_data_t *mesh, vec3_t *out)
+{
+  double (*sum)[3] = calloc((size_t)(mesh->num_verts ? mesh->num_verts : 1), sizeof(*sum));
+  for (int t = 0; t < mesh->num_tris; t++)
+  {
+    double a[3], b[3], c[3], u[3], v[3];
+    dequantize(mesh, mesh->tris[t][0], a);
+    dequantize(mesh, mesh->tris[t][1], b);
+    dequantize(mesh, mesh->tris[t][2], c);
+    for (int k = 0; k < 3; k++)
+    {
+      u[k] = b[k] - a[k];
+      v[k] = c[k] - a[k];
+    }
+    double n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    for (int i = 0; i < 3; i++)
+      for (int k = 0; k < 3; k++)
+        sum[mesh->tris[t][i]][k] += n[k];
+  }
+  for (int i = 0; i < mesh->num_verts; i++)
+  {
+    double len = sqrt(sum[i][0] * sum[i][0] + sum[i][1] * sum[i][1] + sum[i][2] * sum[i][2]);
+    if (len == 0)
+    {
+      out[i] = (vec3_t){ 0, 0, F16_ONE };
+      continue;
+    }
+    out[i].x = (fix16_t)lround(sum[i][0] / len * 65536.0);
+    out[i].y = (fix16_t)lround(sum[i][1] / len * 65536.0);
+    out[i].z = (fix16_t)lround(sum[i][2] / len * 65536.0);
+  }
+  free(sum);
+}
+
+// Box of the positions exactly as mesh_vertex() rebuilds them, and a sphere
+// around its centre rounded outwards
+static void mesh_bounds(const mesh_data_t *mesh, mesh_file_header_t *h)
+{
+  for (int a = 0; a < 3; a++)
+  {
+    h->box_min[a] = mesh->num_verts ? INT32_MAX : 0;
+    h->box_max[a] = mesh->num_verts ? INT32_MIN : 0;
+  }
+  for (int v = 0; v < mesh->num_verts; v++)
+  {
+    for (int a = 0; a < 3; a++)
+    {
+      fix16_t p = mesh->offset[a] + mesh->q[v][a] * mesh->scale[a];
+      if (p < h->box_min[a]) h->box_min[a] = p;
+      if (p > h->box_max[a]) h->box_max[a] = p;
+    }
+  }
+
+  double r2 = 0;
+  for (int a = 0; a < 3; a++)
+    h->center[a] = (fix16_t)(((int64_t)h->box_min[a] + h->box_max[a]) / 2);
+  for (int v = 0; v < mesh->num_verts; v++)
+  {
+    double d2 = 0;
+    for (int a = 0; a < 3; a++)
+    {
+      double d = (double)mesh->offset[a] + (double)mesh->q[v][a] * mesh->scale[a] - h->center[a];
+      d2 += d * d;
+    }
+    if (d2 > r2) r2 = d2;
+  }
+  h->radius = mesh->num_verts ? (fix16_t)ceil(sqrt(r2)) + 1 : 0;
+}
+
+static int edge_cmp(const void *a, const void *b)
+{
+  const int *x = a, *y = b;
+  return x[0] != y[0] ? x[0] - y[0] : x[1] - y[1];
+}
+
+// Within about a degree and 1/1000 of a unit
+static int coplanar(const mesh_data_t *mesh, int t0, int t1)
+{
+  plane_t a = face_plane(mesh, t0), b = face_plane(mesh, t1);
+  double dot = ((double)a.n.x * b.n.x + (double)a.n.y * b.n.y + (double)a.n.z * b.n.z) / (65536.0 * 65536.0);
+  return dot > 0.9998 && labs((long)a.d - b.d) < 64;
+}
+
+// Each undirected edge once, in first-use order like the vertices, and the
+// edge index of every triangle side. Edges between two coplanar triangles,
+// like quad diagonals, are left out of the wireframe.
+static void extract_edges(mesh_data_t *mesh)
+{
+  int n = mesh->num_tris * 3;
+  int (*all)[3] = malloc((size_t)(n ? n : 1) * sizeof(*all)); // lo, hi, use = t * 3 + k
+  for (int t = 0; t < mesh->num_tris; t++)
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      int a = mesh->tris[t][k], b = mesh->tris[t][(k + 1) % 3];
+      all[t * 3 + k][0] = a < b ? a : b;
+      all[t * 3 + k][1] = a < b ? b : a;
+      all[t * 3 + k][2] = t * 3 + k;
+    }
+  }
+  qsort(all, (size_t)n, sizeof(*all), edge_cmp);
+
+  mesh->face_edges = malloc((size_t)(n ? n : 1) * sizeof(int));
+  int (*keep)[2] = malloc((size_t)(n ? n : 1) * sizeof(*keep)); // first use, start in all
+  int kept = 0;
+  for (int i = 0, j; i < n; i = j)
+  {
+    int first = all[i][2];
+    for (j = i; j < n && all[j][0] == all[i][0] && all[j][1] == all[i][1]; j++)
+      if (all[j][2] < first) first = all[j][2];
+
+    if (j - i == 2 && coplanar(mesh, all[i][2] / 3, all[i + 1][2] / 3))
+    {
+      mesh->face_edges[all[i][2]] = MESH_NO_EDGE;
+      mesh->face_edges[all[i + 1][2]] = MESH_NO_EDGE;
+      continue;
+    }
+    keep[kept][0] = first;
+    keep[kept][1] = i;
+    kept++;
+  }
+  qsort(keep, (size_t)kept, sizeof(*keep), edge_cmp);
+
+  mesh->edges = malloc((size_t)(kept ? kept : 1) * sizeof(*mesh->edges));
+  for (int e = 0; e < kept; e++)
+  {
+    int g = keep[e][1];
+    mesh->edges[e][0] = all[g][0];
+    mesh->edges[e][1] = all[g][1];
+    for (int m = g; m < n && all[m][0] == all[g][0] && all[m][1] == all[g][1]; m++)
+      mesh->face_edges[all[m][2]] = e;
+  }
+  mesh->num_edges = kept;
+  free(keep);
+  free(all);
+}
+
+// Edge-collapse decimation with Garland-Heckbert quadrics. Every vertex
+// carries the summed squared distances to the planes of the source faces
+// around it, area weighted; collapsing u onto v costs both quadrics
+// evaluated at v. Vertices only ever merge onto existing ones, so a level
+// keeps the source's quantization and its bounds never grow. Collapses that
+// flip a face, pinch the surface or pull a vertex off an open boundary are
+// skipped.
+
+typedef struct {
+  double q[10]; // Upper triangle of the symmetric 4x4 matrix
+} quadric_t;
+
+typedef struct {
+  int *faces; // May hold faces that died or moved away, see face_has
+  int num, cap;
+} vert_faces_t;
+
+typedef struct {
+  int (*tris)[3];
+  char *dead;
+  double (*pos)[3];
+  quadric_t *quad;
+  vert_faces_t *vf;
+  int *scratch;
+  int scratch_cap;
+} decimate_t;
+
+typedef struct {
+  double cost;
+  int u, v;
+} collapse_t;
+
+static void quadric_add_plane(quadric_t *q, const double n[3], double d, double w)
+{
+  double p[4] = { n[0], n[1], n[2], d };
+  int k = 0;
+  for (int i = 0; i < 4; i++)
+    for (int j = i; j < 4; j++)
+      q->q[k++] += w * p[i] * p[j];
+}
+
+static double quadric_error(const quadric_t *a, const quadric_t *b, const double p[3])
+{
+  double x[4] = { p[0], p[1], p[2], 1.0 }, e = 0.0;
+  int k = 0;
+  for (int i = 0; i < 4; i++)
+    for (int j = i; j < 4; j++, k++)
+      e += (a->q[k] + b->q[k]) * x[i] * x[j] * (i == j ? 1.0 : 2.0);
+  return e;
+}
+
+static void cross3(const double a[3], const double b[3], const double c[3], double n[3])
+{
+  double u[3], v[3];
+  for (int k = 0; k < 3; k++)
+  {
+    u[k] = b[k] - a[k];
+    v[k] = c[k] - a[k];
+  }
+  n[0] = u[1] * v[2] - u[2] * v[1];
+  n[1] = u[2] * v[0] - u[0] * v[2];
+  n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+static int face_has(const decimate_t *d, int t, int v)
+{
+  return !d->dead[t] && (d->tris[t][0] == v || d->tris[t][1] == v || d->tris[t][2] == v);
+}
+
+// Live faces on edge u-v
+static int edge_faces(const decimate_t *d, int u, int v)
+{
+  int n = 0;
+  for (int i = 0; i < d->vf[u].num; i++)
+    n += face_has(d, d->vf[u].faces[i], u) && face_has(d, d->vf[u].faces[i], v);
+  return n;
+}
+
+// Distinct live neighbours of u into d->scratch, returns how many
+static int neighbours(decimate_t *d, int u)
+{
+  int n = 0;
+  for (int i = 0; i < d->vf[u].num; i++)
+  {
+    int t = d->vf[u].faces[i];
+    if (!face_has(d, t, u))
+      continue;
+    for (int k = 0; k < 3; k++)
+    {
+      int w = d->tris[t][k], seen = w == u;
+      for (int j = 0; j < n && !seen; j++)
+        seen = d->scratch[j] == w;
+      if (seen)
+        continue;
+      d->scratch = grow(d->scratch, &d->scratch_cap, n + 1, sizeof(int));
+      d->scratch[n++] = w;
+    }
+  }
+  return n;
+}
+
+static int can_collapse(decimate_t *d, int u, int v)
+{
+  int shared = edge_faces(d, u, v);
+  if (shared < 1 || shared > 2)
+    return 0;
+
+  // Link condition: the ends may only have the edge's opposite corners in
+  // common, anything more would fold the surface onto itself
+  int n = neighbours(d, u), common = 0, open = 0;
+  for (int i = 0; i < n; i++)
+  {
+    int w = d->scratch[i];
+    if (w == v)
+      continue;
+    for (int j = 0; j < d->vf[v].num; j++)
+    {
+      if (face_has(d, d->vf[v].faces[j], v) && face_has(d, d->vf[v].faces[j], w))
+      {
+        common++;
+        break;
+      }
+    }
+    open |= edge_faces(d, u, w) == 1;
+  }
+  if (common != shared)
+    return 0;
+  // A vertex on an open boundary may only slide along it
+  if (shared == 2 && open)
+    return 0;
+
+  for (int i = 0; i < d->vf[u].num; i++)
+  {
+    int t = d->vf[u].faces[i];
+    if (!face_has(d, t, u) || face_has(d, t, v))
+      continue;
+    double moved[3][3], before[3], after[3];
+    for (int k = 0; k < 3; k++)
+      memcpy(moved[k], d->pos[d->tris[t][k] == u ? v : d->tris[t][k]], sizeof(moved[k]));
+    cross3(d->pos[d->tris[t][0]], d->pos[d->tris[t][1]], d->pos[d->tris[t][2]], before);
+    cross3(moved[0], moved[1], moved[2], after);
+    if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0)
+      return 0;
+  }
+  return 1;
+}
+
+// Moves u onto v, returns the faces that died with the edge
+static int collapse(decimate_t *d, int u, int v)
+{
+  int killed = 0;
+  for (int i = 0; i < d->vf[u].num; i++)
+  {
+    int t = d->vf[u].faces[i];
+    if (!face_has(d, t, u))
+      continue;
+    if (face_has(d, t, v))
+    {
+      d->dead[t] = 1;
+      killed++;
+      continue;
+    }
+    for (int k = 0; k < 3; k++)
+      if (d->tris[t][k] == u)
+        d->tris[t][k] = v;
+    vert_faces_t *l = &d->vf[v];
+    l->faces = grow(l->faces, &l->cap, l->num + 1, sizeof(int));
+    l->faces[l->num++] = t;
+  }
+  d->vf[u].num = 0;
+  for (int k = 0; k < 10; k++)
+    d->quad[v].q[k] += d->quad[u].q[k];
+  return killed;
+}
+
+static int collapse_cmp(const void *a, const void *b)
+{
+  double x = ((const collapse_t *)a)->cost, y = ((const collapse_t *)b)->cost;
+  return x < y ? -1 : x > y;
+}
+
+// Copy of src cut down to about target triangles, fewer collapses when the
+// checks run out of safe ones. Passes rank every directed edge by cost and
+// take the cheapest, each vertex at most once per pass.
+static void decimate(const mesh_data_t *src, int target, mesh_data_t *out)
+{
+  int nv = src->num_verts, nt = src->num_tris;
+  decimate_t d = {0};
+  d.tris = malloc((size_t)nt * sizeof(*d.tris));
+  memcpy(d.tris, src->tris, (size_t)nt * sizeof(*d.tris));
+  d.dead = calloc((size_t)nt, 1);
+  d.pos = malloc((size_t)nv * sizeof(*d.pos));
+  d.quad = calloc((size_t)nv, sizeof(*d.quad));
+  d.vf = calloc((size_t)nv, sizeof(*d.vf));
+  for (int v = 0; v < nv; v++)
+    dequantize(src, v, d.pos[v]);
+
+  for (int t = 0; t < nt; t++)
+  {
+    double n[3];
+    const double *a = d.pos[d.tris[t][0]];
+    cross3(a, d.pos[d.tris[t][1]], d.pos[d.tris[t][2]], n);
+    double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (len == 0.0)
+      continue;
+    for (int k = 0; k < 3; k++)
+      n[k] /= len;
+    double dist = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+    for (int k = 0; k < 3; k++)
+    {
+      int v = d.tris[t][k];
+      quadric_add_plane(&d.quad[v], n, dist, len * 0.5);
+      d.vf[v].faces = grow(d.vf[v].faces, &d.vf[v].cap, d.vf[v].num + 1, sizeof(int));
+      d.vf[v].faces[d.vf[v].num++] = t;
+    }
+  }
+
+  collapse_t *cand = malloc((size_t)(nt ? nt : 1) * 6 * sizeof(*cand));
+  char *touched = malloc((size_t)(nv ? nv : 1));
+  int alive = nt;
+  while (alive > target)
+  {
+    int n = 0;
+    for (int t = 0; t < nt; t++)
+    {
+      for (int k = 0; !d.dead[t] && k < 3; k++)
+      {
+        int a = d.tris[t][k], b = d.tris[t][(k + 1) % 3];
+        cand[n++] = (collapse_t){ quadric_error(&d.quad[a], &d.quad[b], d.pos[b]), a, b };
+        cand[n++] = (collapse_t){ quadric_error(&d.quad[a], &d.quad[b], d.pos[a]), b, a };
+      }
+    }
+    qsort(cand, (size_t)n, sizeof(*cand), collapse_cmp);
+
+    memset(touched, 0, (size_t)nv);
+    int done = 0;
+    for (int i = 0; i < n && alive > target; i++)
+    {
+      int u = cand[i].u, v = cand[i].v;
+      if (touched[u] || touched[v] || !can_collapse(&d, u, v))
+        continue;
+      alive -= collapse(&d, u, v);
+      touched[u] = touched[v] = 1;
+      done++;
+    }
+    if (!done)
+      break;
+  }
+
+  *out = (mesh_data_t){0};
+  out->q = malloc((size_t)(nv ? nv : 1) * sizeof(*out->q));
+  memcpy(out->q, src->q, (size_t)nv * sizeof(*out->q));
+  out->num_verts = nv;
+  memcpy(out->scale, src->scale, sizeof(out->scale));
+  memcpy(out->offset, src->offset, sizeof(out->offset));
+  out->tris = malloc((size_t)(alive ? alive : 1) * sizeof(*out->tris));
+  for (int t = 0; t < nt; t++)
+    if (!d.dead[t])
+      memcpy(out->tris[out->num_tris++], d.tris[t], sizeof(out->tris[0]));
+
+  for (int v = 0; v < nv; v++)
+    free(d.vf[v].faces);
+  free(d.vf); free(d.quad); free(d.pos); free(d.dead); free(d.tris);
+  free(d.scratch); free(cand); free(touched);
+}
+
+// Cache-friendly face order, vertices renumbered to match and the edge
+// list. Returns the ACMR before.
+static double optimize(mesh_data_t *mesh)
+{
+  // Exporters often emit strip order already, keep it when it scores better
+  double before = acmr(mesh, 16);
+  size_t tri_bytes = (size_t)mesh->num_tris * sizeof(*mesh->tris);
+  int (*original)[3] = malloc(tri_bytes ? tri_bytes : 1);
+  memcpy(original, mesh->tris, tri_bytes);
+  reorder_triangles(mesh);
+  if (acmr(mesh, 16) > before)
+    memcpy(mesh->tris, original, tri_bytes);
+  free(original);
+  reorder_vertices(mesh);
+  extract_edges(mesh);
+  return before;
+}
+
+static int build_mesh(const char *path, mesh_data_t *mesh)
+{
+  obj_t obj = {0};
+  if (!load_obj(path, &obj))
+    return 0;
+
+  int *remap = malloc((size_t)(obj.num_pos ? obj.num_pos : 1) * sizeof(int));
+  quantize(&obj, mesh, remap);
+
+  // Triangles collapsed by the merge have no area left, drop them
+  mesh->tris = malloc((size_t)(obj.num_tris ? obj.num_tris : 1) * sizeof(*mesh->tris));
+  mesh->num_tris = 0;
+  for (int t = 0; t < obj.num_tris; t++)
+  {
+    int a = remap[obj.tris[t][0]], b = remap[obj.tris[t][1]], c = remap[obj.tris[t][2]];
+    if (a == b || b == c || a == c)
+      continue;
+    mesh->tris[mesh->num_tris][0] = a;
+    mesh->tris[mesh->num_tris][1] = b;
+    mesh->tris[mesh->num_tris][2] = c;
+    mesh->num_tris++;
+  }
+
+  int merged = obj.num_pos - mesh->num_verts;
+  double before = optimize(mesh);
+
+  printf("%s: %d verts (%d merged), %d tris (%d dropped), %d edges, ACMR %.3f -> %.3f\n",
+         path, mesh->num_verts, merged, mesh->num_tris, obj.num_tris - mesh->num_tris,
+         mesh->num_edges, before, acmr(mesh, 16));
+
+  free(remap);
+  free(obj.pos);
+  free(obj.tris);
+
+  if (mesh->num_verts > 65535 || mesh->num_tris > 65535 || mesh->num_edges >= MESH_NO_EDGE)
+  {
+    fprintf(stderr, "%s: too large for 16-bit indices\n", path);
+    return 0;
+  }
+  if (mesh->num_verts > V_MAX_MESH_VERTS || mesh->num_tris > V_MAX_MESH_FACES)
+    fprintf(stderr, "%s: warning: over V_MAX_MESH_VERTS/FACES, render_mesh will skip it\n", path);
+  else if (mesh->num_edges > V_MAX_MESH_EDGES)
+    fprintf(stderr, "%s: warning: over V_MAX_MESH_EDGES, render_mesh will draw it without edges\n", path);
+  return 1;
+}
+
+static size_t align4(size_t n)
+{
+  return (n + 3) & ~(size_t)3;
+}
+
+// Serialises one mesh blob, returns its size. buf == NULL only measures.
+static size_t write_mesh(const mesh_data_t *mesh, int planes, int edges, int normals, uint8_t *buf)
+{
+  int wide = mesh->num_verts > 256;
+  size_t index_size = wide ? 2 : 1;
+
+  mesh_file_header_t h = {0};
+  h.magic = MESH_FILE_MAGIC;
+  h.version = MESH_FILE_VERSION;
+  h.flags = (uint16_t)((wide ? MESH_FILE_WIDE_INDICES : 0) | (planes ? MESH_FILE_PLANES : 0) |
+                       (edges ? MESH_FILE_EDGES : 0) | (normals ? MESH_FILE_NORMALS : 0));
+  h.num_vertices = (uint16_t)mesh->num_verts;
+  h.num_faces = (uint16_t)mesh->num_tris;
+  h.num_edges = (uint16_t)(edges ? mesh->num_edges : 0);
+  memcpy(h.scale, mesh->scale, sizeof(h.scale));
+  memcpy(h.offset, mesh->offset, sizeof(h.offset));
+  mesh_bounds(mesh, &h);
+
+  size_t at = align4(sizeof(h));
+  h.vertices = (uint32_t)at;
+  at = align4(at + (size_t)mesh->num_verts * 3 * sizeof(int16_t));
+  h.faces = (uint32_t)at;
+  at = align4(at + (size_t)mesh->num_tris * 3 * index_size);
+  if (edges)
+  {
+    h.edges = (uint32_t)at;
+    at = align4(at + (size_t)mesh->num_edges * 2 * index_size);
+    h.face_edges = (uint32_t)at;
+    at = align4(at + (size_t)mesh->num_tris * 3 * sizeof(uint16_t));
+  }
+  if (planes)
+  {
+    h.planes = (uint32_t)at;
+    at += (size_t)mesh->num_tris * sizeof(plane_t);
+  }
+  if (normals)
+  {
+    h.normals = (uint32_t)at;
+    at += (size_t)mesh->num_verts * sizeof(vec3_t);
+  }
+  if (!buf)
+    return at;
+
+  memset(buf, 0, at);
+  memcpy(buf, &h, sizeof(h));
+  memcpy(buf + h.vertices, mesh->q, (size_t)mesh->num_verts * 3 * sizeof(int16_t));
+  for (int i = 0; i < mesh->num_tris * 3; i++)
+  {
+    int v = mesh->tris[i / 3][i % 3];
+    if (wide)
+      ((uint16_t *)(buf + h.faces))[i] = (uint16_t)v;
+    else
+      buf[h.faces + i] = (uint8_t)v;
+  }
+  for (int i = 0; edges && i < mesh->num_edges * 2; i++)
+  {
+    int v = mesh->edges[i / 2][i % 2];
+    if (wide)
+      ((uint16_t *)(buf + h.edges))[i] = (uint16_t)v;
+    else
+      buf[h.edges + i] = (uint8_t)v;
+  }
+  for (int i = 0; edges && i < mesh->num_tris * 3; i++)
+    ((uint16_t *)(buf + h.face_edges))[i] = (uint16_t)mesh->face_edges[i];
+  for (int t = 0; planes && t < mesh->num_tris; t++)
+  {
+    plane_t p = face_plane(mesh, t);
+    memcpy(buf + h.planes + t * sizeof(plane_t), &p, sizeof(p));
+  }
+  if (normals)
+    vertex_normals(mesh, (vec3_t *)(buf + h.normals));
+  return at;
+}
+
+static int usage(const char *argv0)
+{
+  fprintf(stderr, "usage: %s [-no-planes] [-no-edges] [-normals] [-lod N] -o pack.bin name=model.obj ...\n", argv0);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  const char *out_path = NULL;
+  int planes = 1, edges = 1, normals = 0, lods = 0;
+  const char *names[64], *paths[64];
+  static char lod_names[64][MESH_NAME_LEN];
+  int count = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    char *eq = strchr(argv[i], '=');
+    if (!strcmp(argv[i], "-o") && i + 1 < argc)
+      out_path = argv[++i];
+    else if (!strcmp(argv[i], "-no-planes"))
+      planes = 0;
+    else if (!strcmp(argv[i], "-no-edges"))
+      edges = 0;
+    else if (!strcmp(argv[i], "-normals"))
+      normals = 1;
+    else if (!strcmp(argv[i], "-lod") && i + 1 < argc)
+    {
+      lods = atoi(argv[++i]);
+      if (lods < 0 || lods >= V_MAX_LODS)
+      {
+        fprintf(stderr, "-lod: at most %d levels below the source\n", V_MAX_LODS - 1);
+        return 1;
+      }
+    }
+    else if (eq && count < 64 && eq - argv[i] > 0 && eq - argv[i] < MESH_NAME_LEN)
+    {
+      *eq = '\0';
+      names[count] = argv[i];
+      paths[count++] = eq + 1;
+    }
+    else
+      return usage(argv[0]);
+  }
+  if (!out_path || !count)
+    return usage(argv[0]);
+  if (count * (lods + 1) > 64)
+  {
+    fprintf(stderr, "too many meshes with %d levels each\n", lods);
+    return 1;
+  }
+
+  mesh_data_t meshes[64];
+  int sources = count;
+  for (int i = 0; i < sources; i++)
+  {
+    memset(&meshes[i], 0, sizeof(meshes[i]));
+    if (!build_mesh(paths[i], &meshes[i]))
+      return 1;
+  }
+
+  // Every level decimates the source, not the level before, so the error
+  // does not compound
+  for (int i = 0; i < sources; i++)
+  {
+    for (int k = 1; k <= lods; k++)
+    {
+      if (snprintf(lod_names[count], MESH_NAME_LEN, "%s.%d", names[i], k) >= MESH_NAME_LEN)
+      {
+        fprintf(stderr, "%s.%d: name too long\n", names[i], k);
+        return 1;
+      }
+      names[count] = lod_names[count];
+      mesh_data_t *m = &meshes[count++];
+      decimate(&meshes[i], meshes[i].num_tris >> k, m);
+      optimize(m);
+      printf("%s: %d verts, %d tris (target %d), %d edges\n", names[count - 1], m->num_verts, m->num_tris,
+             meshes[i].num_tris >> k, m->num_edges);
+    }
+  }
+
+  size_t dir_size = sizeof(mesh_pack_header_t) + (size_t)count * sizeof(mesh_pack_entry_t);
+  size_t total = align4(dir_size);
+  mesh_pack_entry_t entries[64];
+  memset(entries, 0, sizeof(entries));
+
+  for (int i = 0; i < count; i++)
+  {
+    strncpy(entries[i].name, names[i], MESH_NAME_LEN);
+    entries[i].offset = (uint32_t)total;
+    entries[i].size = (uint32_t)write_mesh(&meshes[i], planes, edges, normals, NULL);
+    total = align4(total + entries[i].size);
+  }
+
+  uint8_t *pack = calloc(1, total);
+  mesh_pack_header_t h = { MESH_PACK_MAGIC, MESH_FILE_VERSION, (uint16_t)count };
+  memcpy(pack, &h, sizeof(h));
+  memcpy(pack + sizeof(h), entries, (size_t)count * sizeof(mesh_pack_entry_t));
+  for (int i = 0; i < count; i++)
+    write_mesh(&meshes[i], planes, edges, normals, pack + entries[i].offset);
+
+  // Read everything back through the engine's own loader before writing
+  for (int i = 0; i < count; i++)
+  {
+    mesh_t check;
+    if (!mesh_pack_find(pack, total, names[i], &check))
+    {
+      fprintf(stderr, "%s: pack does not validate\n", names[i]);
+      return 1;
+    }
+  }
+
+  FILE *f = fopen(out_path, "wb");
+  if (!f || fwrite(pack, 1, total, f) != total)
+  {
+    perror(out_path);
+    return 1;
+  }
+  fclose(f);
+  printf("%s: %d meshes, %zu bytes\n", out_path, count, total);
+  free(pack);
+  for (int i = 0; i < count; i++)
+  {
+    free(meshes[i].q);
+    free(meshes[i].tris);
+    free(meshes[i].edges);
+    free(meshes[i].face_edges);
+  }
+  return 0;
+}
@@ -0,0 +1,221 @@
+#include "v_display.h"
+#include "v_config.h"
+#include "v_timer.h"
+#include "v_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Host stand-in for the SPI transport. Transfers are queued with a simulated
+// completion time and only land in the panel model once that time has passed,
+// so a CPU write into a buffer that is still "on the wire" shows up as a
+// corrupted frame exactly like it would on the device.
+
+#define HOST_QUEUE_SIZE 64
+
+typedef enum {
+  XFER_WINDOW,
+  XFER_PIXELS,
+  XFER_FRAME_END
+} xfer_kind_t;
+
+typedef struct {
+  xfer_kind_t kind;
+  int x, y, w, h;
+  const uint16_t *pixels;
+  int count;
+  int64_t done_ns;
+} xfer_t;
+
+static xfer_t ring[HOST_QUEUE_SIZE];
+static display_ticket_t queued = 0;
+static display_ticket_t completed = 0;
+static int64_t bus_free_ns = 0;
+static int64_t ns_per_byte = 0;
+
+// Panel model, native RGB565
+static uint16_t gram[V_BUFFER_SIZE];
+static int win_x, win_y, win_w, win_h, win_pos;
+
+static uint16_t presented[V_BUFFER_SIZE];
+static int frame_count = 0;
+static const char *ppm_pattern = NULL;
+
+static int64_t now_ns(void)
+{
+  return timer_get_us() * 1000;
+}
+
+// Through the timer so a simulated clock also pays for the bus
+static void sleep_until_ns(int64_t t)
+{
+  int64_t d = t - now_ns();
+  if (d <= 0) return;
+  timer_sleep_us((d + 999) / 1000);
+}
+
+static void apply(const xfer_t *x)
+{
+  switch (x->kind)
+  {
+    case XFER_WINDOW:
+      win_x = x->x; win_y = x->y; win_w = x->w; win_h = x->h;
+      win_pos = 0;
+      break;
+
+    case XFER_PIXELS:
+      for (int i = 0; i < x->count && win_pos < win_w * win_h; i++, win_pos++)
+      {
+        int px = win_x + win_pos % win_w;
+        int py = win_y + win_pos / win_w;
+        uint16_t c = x->pixels[i];
+        if (px >= 0 && px < V_DISPLAY_WIDTH && py >= 0 && py < V_DISPLAY_HEIGHT)
+          gram[py * V_DISPLAY_WIDTH + px] = (c >> 8) | (c << 8);
+      }
+      break;
+
+    case XFER_FRAME_END:
+      memcpy(presented, gram, sizeof(presented));
+      if (ppm_pattern)
+      {
+        char path[256];
+        snprintf(path, sizeof(path), ppm_pattern, frame_count);
+        host_display_write_ppm(path);
+      }
+      frame_count++;
+      break;
+  }
+}
+
+static void retire_one(void)
+{
+  xfer_t *x = &ring[completed % HOST_QUEUE_SIZE];
+  sleep_until_ns(x->done_ns);
+  apply(x);
+  completed++;
+}
+
+static void retire_due(void)
+{
+  int64_t now = now_ns();
+  while (completed != queued && ring[completed % HOST_QUEUE_SIZE].done_ns <= now)
+    retire_one();
+}
+
+static display_ticket_t push(xfer_t x, int bytes)
+{
+  retire_due();
+  if (queued - completed >= HOST_QUEUE_SIZE)
+    retire_one();
+
+  int64_t start = now_ns();
+  if (bus_free_ns > start) start = bus_free_ns;
+  x.done_ns = start + bytes * ns_per_byte;
+  bus_free_ns = x.done_ns;
+
+  ring[queued % HOST_QUEUE_SIZE] = x;
+  return ++queued;
+}
+
+static bool host_init(void)
+{
+  memset(gram, 0, sizeof(gram));
+  memset(presented, 0, sizeof(presented));
+  frame_count = 0;
+  return true;
+}
+
+static uint16_t *host_alloc(int pixels)
+{
+  uint16_t *buf = (uint16_t*)calloc(pixels, sizeof(uint16_t));
+  if (!buf)
+    fprintf(stderr, "Display: Failed to allocate framebuffer\n");
+  return buf;
+}
+
+static void host_set_window(int x, int y, int w, int h)
+{
+  // CASET + RASET + RAMWR: 3 command bytes, 8 data bytes
+  push((xfer_t){ .kind = XFER_WINDOW, .x = x, .y = y, .w = w, .h = h }, 11);
+}
+
+static display_ticket_t host_queue_pixels(const uint16_t *pixels, int count)
+{
+  return push((xfer_t){ .kind = XFER_PIXELS, .pixels = pixels, .count = count }, count * 2);
+}
+
+static void host_wait(display_ticket_t ticket)
+{
+  while ((int32_t)(ticket - completed) > 0)
+    retire_one();
+}
+
+static void host_frame_end(void)
+{
+  push((xfer_t){ .kind = XFER_FRAME_END }, 0);
+}
+
+static const display_transport_t host_transport = {
+  .init = host_init,
+  .alloc = host_alloc,
+  .set_window = host_set_window,
+  .queue_pixels = host_queue_pixels,
+  .wait = host_wait,
+  .frame_end = host_frame_end,
+};
+
+const display_transport_t *display_default_transport(void)
+{
+  return &host_transport;
+}
+
+void host_display_set_latency(int64_t ns)
+{
+  ns_per_byte = ns;
+}
+
+void host_display_flush(void)
+{
+  host_wait(queued);
+}
+
+void host_display_set_ppm(const char *pattern)
+{
+  ppm_pattern = pattern;
+}
+
+const uint16_t *host_display_frame(void)
+{
+  return presented;
+}
+
+int host_display_frame_count(void)
+{
+  return frame_count;
+}
+
+bool host_display_write_ppm(const char *path)
+{
+  FILE *f = fopen(path, "wb");
+  if (!f)
+  {
+    fprintf(stderr, "Display: Cannot open %s\n", path);
+    return false;
+  }
+
+  fprintf(f, "P6\n%d %d\n255\n", V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT);
+
+  for (int i = 0; i < V_BUFFER_SIZE; i++)
+  {
+    uint16_t c = presented[i];
+    uint8_t rgb[3];
+    rgb[0] = ((c >> 11) & 0x1F) * 255 / 31;
+    rgb[1] = ((c >> 5) & 0x3F) * 255 / 63;
+    rgb[2] = (c & 0x1F) * 255 / 31;
+    fwrite(rgb, 1, 3, f);
+  }
+
+  fclose(f);
+  return true;
+}
@@ -0,0 +1,119 @@
+#include "v_input.h"
+#include "v_host.h"
+#include "v_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stand-in for the button interrupts: events either come from
+// host_input_set(), stamped with the current time, or from a script that
+// host_input_replay() plays back against the engine clock.
+
+static uint8_t held = 0;
+
+static input_event_t *script = NULL;
+static int script_count = 0;
+static int script_next = 0;
+
+void input_backend_init(void)
+{
+  held = 0;
+  script_next = 0;
+}
+
+void host_input_set(uint8_t state)
+{
+  int64_t now = timer_get_us();
+  for (int bit = 0; bit < 8; bit++)
+  {
+    uint8_t b = (uint8_t)(1 << bit);
+    if ((state ^ held) & b)
+      input_push_event(b, (state & b) != 0, now);
+  }
+  held = state;
+}
+
+static bool parse_button(const char *name, uint8_t *button)
+{
+  static const char *const names[] = { "up", "down", "left", "right", "a", "b" };
+  for (int i = 0; i < 6; i++)
+  {
+    if (!strcmp(name, names[i]))
+    {
+      *button = (uint8_t)(1 << i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool host_input_load(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+    return false;
+
+  int capacity = 0;
+  script_count = 0;
+  script_next = 0;
+
+  char line[128];
+  int line_no = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f))
+  {
+    line_no++;
+    double ms;
+    char name[16], action[16];
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = 0;
+    int fields = sscanf(line, "%lf %15s %15s", &ms, name, action);
+    if (fields <= 0)
+      continue;
+
+    input_event_t ev = { .time_us = (int64_t)(ms * 1000.0) };
+    if (fields != 3 || !parse_button(name, &ev.button) ||
+        (strcmp(action, "press") && strcmp(action, "release")))
+    {
+      fprintf(stderr, "%s:%d: expected <ms> up|down|left|right|a|b press|release\n", path, line_no);
+      ok = false;
+      break;
+    }
+    if (script_count && ev.time_us < script[script_count - 1].time_us)
+    {
+      fprintf(stderr, "%s:%d: time goes backwards\n", path, line_no);
+      ok = false;
+      break;
+    }
+    ev.pressed = !strcmp(action, "press");
+
+    if (script_count == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 64;
+      script = realloc(script, capacity * sizeof(*script));
+    }
+    script[script_count++] = ev;
+  }
+  fclose(f);
+
+  if (!ok)
+    script_count = 0;
+  return ok;
+}
+
+int host_input_replay(int64_t now_us, input_event_t *out, int max_out)
+{
+  int n = 0;
+  while (script_next < script_count && script[script_next].time_us <= now_us)
+  {
+    const input_event_t *ev = &script[script_next++];
+    held = ev->pressed ? (held | ev->button) : (held & ~ev->button);
+    input_push_event(ev->button, ev->pressed, ev->time_us);
+    if (out && n < max_out)
+      out[n] = *ev;
+    n++;
+  }
+  return n;
+}
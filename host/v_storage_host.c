@@ -0,0 +1,61 @@
+#define _POSIX_C_SOURCE 200809L
+#include "v_storage.h"
+#include "v_host.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+  char name[32];
+  const void *data;
+  size_t size;
+} mapping_t;
+
+static mapping_t maps[V_STORAGE_MAX_MAPS];
+static const char *storage_dir = ".";
+
+void host_storage_set_dir(const char *dir)
+{
+  storage_dir = dir ? dir : ".";
+}
+
+const void *storage_map(const char *name, size_t *size)
+{
+  mapping_t *slot = NULL;
+  for(int i = 0; i < V_STORAGE_MAX_MAPS; i++)
+  {
+    if(maps[i].data && !strcmp(maps[i].name, name))
+    {
+      *size = maps[i].size;
+      return maps[i].data;
+    }
+    if(!maps[i].data && !slot)
+      slot = &maps[i];
+  }
+  if(!slot || strlen(name) >= sizeof(slot->name))
+    return NULL;
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s.bin", storage_dir, name);
+  int fd = open(path, O_RDONLY);
+  if(fd < 0)
+    return NULL;
+
+  struct stat st;
+  void *data = MAP_FAILED;
+  if(fstat(fd, &st) == 0 && st.st_size > 0)
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED)
+    return NULL;
+
+  strcpy(slot->name, name);
+  slot->data = data;
+  slot->size = (size_t)st.st_size;
+  *size = slot->size;
+  return data;
+}
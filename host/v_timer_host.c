@@ -0,0 +1,73 @@
+#define _POSIX_C_SOURCE 199309L
+#include "v_timer.h"
+#include "v_host.h"
+#include <time.h>
+
+static int64_t boot_us = 0;
+
+// With the simulated clock time only moves when the engine sleeps or the
+// runner advances it, so a run does not depend on how fast the host is
+static bool simulated = false;
+static int64_t simulated_us = 0;
+
+static int64_t monotonic_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void timer_init(void)
+{
+  boot_us = monotonic_us();
+  simulated_us = 0;
+}
+
+int64_t timer_get_us(void)
+{
+  if (simulated)
+    return simulated_us;
+  return monotonic_us() - boot_us;
+}
+
+uint32_t timer_get_cycles(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t timer_cycles_per_us(void)
+{
+  return 1000;
+}
+
+void timer_sleep_us(int64_t us)
+{
+  if (us <= 0)
+    return;
+  if (simulated)
+  {
+    simulated_us += us;
+    return;
+  }
+
+  struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+  nanosleep(&ts, NULL);
+}
+
+void timer_yield(void)
+{
+  // No scheduler tick to give up on the host
+}
+
+void host_timer_set_simulated(bool on)
+{
+  simulated = on;
+  simulated_us = 0;
+}
+
+void host_timer_advance(int64_t us)
+{
+  simulated_us += us;
+}
@@ -1,19 +1,58 @@
 #include "game.h"
+#include <stdio.h>
+#include "v_camera.h"
 #include "v_graphics.h"
 #include "v_input.h"
 #include "v_matrix.h"
+#include "v_transform.h"
 #include "v_vector.h"
 #include "v_colors.h"
 #include "v_config.h"
 #include "v_primitives.h"
 #include "v_entity.h"
+#include "v_render.h"
+#include "v_meshfile.h"
+#include "v_profile.h"
+#include "v_storage.h"
 
-#define MAX_ENTITIES 10
-entity_t entities[MAX_ENTITIES];
+static entity_id_t ship;
+static entity_id_t spinner;
 
-vec3_t camera = {0, 0, INT_TO_F16(6)};
+// 40 angle units is about 56 degrees, a focal length of about 150 pixels
+#define CAMERA_FOV 40
 
-uint16_t apply_lighting(uint16_t base_color, fix16_t normal_z)
+static camera_t camera;
+static vec3_t prev_camera_pos;
+static projection_t proj; // from the camera's field of view, fixed once loaded
+
+// Simplified landers from the pack ("lander.1", ... as void_obj2mesh -lod
+// writes them). Each level takes over once the lander's radius on screen
+// drops below half of where the level before took over.
+#define LOD_FIRST_RADIUS_PX 24
+
+static mesh_t lander_levels[V_MAX_LODS];
+static mesh_lod_t lander_lod;
+
+static void load_lander_lod(const void *pack, size_t pack_size)
+{
+  lander_lod = (mesh_lod_t){ .levels = { &lander_levels[0] }, .num_levels = 1 };
+  fix16_t z = f16_div(f16_mul(proj.focal, lander_levels[0].radius), INT_TO_F16(LOD_FIRST_RADIUS_PX));
+  for(int k = 1; k < V_MAX_LODS; k++)
+  {
+    char name[MESH_NAME_LEN];
+    snprintf(name, sizeof(name), "lander.%d", k);
+    if(!mesh_pack_find(pack, pack_size, name, &lander_levels[k]))
+      break;
+    lander_lod.levels[k] = &lander_levels[k];
+    lander_lod.switch_z[k] = z;
+    lander_lod.num_levels++;
+    z *= 2;
+  }
+  lander_lod.hysteresis = lander_lod.switch_z[1] / 8;
+}
+
+// Headlight along the view axis with a quarter ambient
+static fix16_t light_intensity(fix16_t normal_z)
 {
   int intensity = normal_z;
   if (intensity < 0)
@@ -22,7 +61,17 @@ uint16_t apply_lighting(uint16_t base_color, fix16_t normal_z)
   intensity += F16_ONE / 4;
   if (intensity > F16_ONE)
     intensity = F16_ONE;
+  return intensity;
+}
 
+uint16_t apply_lighting(uint16_t base_color, fix16_t normal_z)
+{
+  int intensity = light_intensity(normal_z);
+
+#if V_INDEXED_COLOR
+  // Colours are ramps of shades in the palette, lighting just picks one
+  return V_RAMP_SHADE(base_color, (intensity * (V_RAMP_SHADES - 1) + F16_HALF) >> 16);
+#else
   int r = (base_color >> 11) & 0x1F;
   int g = (base_color >> 5) & 0x3F;
   int b = base_color & 0x1F;
@@ -39,150 +88,173 @@ uint16_t apply_lighting(uint16_t base_color, fix16_t normal_z)
   }
 
   return (r << 11) | (g << 5) | b;
+#endif
+}
+
+static uint16_t shade_face(uint16_t color, vec3_t normal)
+{
+  return apply_lighting(color, normal.z);
+}
+
+// Meshes with vertex normals, the ramp in gfx_fill_triangle_shaded does the rest
+static fix16_t light_vertex(vec3_t normal)
+{
+  return light_intensity(normal.z);
 }
 
 void game_load(void)
 {
-  for(int i = 0; i < MAX_ENTITIES; i++)
-    entities[i].active = false;
-
-  entities[0].active = true;
-  entities[0].mesh = &MESH_PYRAMID;
-  entities[0].pos = (vec3_t){0, INT_TO_F16(2), 0};
-  entities[0].color = V_WHITE;
-
-  entities[1].active = true;
-  entities[1].mesh = &MESH_CUBE;
-  entities[1].pos = (vec3_t){0, INT_TO_F16(-2), 0};
-  entities[1].color = V_CYAN;
+  entity_clear();
+  camera_init(&camera, (vec3_t){0, 0, INT_TO_F16(-6)}, CAMERA_FOV, FLT_TO_F16(0.5f));
+  camera_projection(&camera, V_DISPLAY_WIDTH, V_DISPLAY_HEIGHT, &proj);
+  prev_camera_pos = camera.pos;
+
+  // A "lander" mesh in the assets pack replaces the built-in pyramid
+  const mesh_t *ship_mesh = &MESH_PYRAMID;
+  size_t pack_size;
+  const void *pack = storage_map("assets", &pack_size);
+  bool lander = pack && mesh_pack_find(pack, pack_size, "lander", &lander_levels[0]);
+  if(lander)
+  {
+    ship_mesh = &lander_levels[0];
+    load_lander_lod(pack, pack_size);
+  }
+
+  ship = entity_create(ship_mesh, (vec3_t){0, INT_TO_F16(2), 0}, V_WHITE);
+  if(lander && lander_lod.num_levels > 1)
+    entity_set_lod(ship, &lander_lod);
+  spinner = entity_create(&MESH_CUBE, (vec3_t){0, INT_TO_F16(-2), 0}, V_CYAN);
+  entity_set_orient(spinner, quat_identity());
 }
 
-void game_update(float dt)
+void game_update(fix16_t dt)
 {
+  // A tap that started and ended since the last tick still counts once
   uint8_t k = input_get();
-  float rot_speed = 200.0f * dt;
+  input_event_t ev;
+  while(input_poll_event(&ev))
+  {
+    if(ev.pressed)
+      k |= ev.button;
+  }
+  prev_camera_pos = camera.pos;
 
-  entities[1].rot.y += rot_speed;
-  if (entities[1].rot.y >= 256.0f)
-    entities[1].rot.y -= 256.0f;
+  // 200 angle units per second
+  quat_t *orient = &entities.orient[entity_index(spinner)];
+  *orient = quat_rotate(*orient, (vec3_t){0, F16_ONE, 0}, f16_mul(INT_TO_F16(200), dt));
 
+  vec3_t *pos = &entities.pos[entity_index(ship)];
+  fix16_t ship_speed = f16_mul(INT_TO_F16(2), dt);
   if(k & INPUT_LEFT)
-    entities[0].pos.x = f16_sub(entities[0].pos.x, FLT_TO_F16(2.0f * dt));
+    pos->x = f16_sub(pos->x, ship_speed);
   if(k & INPUT_RIGHT)
-    entities[0].pos.x = f16_add(entities[0].pos.x, FLT_TO_F16(2.0f * dt));
+    pos->x = f16_add(pos->x, ship_speed);
   if(k & INPUT_UP)
-    entities[0].pos.y = f16_sub(entities[0].pos.y, FLT_TO_F16(2.0f * dt));
+    pos->y = f16_sub(pos->y, ship_speed);
   if(k & INPUT_DOWN)
-    entities[0].pos.y = f16_add(entities[0].pos.y, FLT_TO_F16(2.0f * dt));
+    pos->y = f16_add(pos->y, ship_speed);
 
-  fix16_t move_speed = FLT_TO_F16(4.0f * dt);
+  fix16_t move_speed = f16_mul(INT_TO_F16(4), dt);
   if(k & INPUT_A)
-    camera.z = f16_sub(camera.z, move_speed);
+    camera_move(&camera, 0, 0, move_speed);
   if(k & INPUT_B)
-    camera.z = f16_add(camera.z, move_speed);
+    camera_move(&camera, 0, 0, -move_speed);
+}
+
+// View-space depth of an entity's origin
+static fix16_t view_depth(const mat34_t *world_to_view, vec3_t pos)
+{
+  const fix16_t *row = world_to_view->m[2];
+  return f16_add(vec3_dot((vec3_t){row[0], row[1], row[2]}, pos), row[3]);
 }
 
-void sort_entities(entity_t **list, int count)
+// Dense entity indices, farthest first. Each depth is worked out once and
+// moves with its index.
+void sort_entities(uint16_t *list, int count, const mat34_t *world_to_view)
 {
+  static fix16_t depth[V_MAX_ENTITIES];
+  for(int i = 0; i < count; i++)
+    depth[i] = view_depth(world_to_view, entities.pos[list[i]]);
+
   for(int i = 1; i < count; i++)
   {
-    entity_t *key = list[i];
-    fix16_t key_z = f16_add(key->pos.z, camera.z);
+    uint16_t key = list[i];
+    fix16_t key_z = depth[i];
 
     int j = i - 1;
-    while(j >= 0)
+    while(j >= 0 && depth[j] < key_z)
     {
-      fix16_t j_z = f16_add(list[j]->pos.z, camera.z);
-      if (j_z < key_z)
-      {
-        list[j+ 1] = list[j];
-        j--;
-      }
-      else
-      {
-        break;
-      }
+      list[j + 1] = list[j];
+      depth[j + 1] = depth[j];
+      j--;
     }
     list[j + 1] = key;
+    depth[j + 1] = key_z;
   }
 }
 
 void game_draw(render_mode_t mode)
 {
+  PROFILE_BEGIN(PROF_CLEAR);
   gfx_clear(V_BLACK);
+#if V_DEPTH_BUFFER
+  gfx_depth_clear();
+#endif
+  PROFILE_END(PROF_CLEAR);
 
-  entity_t *draw_list[MAX_ENTITIES];
-  int draw_count = 0;
-  for(int i = 0; i < MAX_ENTITIES; i++)
-  {
-    if(entities[i].active)
-      draw_list[draw_count++] = &entities[i];
-  }
+  render_view_t view;
+  render_view_init(&view, &proj, shade_face);
+  view.light = light_vertex;
+  view.mode = mode;
 
-  sort_entities(draw_list, draw_count);
+  // Everything is drawn between the last two ticks
+  fix16_t alpha = engine_get_alpha();
+  camera_t eye = camera;
+  eye.pos = vec3_add(prev_camera_pos, vec3_mul(vec3_sub(camera.pos, prev_camera_pos), alpha));
 
-    int cx = V_DISPLAY_WIDTH/2;
-    int cy = V_DISPLAY_HEIGHT/2;
-    fix16_t fov = INT_TO_F16(150);
-    const fix16_t near_z = FLT_TO_F16(0.5f);
-    // Transform and Project
-    for(int i = 0; i < num_verts; i++) 
-    {
-        t_verts[i] = mat4_mul_vec3(mat_rot, active_mesh->vertices[i]);
-        t_verts[i].z = f16_add(t_verts[i].z, camera.z);
-        
-        if(t_verts[i].z < near_z) 
-          t_verts[i].z = near_z;
-        
-        p_verts[i].x = f16_add(f16_mul(t_verts[i].x, f16_div(fov, t_verts[i].z)), INT_TO_F16(cx));
-        p_verts[i].y = f16_add(f16_mul(t_verts[i].y, f16_div(fov, t_verts[i].z)), INT_TO_F16(cy));
-    }
+  // The view is built once per frame, every entity's model matrix is folded
+  // into it once, so each vertex takes a single product to view space.
+  // Only entities in grid cells the frustum reaches are sorted and drawn.
+  mat34_t world_to_view;
+  camera_view(&eye, &world_to_view);
+  static uint16_t draw_list[V_MAX_ENTITIES];
+  entity_sync_grid();
+  int draw_count = entity_query_frustum(&view.frustum, &world_to_view, draw_list, V_MAX_ENTITIES);
+#if V_RENDER_CACHE_BYTES
+  render_cache_begin(&view, &world_to_view);
+#endif
 
-    for(int i = 0; i < num_verts; i++)
-    {
-      vec3_t p = mat4_mul_vec3(mat_rot, mesh->vertices[i]);
-      p = vec3_add(p , ent->pos);
-      p.z = f16_add(p.z, camera.z);
-
-      if(p.z < near_plane)
-      {
-        v_culled[i] = true;
-        p.z = near_plane;
-      }
-      else
-      {
-        v_culled[i] = false;
-      }
-
-      t_verts[i] = p;
-      p_verts[i].x = f16_add(f16_mul(p.x, f16_div(fov, p.z)), INT_TO_F16(cx));
-      p_verts[i].y = f16_add(f16_mul(p.y, f16_div(fov, p.z)), INT_TO_F16(cy));
-    }
+#if !V_DEPTH_BUFFER
+  // Without a depth buffer whole entities are drawn back to front
+  sort_entities(draw_list, draw_count, &world_to_view);
+#endif
 
-    for(int i = 0; i < mesh->num_faces; i++)
-    {
-      int i1 = mesh->faces[i][0];
-      int i2 = mesh->faces[i][1];
-      int i3 = mesh->faces[i][2];
-
-      if(v_culled[i1] || v_culled[i2] || v_culled[i3]) 
-        continue;
-
-      vec3_t normal = vec3_normal(t_verts[i1], t_verts[i2], t_verts[i3]);
-
-      if(normal.z < 0)
-      {
-        int x1 = F16_TO_INT(p_verts[i1].x);
-        int y1 = F16_TO_INT(p_verts[i1].y);
-        int x2 = F16_TO_INT(p_verts[i2].x);
-        int y2 = F16_TO_INT(p_verts[i2].y);
-        int x3 = F16_TO_INT(p_verts[i3].x);
-        int y3 = F16_TO_INT(p_verts[i3].y);
-
-        uint16_t shaded_color = apply_lighting(ent->color, normal.z);
-        gfx_fill_triangle(x1, y1, x2, y2, x3, y3, shaded_color);
-      }
-    }
+  for(int e = 0; e < draw_count; e++)
+  {
+    int i = draw_list[e];
+    vec3_t pos = entity_lerp_pos(i, alpha);
+    vec3_t rot = entity_lerp_rot(i, alpha);
+    quat_t orient = entity_has_orient(i) ? entity_lerp_orient(i, alpha) : (quat_t){ 0, 0, 0, 0 };
+
+#if V_RENDER_CACHE_BYTES
+    // Entities that stayed put since the last frame are redrawn as they were
+    const mesh_t *mesh = entities.lod[i] ? entities.lod[i]->levels[entities.lod_level[i]] : entities.mesh[i];
+    if(render_cache_replay(&view, entities.id[i], mesh, pos, rot, orient, entities.color[i]))
+      continue;
+#endif
+
+    mat34_t model, model_view;
+    if(entity_has_orient(i))
+      mat34_from_quat(&model, orient, F16_ONE, pos);
+    else
+      mat34_compose(&model, rot, F16_ONE, pos);
+    mat34_mul(&model_view, &world_to_view, &model);
+
+    // The level of detail follows the camera-space depth in model_view.m[2][3]
+    if(entities.lod[i])
+      render_mesh_lod(&view, entities.lod[i], &entities.lod_level[i], &model_view, entities.color[i]);
+    else
+      render_mesh(&view, entities.mesh[i], &model_view, entities.color[i]);
   }
 }
 